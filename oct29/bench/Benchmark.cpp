@@ -0,0 +1,598 @@
+// Compares the counting engines stage by stage on the books and on
+// synthetic Zipf-distributed corpora.
+//
+// Engines:
+//   hash  the corpus library: flat hash table, counting-sort ranking
+//   map   std::map counting and a std::multimap ranking (the original ZipF)
+//   sort  sort every token, then count runs (the original ZipF2)
+//   radix SortCounting: radix sort of packed tokens that counts the runs as it sorts
+//   wide  std::map of std::wstring words (the original Arabic tool)
+//
+// Stages: read (map the file and fault every page in), tokenize (a pass
+// that only finds the words), then per engine count (its own tokenizing
+// and counting), rank and write. Every engine writes the same "rank freq
+// word" table, and the tables are compared with the first engine's.
+// Throughput (MB/s, tokens/s) covers count, rank and write; peak memory
+// includes the mapped input.
+
+#include "../include/Counting.h"
+#include "../include/FrequencyWriter.h"
+#include "../include/MappedFile.h"
+#include "../include/Profile.h"
+#include "../include/RankIndex.h"
+#include "../include/WordEngine.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using corpus::Script;
+using corpus::WordCounter;
+
+double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Peak resident set in kB since the last resetPeakMemory (VmHWM).
+std::uint64_t peakMemory() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0) {
+            return std::strtoull(line.c_str() + 6, nullptr, 10);
+        }
+    }
+    return 0;
+}
+
+// Resets VmHWM to the current RSS, so each engine gets its own peak.
+void resetPeakMemory() {
+    std::ofstream clear("/proc/self/clear_refs");
+    clear << "5";
+}
+
+// Bijective base-26 names: the most frequent ranks get the shortest words,
+// and the letters are shifted per position so words do not look sequential.
+std::string syntheticWord(std::uint64_t rank) {
+    std::string word;
+    std::size_t position = 0;
+    while (rank > 0) {
+        --rank;
+        word.push_back(static_cast<char>('a' + (rank % 26 + position * 7) % 26));
+        rank /= 26;
+        ++position;
+    }
+    return word;
+}
+
+std::uint64_t nextRandom(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Zipf(n, s) ranks by rejection-inversion (Hormann and Derflinger), in
+// constant time per sample and without a table of the n probabilities.
+class ZipfSampler {
+public:
+    ZipfSampler(std::uint64_t n, double exponent) : n_(static_cast<double>(n)), s_(exponent) {
+        integralOne_ = integral(1.5) - 1.0;
+        integralN_ = integral(n_ + 0.5);
+        threshold_ = 2.0 - inverseIntegral(integral(2.5) - density(2.0));
+    }
+
+    std::uint64_t operator()(std::uint64_t& state) const {
+        for (;;) {
+            double uniform = static_cast<double>(nextRandom(state) >> 11) * 0x1.0p-53;
+            double u = integralN_ + uniform * (integralOne_ - integralN_);
+            double x = inverseIntegral(u);
+            double k = std::floor(x + 0.5);
+            k = std::min(std::max(k, 1.0), n_);
+            if (k - x <= threshold_ || u >= integral(k + 0.5) - density(k)) {
+                return static_cast<std::uint64_t>(k);
+            }
+        }
+    }
+
+private:
+    static double logRatio(double x) { return std::fabs(x) > 1e-8 ? std::log1p(x) / x : 1.0 - x * (0.5 - x / 3.0); }
+    static double expRatio(double x) { return std::fabs(x) > 1e-8 ? std::expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x / 3.0); }
+
+    double density(double x) const { return std::exp(-s_ * std::log(x)); }
+    double integral(double x) const {
+        double logX = std::log(x);
+        return expRatio((1.0 - s_) * logX) * logX;
+    }
+    double inverseIntegral(double x) const {
+        double t = std::max(x * (1.0 - s_), -1.0);
+        return std::exp(logRatio(t) * x);
+    }
+
+    double n_;
+    double s_;
+    double integralOne_;
+    double integralN_;
+    double threshold_;
+};
+
+// Writes bytes of Zipf-distributed words (16 per line) to a file, unless
+// a corpus of that size was already generated there.
+bool generateZipfCorpus(const std::string& fileName, std::uint64_t bytes, double exponent) {
+    std::error_code error;
+    if (std::filesystem::exists(fileName, error) && std::filesystem::file_size(fileName, error) >= bytes) {
+        return true;
+    }
+    ZipfSampler sample(std::uint64_t(1) << 22, exponent);
+    std::uint64_t state = 20241029;
+    corpus::BufferedWriter out(fileName);
+    std::uint64_t written = 0;
+    std::uint64_t words = 0;
+    while (written < bytes && out.isOpen()) {
+        std::string word = syntheticWord(sample(state));
+        out.write(word);
+        out.put(++words % 16 == 0 ? '\n' : ' ');
+        written += word.size() + 1;
+    }
+    return out.close();
+}
+
+// Arabic text is mostly two-byte letters with a 0xD8-0xDB lead byte.
+Script detectScript(std::string_view text) {
+    std::size_t arabic = 0;
+    std::size_t ascii = 0;
+    for (unsigned char c : text.substr(0, 1 << 16)) {
+        arabic += c >= 0xD8 && c <= 0xDB;
+        ascii += corpus::isAsciiLetter(c);
+    }
+    return arabic > ascii ? Script::Arabic : Script::Ascii;
+}
+
+std::wstring decodeUtf8(std::string_view word) {
+    std::wstring wide;
+    for (std::size_t i = 0; i < word.size();) {
+        unsigned char c = static_cast<unsigned char>(word[i]);
+        std::size_t length = c < 0x80 ? 1 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+        std::uint32_t code = length == 1 ? c : c & (0x3F >> (length - 1));
+        for (std::size_t j = 1; j < length && i + j < word.size(); ++j) {
+            code = (code << 6) | (static_cast<unsigned char>(word[i + j]) & 0x3F);
+        }
+        wide.push_back(static_cast<wchar_t>(code));
+        i += length;
+    }
+    return wide;
+}
+
+std::string encodeUtf8(std::wstring_view word) {
+    std::string bytes;
+    for (wchar_t w : word) {
+        auto code = static_cast<std::uint32_t>(w);
+        if (code < 0x80) {
+            bytes.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            bytes.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            bytes.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            bytes.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            bytes.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            bytes.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            bytes.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            bytes.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            bytes.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            bytes.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+    return bytes;
+}
+
+// Stage callbacks of one engine; state lives in the closures between stages.
+struct Engine {
+    std::function<void()> count;
+    std::function<void()> rank;
+    std::function<bool(const std::string&)> write;
+    std::function<std::size_t()> vocabulary;
+};
+
+Engine hashEngine(std::string_view text, Script script, unsigned threads) {
+    auto counter = std::make_shared<WordCounter>();
+    auto ranks = std::make_shared<corpus::RankIndex>();
+    return {[=] { *counter = corpus::countWords(text, script, threads); },
+            [=] { *ranks = corpus::RankIndex(*counter); },
+            [=](const std::string& file) { return corpus::writeFrequencies(*ranks, file); },
+            [=] { return counter->size(); }};
+}
+
+Engine mapEngine(std::string_view text, Script script) {
+    auto counts = std::make_shared<std::map<std::string, std::uint64_t>>();
+    auto sorted = std::make_shared<std::multimap<std::uint64_t, std::string, std::greater<>>>();
+    return {[=] {
+                corpus::forEachWord(script, text, [&](std::string_view word) { ++(*counts)[std::string(word)]; });
+            },
+            [=] {
+                for (const auto& [word, count] : *counts) {
+                    sorted->emplace(count, word);
+                }
+            },
+            [=](const std::string& file) {
+                std::vector<WordCounter::Entry> ranked;
+                ranked.reserve(sorted->size());
+                for (const auto& [count, word] : *sorted) {
+                    ranked.push_back({word, count});
+                }
+                return corpus::writeFrequencies(ranked, file);
+            },
+            [=] { return counts->size(); }};
+}
+
+Engine sortEngine(std::string_view text, Script script) {
+    // the tokenizer's views only live during the callback, so tokens are copied
+    auto tokens = std::make_shared<std::vector<std::string>>();
+    auto ranked = std::make_shared<std::vector<WordCounter::Entry>>();
+    return {[=] {
+                corpus::forEachWord(script, text, [&](std::string_view word) { tokens->emplace_back(word); });
+                std::sort(tokens->begin(), tokens->end());
+                for (std::size_t i = 0; i < tokens->size();) {
+                    std::size_t j = i + 1;
+                    while (j < tokens->size() && (*tokens)[j] == (*tokens)[i]) {
+                        ++j;
+                    }
+                    ranked->push_back({(*tokens)[i], j - i});
+                    i = j;
+                }
+            },
+            [=] {
+                std::stable_sort(ranked->begin(), ranked->end(),
+                                 [](const auto& a, const auto& b) { return a.count > b.count; });
+            },
+            [=](const std::string& file) { return corpus::writeFrequencies(*ranked, file); },
+            [=] { return ranked->size(); }};
+}
+
+Engine radixEngine(std::string_view text, Script script, unsigned threads) {
+    auto counts = std::make_shared<corpus::SortCounting>(threads, text.size());
+    auto ranked = std::make_shared<std::vector<WordCounter::Entry>>();
+    return {[=] {
+                corpus::forEachWord(script, text, [&](std::string_view word) { counts->add(word); });
+                counts->finish();
+            },
+            [=] {
+                // the runs come out in byte order, so a stable sort by count breaks ties alphabetically
+                ranked->reserve(counts->size());
+                counts->forEach([&](std::string_view word, std::uint64_t count) { ranked->push_back({word, count}); });
+                std::stable_sort(ranked->begin(), ranked->end(),
+                                 [](const auto& a, const auto& b) { return a.count > b.count; });
+            },
+            [=](const std::string& file) { return corpus::writeFrequencies(*ranked, file); },
+            [=] { return counts->size(); }};
+}
+
+Engine wideEngine(std::string_view text, Script script) {
+    auto counts = std::make_shared<std::map<std::wstring, std::uint64_t>>();
+    auto sorted = std::make_shared<std::multimap<std::uint64_t, std::wstring, std::greater<>>>();
+    return {[=] {
+                corpus::forEachWord(script, text, [&](std::string_view word) { ++(*counts)[decodeUtf8(word)]; });
+            },
+            [=] {
+                for (const auto& [word, count] : *counts) {
+                    sorted->emplace(count, word);
+                }
+            },
+            [=](const std::string& file) {
+                std::vector<std::string> words;
+                words.reserve(sorted->size());
+                std::vector<WordCounter::Entry> ranked;
+                ranked.reserve(sorted->size());
+                for (const auto& [count, word] : *sorted) {
+                    words.push_back(encodeUtf8(word));
+                    ranked.push_back({words.back(), count});
+                }
+                return corpus::writeFrequencies(ranked, file);
+            },
+            [=] { return counts->size(); }};
+}
+
+bool sameContents(const std::string& a, const std::string& b) {
+    corpus::MappedFile first(a);
+    corpus::MappedFile second(b);
+    return first.isOpen() && second.isOpen() && first.view() == second.view();
+}
+
+struct Settings {
+    std::vector<std::string> books;
+    std::vector<std::uint64_t> sizes;
+    std::vector<std::string> engines{"hash", "map", "sort", "radix", "wide"};
+    unsigned threads = 1;
+    double exponent = 1.1;
+    std::string workDir = ".";
+    std::string csvFile;
+};
+
+struct Result {
+    std::string corpus;
+    std::string engine;
+    std::uint64_t bytes = 0;
+    std::uint64_t tokens = 0;
+    std::size_t vocabulary = 0;
+    unsigned threads = 1;
+    double read = 0;
+    double tokenize = 0;
+    double count = 0;
+    double rank = 0;
+    double write = 0;
+    std::uint64_t peakKb = 0;
+    double allocationsPerToken = 0;
+    bool matches = true;
+
+    double total() const { return read + tokenize + count + rank + write; }
+    double megabytesPerSecond() const { return count > 0 ? bytes / 1e6 / ((count + rank + write) / 1e3) : 0; }
+    double tokensPerSecond() const { return count > 0 ? tokens / ((count + rank + write) / 1e3) : 0; }
+};
+
+// Reading every page through a volatile keeps the read stage from being optimized away.
+volatile char pageSink;
+
+void benchCorpus(const std::string& name, const std::string& path, const Settings& settings,
+                 std::vector<Result>& results) {
+    Clock::time_point start = Clock::now();
+    corpus::MappedFile file(path);
+    if (!file.isOpen()) {
+        return;
+    }
+    for (std::size_t i = 0; i < file.size(); i += 4096) {
+        pageSink = file.data()[i];
+    }
+    double read = millisecondsSince(start);
+    std::string_view text = file.view();
+    Script script = detectScript(text);
+
+    start = Clock::now();
+    std::uint64_t tokens = 0;
+    corpus::forEachWord(script, text, [&](std::string_view) { ++tokens; });
+    double tokenize = millisecondsSince(start);
+
+    std::string reference;
+    for (const std::string& engineName : settings.engines) {
+        Engine engine = engineName == "map"    ? mapEngine(text, script)
+                      : engineName == "sort"   ? sortEngine(text, script)
+                      : engineName == "radix"  ? radixEngine(text, script, settings.threads)
+                      : engineName == "wide"   ? wideEngine(text, script)
+                                               : hashEngine(text, script, settings.threads);
+        Result result;
+        result.corpus = name;
+        result.engine = engineName;
+        result.bytes = file.size();
+        result.tokens = tokens;
+        result.threads = engineName == "hash" || engineName == "radix" ? settings.threads : 1;
+        result.read = read;
+        result.tokenize = tokenize;
+
+        resetPeakMemory();
+        std::uint64_t allocationsBefore = corpus::allocationCount();
+        start = Clock::now();
+        engine.count();
+        result.count = millisecondsSince(start);
+        start = Clock::now();
+        engine.rank();
+        result.rank = millisecondsSince(start);
+        std::string output = (std::filesystem::path(settings.workDir) / ("bench-" + engineName + ".out")).string();
+        start = Clock::now();
+        engine.write(output);
+        result.write = millisecondsSince(start);
+        result.peakKb = peakMemory();
+        result.allocationsPerToken =
+            tokens > 0 ? double(corpus::allocationCount() - allocationsBefore) / tokens : 0;
+        result.vocabulary = engine.vocabulary();
+
+        if (reference.empty()) {
+            reference = output;
+        } else {
+            result.matches = sameContents(reference, output);
+            std::remove(output.c_str());
+        }
+        results.push_back(result);
+        std::cerr << "  " << name << " " << engineName << ": " << std::fixed << std::setprecision(1)
+                  << result.count + result.rank + result.write << " ms" << std::endl;
+    }
+    if (!reference.empty()) {
+        std::remove(reference.c_str());
+    }
+}
+
+void printTable(const std::vector<Result>& results) {
+    std::cout << std::left << std::setw(22) << "corpus" << std::setw(6) << "engine" << std::right << std::setw(10)
+              << "read ms" << std::setw(11) << "tokenize" << std::setw(10) << "count" << std::setw(10) << "rank"
+              << std::setw(10) << "write" << std::setw(10) << "MB/s" << std::setw(12) << "Mtokens/s" << std::setw(12)
+              << "peak MB" << std::setw(12) << "allocs/tok" << std::setw(7) << "same" << "\n";
+    for (const Result& r : results) {
+        std::cout << std::left << std::setw(22) << r.corpus << std::setw(6) << r.engine << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(10) << r.read << std::setw(11) << r.tokenize << std::setw(10)
+                  << r.count << std::setw(10) << r.rank << std::setw(10) << r.write << std::setw(10)
+                  << r.megabytesPerSecond() << std::setprecision(2) << std::setw(12) << r.tokensPerSecond() / 1e6
+                  << std::setprecision(1) << std::setw(12) << r.peakKb / 1024.0 << std::setprecision(3)
+                  << std::setw(12) << r.allocationsPerToken << std::setw(7) << (r.matches ? "yes" : "NO") << "\n";
+    }
+    std::cout.flush();
+}
+
+bool writeCsv(const std::vector<Result>& results, const std::string& fileName) {
+    std::ofstream out(fileName);
+    if (!out) {
+        std::cerr << "Error opening file: " << fileName << std::endl;
+        return false;
+    }
+    out << "corpus,engine,threads,bytes,tokens,vocabulary,read_ms,tokenize_ms,count_ms,rank_ms,write_ms,total_ms,"
+           "mb_per_s,tokens_per_s,peak_rss_kb,allocations_per_token,matches\n";
+    out << std::fixed;
+    for (const Result& r : results) {
+        out << r.corpus << ',' << r.engine << ',' << r.threads << ',' << r.bytes << ',' << r.tokens << ','
+            << r.vocabulary << ',' << std::setprecision(3) << r.read << ',' << r.tokenize << ',' << r.count << ','
+            << r.rank << ',' << r.write << ',' << r.total() << ',' << r.megabytesPerSecond() << ','
+            << std::setprecision(0) << r.tokensPerSecond() << ',' << r.peakKb << ',' << std::setprecision(4)
+            << r.allocationsPerToken << ',' << (r.matches ? 1 : 0) << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+// Sizes like 1M, 256K or 10G (powers of 1000, as throughput is reported in MB).
+bool parseSize(std::string_view text, std::uint64_t& bytes) {
+    std::uint64_t scale = 1;
+    if (!text.empty()) {
+        switch (text.back()) {
+        case 'K': case 'k': scale = 1000; break;
+        case 'M': case 'm': scale = 1000 * 1000; break;
+        case 'G': case 'g': scale = 1000 * 1000 * 1000; break;
+        default: break;
+        }
+        if (scale != 1) {
+            text.remove_suffix(1);
+        }
+    }
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string_view::npos) {
+        return false;
+    }
+    bytes = std::stoull(std::string(text)) * scale;
+    return bytes > 0;
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--book FILE]... [--sizes LIST] [--engines LIST] [--threads N]\n"
+              << "       [--exponent S] [--work-dir DIR] [--csv FILE]\n"
+              << "  --book FILE      a real corpus to measure (repeatable; default the two books)\n"
+              << "  --sizes LIST     synthetic Zipf corpora to generate, e.g. 1M,10M,100M,1G,10G (default 1M,10M,100M)\n"
+              << "  --engines LIST   any of hash,map,sort,radix,wide (default all five)\n"
+              << "  --threads N      threads of the hash and radix engines (default 1)\n"
+              << "  --exponent S     Zipf exponent of the synthetic corpora (default 1.1)\n"
+              << "  --work-dir DIR   where the synthetic corpora are kept between runs (default .)\n"
+              << "  --csv FILE       also write one machine-readable row per corpus and engine" << std::endl;
+}
+
+bool parseArguments(int argc, char* argv[], Settings& settings) {
+    bool sizesGiven = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "-h" || arg == "--help" || i + 1 >= argc) {
+            printUsage(argv[0]);
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--book") {
+            settings.books.push_back(value);
+        } else if (arg == "--sizes") {
+            sizesGiven = true;
+            settings.sizes.clear();
+            for (const std::string& item : splitList(value)) {
+                std::uint64_t bytes = 0;
+                if (!parseSize(item, bytes)) {
+                    std::cerr << "Error: bad size " << item << std::endl;
+                    return false;
+                }
+                settings.sizes.push_back(bytes);
+            }
+        } else if (arg == "--engines") {
+            settings.engines = splitList(value);
+            for (const std::string& engine : settings.engines) {
+                if (engine != "hash" && engine != "map" && engine != "sort" && engine != "radix" && engine != "wide") {
+                    std::cerr << "Error: unknown engine " << engine << std::endl;
+                    return false;
+                }
+            }
+        } else if (arg == "--threads") {
+            settings.threads = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        } else if (arg == "--exponent") {
+            settings.exponent = std::strtod(value.c_str(), nullptr);
+            if (!(settings.exponent > 0)) {
+                std::cerr << "Error: --exponent expects a positive number" << std::endl;
+                return false;
+            }
+        } else if (arg == "--work-dir") {
+            settings.workDir = value;
+        } else if (arg == "--csv") {
+            settings.csvFile = value;
+        } else {
+            std::cerr << "Error: unknown option " << arg << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if (settings.books.empty()) {
+        settings.books = {"../../books/pg2701.txt", "../../books/arabic.txt"};
+    }
+    if (!sizesGiven) {
+        settings.sizes = {1000 * 1000, 10 * 1000 * 1000, 100 * 1000 * 1000};
+    }
+    return true;
+}
+
+std::string sizeName(std::uint64_t bytes) {
+    static const char* units[] = {"", "K", "M", "G"};
+    std::size_t unit = 0;
+    while (unit < 3 && bytes % 1000 == 0 && bytes >= 1000) {
+        bytes /= 1000;
+        ++unit;
+    }
+    return std::to_string(bytes) + units[unit];
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Settings settings;
+    if (!parseArguments(argc, argv, settings)) {
+        return 1;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(settings.workDir, error);
+    corpus::countAllocations();
+
+    std::vector<Result> results;
+    for (const std::string& book : settings.books) {
+        benchCorpus(std::filesystem::path(book).filename().string(), book, settings, results);
+    }
+    for (std::uint64_t bytes : settings.sizes) {
+        std::string name = "zipf-" + sizeName(bytes);
+        std::string path = (std::filesystem::path(settings.workDir) / (name + ".txt")).string();
+        std::cerr << "Generating " << path << std::endl;
+        if (!generateZipfCorpus(path, bytes, settings.exponent)) {
+            return 1;
+        }
+        benchCorpus(name, path, settings, results);
+    }
+
+    printTable(results);
+    if (!settings.csvFile.empty() && !writeCsv(results, settings.csvFile)) {
+        return 1;
+    }
+    bool allMatch = std::all_of(results.begin(), results.end(), [](const Result& r) { return r.matches; });
+    if (!allMatch) {
+        std::cerr << "Error: some engines wrote a different table than the first one" << std::endl;
+    }
+    return allMatch ? 0 : 1;
+}
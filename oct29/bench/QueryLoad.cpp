@@ -0,0 +1,265 @@
+// Load test for the --serve query server.
+//
+// Maps the same index as the server (with its perfect-hash lookup file)
+// and first times lookups in process: the perfect hash against the binary
+// search of FrequencyIndex::count. Then every connection sends the queries
+// in batches of "w WORD" lines over the Unix socket, waits for the batch's
+// replies and checks each one against the local answer. About one query in
+// ten asks for a word that is not in the index.
+//
+// Reported: lookups per second and nanoseconds per lookup in process;
+// queries per second over the socket, and the latency of a batch round
+// trip (median, 99th percentile and maximum).
+
+#include "../include/FrequencyIndex.h"
+#include "../include/QueryServer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Settings {
+    std::string socket;
+    std::string index;
+    std::uint64_t requests = 1000000;
+    std::size_t batch = 100;
+    unsigned connections = 1;
+};
+
+std::uint64_t nextRandom(std::uint64_t& state) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// Words of the index picked at random; every tenth gets a suffix no word has.
+std::vector<std::string> pickQueries(const corpus::RankLookup& lookup, std::uint64_t count) {
+    std::vector<std::string> queries;
+    queries.reserve(count);
+    std::uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (std::uint64_t i = 0; i < count; ++i) {
+        std::string word(lookup.wordAt(1 + nextRandom(state) % lookup.size()));
+        if (i % 10 == 9) {
+            word += "#";
+        }
+        queries.push_back(std::move(word));
+    }
+    return queries;
+}
+
+void timeLookups(const corpus::RankLookup& lookup, const std::string& indexFile,
+                 const std::vector<std::string>& queries) {
+    corpus::FrequencyIndex index(indexFile);
+    std::uint64_t sink = 0;
+    auto start = Clock::now();
+    for (const std::string& word : queries) {
+        sink += lookup.find(word).count;
+    }
+    double hashSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    start = Clock::now();
+    for (const std::string& word : queries) {
+        sink -= index.count(word);
+    }
+    double searchSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::cout << std::fixed << std::setprecision(1) << "in process, " << queries.size() << " lookups of "
+              << lookup.size() << " words:\n"
+              << "  perfect hash   " << std::setw(8) << hashSeconds * 1e9 / queries.size() << " ns/lookup  "
+              << std::setw(8) << queries.size() / hashSeconds / 1e6 << " M lookups/s\n"
+              << "  binary search  " << std::setw(8) << searchSeconds * 1e9 / queries.size() << " ns/lookup  "
+              << std::setw(8) << queries.size() / searchSeconds / 1e6 << " M lookups/s\n";
+    if (sink != 0) {
+        std::cout << "  the two lookups disagree\n";
+    }
+}
+
+int connectTo(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return -1;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+struct ConnectionResult {
+    std::vector<double> latencies;  // seconds per batch round trip
+    std::uint64_t queries = 0;
+    std::uint64_t wrong = 0;
+    bool failed = false;
+};
+
+// Sends queries [begin, end) in batches and checks every reply.
+void runConnection(const Settings& settings, const corpus::RankLookup& lookup, const std::vector<std::string>& queries,
+                   std::size_t begin, std::size_t end, ConnectionResult& result) {
+    int fd = connectTo(settings.socket);
+    if (fd < 0) {
+        result.failed = true;
+        return;
+    }
+    std::string requests;
+    std::string expected;
+    std::string replies;
+    for (std::size_t first = begin; first < end; first += settings.batch) {
+        std::size_t last = std::min(end, first + settings.batch);
+        requests.clear();
+        expected.clear();
+        for (std::size_t i = first; i < last; ++i) {
+            requests += "w ";
+            requests += queries[i];
+            requests += '\n';
+            corpus::RankLookup::Answer answer = lookup.find(queries[i]);
+            expected += std::to_string(answer.rank) + ' ' + std::to_string(answer.count) + '\n';
+        }
+
+        auto start = Clock::now();
+        for (std::size_t sent = 0; sent < requests.size();) {
+            ssize_t put = ::send(fd, requests.data() + sent, requests.size() - sent, MSG_NOSIGNAL);
+            if (put <= 0) {
+                result.failed = true;
+                ::close(fd);
+                return;
+            }
+            sent += static_cast<std::size_t>(put);
+        }
+        replies.resize(expected.size());
+        for (std::size_t got = 0; got < replies.size();) {
+            ssize_t n = ::recv(fd, &replies[got], replies.size() - got, 0);
+            if (n <= 0) {
+                result.failed = true;
+                ::close(fd);
+                return;
+            }
+            got += static_cast<std::size_t>(n);
+        }
+        result.latencies.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+        result.queries += last - first;
+        if (replies != expected) {
+            ++result.wrong;
+        }
+    }
+    ::close(fd);
+}
+
+int loadTest(const Settings& settings, const corpus::RankLookup& lookup, const std::vector<std::string>& queries) {
+    std::vector<ConnectionResult> results(settings.connections);
+    std::vector<std::thread> threads;
+    std::size_t share = (queries.size() + settings.connections - 1) / settings.connections;
+    auto start = Clock::now();
+    for (unsigned c = 0; c < settings.connections; ++c) {
+        std::size_t begin = std::min(queries.size(), c * share);
+        std::size_t end = std::min(queries.size(), begin + share);
+        threads.emplace_back(runConnection, std::cref(settings), std::cref(lookup), std::cref(queries), begin, end,
+                             std::ref(results[c]));
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> latencies;
+    std::uint64_t answered = 0;
+    std::uint64_t wrong = 0;
+    for (const ConnectionResult& result : results) {
+        if (result.failed) {
+            std::cerr << "Error: lost the connection to " << settings.socket << std::endl;
+            return 1;
+        }
+        latencies.insert(latencies.end(), result.latencies.begin(), result.latencies.end());
+        answered += result.queries;
+        wrong += result.wrong;
+    }
+    if (latencies.empty()) {
+        return 0;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) { return latencies[static_cast<std::size_t>(p * (latencies.size() - 1))] * 1e6; };
+    std::cout << std::fixed << std::setprecision(1) << "over " << settings.socket << ", " << settings.connections
+              << " connection(s), batches of " << settings.batch << ":\n"
+              << "  " << answered << " queries in " << std::setprecision(3) << seconds << " s, "
+              << std::setprecision(0) << answered / seconds << " queries/s\n"
+              << std::setprecision(1) << "  batch round trip: median " << percentile(0.5) << " us, p99 "
+              << percentile(0.99) << " us, max " << latencies.back() * 1e6 << " us\n"
+              << "  batches with a wrong reply: " << wrong << std::endl;
+    return wrong == 0 ? 0 : 1;
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " --socket PATH --index FILE [--requests N] [--batch B] [--connections C]\n"
+              << "  --socket PATH      Unix socket of a running --serve server\n"
+              << "  --index FILE       the index it serves (queries are drawn from it and replies checked)\n"
+              << "  --requests N       word queries to send (default 1000000)\n"
+              << "  --batch B          queries per round trip (default 100)\n"
+              << "  --connections C    concurrent connections, one thread each (default 1)" << std::endl;
+}
+
+bool parseArguments(int argc, char* argv[], Settings& settings) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "-h" || arg == "--help" || i + 1 >= argc) {
+            printUsage(argv[0]);
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--socket") {
+            settings.socket = value;
+        } else if (arg == "--index") {
+            settings.index = value;
+        } else if (arg == "--requests") {
+            settings.requests = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--batch") {
+            settings.batch = std::max<std::size_t>(1, std::strtoull(value.c_str(), nullptr, 10));
+        } else if (arg == "--connections") {
+            settings.connections = std::max(1u, static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10)));
+        } else {
+            std::cerr << "Error: unknown option " << arg << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if (settings.socket.empty() || settings.index.empty()) {
+        printUsage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Settings settings;
+    if (!parseArguments(argc, argv, settings)) {
+        return 1;
+    }
+    corpus::RankLookup lookup;
+    if (!corpus::RankLookup::open(settings.index, lookup)) {
+        return 1;
+    }
+    if (lookup.size() == 0) {
+        std::cerr << "Error: " << settings.index << " has no words to ask for" << std::endl;
+        return 1;
+    }
+    std::vector<std::string> queries = pickQueries(lookup, settings.requests);
+    timeLookups(lookup, settings.index, queries);
+    return loadTest(settings, lookup, queries);
+}
@@ -0,0 +1,58 @@
+// Replaces the global operator new so that --profile and the benchmark can
+// count allocations. It is compiled into the tools and the benchmark, not
+// into the corpus library, so other programs linking the library keep the
+// standard allocator. The count itself only starts with countAllocations.
+#include "../include/Profile.h"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Like the default operator new: retry through the new_handler until it gives up.
+void* allocate(std::size_t size, std::size_t alignment) {
+    corpus::noteAllocation();
+    if (size == 0) {
+        size = 1;
+    }
+    for (;;) {
+        // aligned_alloc wants the size to be a multiple of the alignment
+        void* p = alignment > alignof(std::max_align_t)
+                      ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+                      : std::malloc(size);
+        if (p != nullptr) {
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    return allocate(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
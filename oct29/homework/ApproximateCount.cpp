@@ -0,0 +1,111 @@
+#include "../include/ApproximateCount.h"
+#include "../include/BlockReader.h"
+#include "../include/MappedFile.h"
+#include <cmath>
+#include <iostream>
+
+namespace corpus {
+
+namespace {
+
+void sketchInto(Script script, std::string_view text, ApproximateCounter& counter) {
+    forEachWord(script, text, [&](std::string_view word) {
+        counter.add(word);
+    });
+}
+
+} // namespace
+
+ApproximateCounter::ApproximateCounter(const SketchSettings& settings)
+    : distinct_(HyperLogLog::forError(settings.distinctError)),
+      heavy_(settings.top, CountMinSketch::forError(settings.frequencyError, settings.failureProbability)) {}
+
+bool ApproximateCounter::merge(const ApproximateCounter& other) {
+    // check both shapes first so a failed merge leaves this counter untouched
+    if (other.distinct_.precision() != distinct_.precision() ||
+        other.heavy_.sketch().width() != heavy_.sketch().width() ||
+        other.heavy_.sketch().depth() != heavy_.sketch().depth()) {
+        std::cerr << "Error: cannot merge sketches built with different error bounds" << std::endl;
+        return false;
+    }
+    distinct_.merge(other.distinct_);
+    heavy_.merge(other.heavy_);
+    total_ += other.total_;
+    return true;
+}
+
+ApproximateCounter approximateCount(std::string_view text, Script script, unsigned threads,
+                                    const SketchSettings& settings) {
+    std::vector<std::string_view> chunks = splitAtWordBoundaries(text, resolveThreads(threads), wordBytePredicate(script));
+    std::vector<ApproximateCounter> partials(chunks.size(), ApproximateCounter(settings));
+    if (chunks.size() == 1) {
+        sketchInto(script, text, partials[0]);
+        return std::move(partials[0]);
+    }
+    runOnChunks(chunks, [&](std::size_t i, std::string_view chunk) { sketchInto(script, chunk, partials[i]); });
+    for (std::size_t i = 1; i < partials.size(); ++i) {
+        partials[0].merge(partials[i]);
+    }
+    return std::move(partials[0]);
+}
+
+ApproximateCounter approximateCountStreaming(const std::string& fileName, std::size_t blockSize, Script script,
+                                             unsigned threads, const SketchSettings& settings,
+                                             std::uint64_t* bytesRead) {
+    threads = resolveThreads(threads);
+    std::vector<ApproximateCounter> partials(threads, ApproximateCounter(settings));
+    BlockReader reader(fileName, blockSize, wordBytePredicate(script));
+    std::string_view block;
+    while (reader.next(block)) {
+        if (threads == 1) {
+            sketchInto(script, block, partials[0]);
+            continue;
+        }
+        std::vector<std::string_view> chunks = splitAtWordBoundaries(block, threads, wordBytePredicate(script));
+        runOnChunks(chunks, [&](std::size_t i, std::string_view chunk) { sketchInto(script, chunk, partials[i]); });
+    }
+    if (bytesRead != nullptr) {
+        *bytesRead = reader.bytesRead();
+    }
+    for (std::size_t i = 1; i < partials.size(); ++i) {
+        partials[0].merge(partials[i]);
+    }
+    return std::move(partials[0]);
+}
+
+int runApproximate(const Options& options, Script script) {
+    SketchSettings settings;
+    settings.distinctError = options.distinctError;
+    settings.frequencyError = options.frequencyError;
+    if (options.top > 0) {
+        settings.top = options.top;
+    }
+
+    ApproximateCounter counter = [&] {
+        if (options.stream) {
+            return approximateCountStreaming(options.inputFile, options.blockSize, script, options.threads, settings);
+        }
+        MappedFile book(options.inputFile);
+        return approximateCount(book.view(), script, options.threads, settings);
+    }();
+
+    std::cout << "Total number of words: " << counter.totalCount() << std::endl;
+    std::cout << "Estimated number of unique words: " << std::llround(counter.distinctEstimate())
+              << " (standard error " << counter.distinct().standardError() * 100 << "%)" << std::endl;
+    std::cout << "Sketch memory: " << counter.memoryUsage() << " bytes" << std::endl;
+
+    std::vector<HeavyHitters::Entry> top = counter.top();
+    std::vector<WordCounter::Entry> ranked;
+    ranked.reserve(top.size());
+    for (const HeavyHitters::Entry& entry : top) {
+        ranked.push_back({entry.word, entry.count});
+    }
+    if (!writeFrequencies(ranked, options.outputFile, options.format)) {
+        return 1;
+    }
+    std::cout << "Estimated frequencies of the top " << settings.top << " words have been written to "
+              << options.outputFile << std::endl;
+    return 0;
+}
+
+} // namespace corpus
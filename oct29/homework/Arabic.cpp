@@ -1,4 +1,19 @@
 #include "../include/Arabic.h"
+#include "../include/MappedFile.h"
+#include "../include/Tokenizer.h"
+#include "../include/Options.h"
+#include "../include/CorpusStats.h"
+#include "../include/RankIndex.h"
+#include "../include/Batch.h"
+#include "../include/ApproximateCount.h"
+#include "../include/FrequencyIndex.h"
+#include "../include/NgramCount.h"
+#include "../include/Profile.h"
+#include "../include/QueryServer.h"
+#include "../include/SectionCount.h"
+#include "../include/TokenStream.h"
+#include "../include/VocabularyGrowth.h"
+#include "../include/ZipfPlot.h"
 
 namespace arabic {
 
@@ -12,58 +27,108 @@ bool isArabicAlphabet(wchar_t ch) {
 }
 
 std::vector<wchar_t> readBook(const std::string& fileName) {
+    corpus::MappedFile file(fileName);
     std::vector<wchar_t> result;
-    std::wifstream file(fileName);
-    file.imbue(std::locale(std::locale(), new std::codecvt_utf8<wchar_t>));
-
-    if (file.is_open()) {
-        wchar_t ch;
-        while (file.get(ch)) {
-            if (isArabicAlphabet(ch)) {
-                result.push_back(ch);
-            } else if (std::iswspace(ch) || ch == L'\u200C') {
-                result.push_back(L' ');
-            } else {
-                result.push_back(L' ');
-            }
+    result.reserve(file.size() / 2);
+
+    // Walk the UTF-8 bytes of the mapping: Arabic-block characters are decoded,
+    // every other code point becomes a single space.
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(file.data());
+    const unsigned char* end = p + file.size();
+    while (p != end) {
+        if (corpus::isArabicLeadByte(*p) && p + 1 != end && corpus::isContinuationByte(p[1])) {
+            result.push_back(static_cast<wchar_t>(((p[0] & 0x1F) << 6) | (p[1] & 0x3F)));
+            p += 2;
+            continue;
+        }
+        result.push_back(L' ');
+        ++p;
+        while (p != end && corpus::isContinuationByte(*p)) {
+            ++p;
         }
-    } else {
-        std::cerr << "Error: Could not open file " << fileName << std::endl;
     }
 
     return result;
 }
 
-std::map<std::wstring, int> computeWordFrequency(const std::vector<wchar_t>& book) {
-    std::map<std::wstring, int> wordFrequency;
-    std::wstringstream ss;
-
-    for (wchar_t ch : book) {
-        ss << ch;
+std::wstring decodeArabicWord(std::string_view word) {
+    std::wstring result(word.size() / 2, L' ');
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        unsigned char lead = static_cast<unsigned char>(word[2 * i]);
+        unsigned char tail = static_cast<unsigned char>(word[2 * i + 1]);
+        result[i] = static_cast<wchar_t>(((lead & 0x1F) << 6) | (tail & 0x3F));
     }
+    return result;
+}
 
-    std::wstring word;
-    while (ss >> word) {
-        wordFrequency[word]++;
+std::string encodeUtf8(std::wstring_view text) {
+    std::string result;
+    result.reserve(text.size() * 2);
+    for (wchar_t ch : text) {
+        auto cp = static_cast<std::uint32_t>(ch);
+        if (cp < 0x80) {
+            result.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            result.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            result.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            result.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            result.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            result.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            result.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            result.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
     }
+    return result;
+}
 
-    return wordFrequency;
+void countWordsInto(std::string_view text, corpus::WordCounter& counter) {
+    corpus::countWordsInto(corpus::Script::Arabic, text, counter);
 }
 
-int countUniqueWords(const std::vector<wchar_t>& book) {
-    std::set<std::wstring> uniqueWords;
-    std::wstringstream ss;
+corpus::WordCounter countWords(std::string_view text) {
+    return corpus::countWords(text, corpus::Script::Arabic);
+}
 
-    for (wchar_t ch : book) {
-        ss << ch;
-    }
+corpus::WordCounter countWords(std::string_view text, unsigned threads) {
+    return corpus::countWords(text, corpus::Script::Arabic, threads);
+}
 
-    std::wstring word;
-    while (ss >> word) {
-        uniqueWords.insert(word);
-    }
+corpus::WordCounter countWordsStreaming(const std::string& fileName, std::size_t blockSize, unsigned threads,
+                                        std::uint64_t* bytesRead) {
+    return corpus::countWordsStreaming(fileName, blockSize, corpus::Script::Arabic, threads, bytesRead);
+}
+
+corpus::SectionCounts countSurahs(std::string_view text, unsigned threads) {
+    corpus::SectionSettings settings;
+    settings.markers = {"سورة"};
+    return corpus::countSections(text, corpus::Script::Arabic, settings, threads);
+}
+
+std::map<std::wstring, int> computeWordFrequency(std::string_view text) {
+    std::map<std::wstring, int> wordFrequency;
+    Engine::count(text).forEach([&](std::string_view word, std::uint64_t count) {
+        wordFrequency.emplace(decodeArabicWord(word), static_cast<int>(count));
+    });
+    return wordFrequency;
+}
 
-    return uniqueWords.size();
+int countUniqueWords(std::string_view text) {
+    return static_cast<int>(Engine::uniqueWords(text));
+}
+
+std::map<std::wstring, int> computeWordFrequency(const std::vector<wchar_t>& book) {
+    // back to UTF-8 so the same byte tokenizer and counter do the work
+    std::string text = encodeUtf8(std::wstring_view(book.data(), book.size()));
+    return computeWordFrequency(std::string_view(text));
+}
+
+int countUniqueWords(const std::vector<wchar_t>& book) {
+    std::string text = encodeUtf8(std::wstring_view(book.data(), book.size()));
+    return countUniqueWords(std::string_view(text));
 }
 
 std::multimap<int, std::wstring> sortFrequencies(const std::map<std::wstring, int>& frequencies) {
@@ -76,9 +141,19 @@ std::multimap<int, std::wstring> sortFrequencies(const std::map<std::wstring, in
     return sortedFrequencies;
 }
 
+std::multimap<int, std::wstring> sortFrequencies(const corpus::WordCounter& counter) {
+    std::multimap<int, std::wstring> sortedFrequencies;
+
+    // equal counts keep their insertion order, which is alphabetical here
+    for (const auto& entry : corpus::rankByFrequency(counter)) {
+        sortedFrequencies.emplace(static_cast<int>(entry.count), decodeArabicWord(entry.word));
+    }
+
+    return sortedFrequencies;
+}
+
 void exportFrequenciesToFile(const std::multimap<int, std::wstring>& sortedFreq, const std::string& outputFileName) {
-    std::wofstream outFile(outputFileName);
-    outFile.imbue(std::locale(std::locale(), new std::codecvt_utf8<wchar_t>));
+    std::ofstream outFile(outputFileName, std::ios::binary);
 
     if (!outFile.is_open()) {
         std::cerr << "Error: Could not open file " << outputFileName << std::endl;
@@ -87,54 +162,161 @@ void exportFrequenciesToFile(const std::multimap<int, std::wstring>& sortedFreq,
 
     int rank = 1;
     for (auto it = sortedFreq.rbegin(); it != sortedFreq.rend(); ++it) {
-        outFile << rank << L" " << it->first << L" " << it->second << L"\n";
+        outFile << rank << ' ' << it->first << ' ' << encodeUtf8(it->second) << '\n';
         ++rank;
     }
 
     outFile.close();
 }
 
+void exportFrequenciesToFile(const corpus::RankIndex& ranks, const std::string& outputFileName,
+                             corpus::OutputFormat format) {
+    // the ranked words are still UTF-8 bytes, so they are written as they are
+    corpus::writeFrequencies(ranks, outputFileName, format);
+}
+
 void printHapaxLegomena(const std::multimap<int, std::wstring>& sortedFreq) {
     int hapaxCount = 0;
-    std::wcout << L"\nHapax Legomena (words that appear only once):" << std::endl;
+    std::cout << "\nHapax Legomena (words that appear only once):" << std::endl;
 
     for (const auto& pair : sortedFreq) {
         if (pair.first == 1) {
             ++hapaxCount;
             if (hapaxCount <= 10) { // Print only the first 10 hapax legomena for demonstration
-                std::wcout << pair.second << std::endl;
+                std::cout << encodeUtf8(pair.second) << std::endl;
             }
         }
     }
 
-    std::wcout << L"\nTotal number of hapax legomena: " << hapaxCount << std::endl;
+    std::cout << "\nTotal number of hapax legomena: " << hapaxCount << std::endl;
+}
+
+void printHapaxLegomena(const corpus::CorpusStats& stats) {
+    std::cout << "\nHapax Legomena (words that appear only once):" << std::endl;
+
+    // the frequency spectrum keeps the hapax list as the words are counted; only the
+    // ten printed are sorted, and the words are UTF-8 already, so they go to the terminal as they are
+    for (std::string_view word : stats.hapaxLegomena(10)) {
+        std::cout << word << "\n";
+    }
+
+    std::cout << "\nTotal number of hapax legomena: " << stats.frequencySpectrum().hapaxLegomena() << std::endl;
+    corpus::printSpectrumSummary(stats.frequencySpectrum(), std::cout);
 }
 
 } // namespace arabic
 
-int main() {
-    arabic::setupLocale();
+int main(int argc, char* argv[]) {
+    corpus::Options options;
+    options.inputFile = "../../books/arabic.txt"; // UTF-8 encoded Arabic file
+    options.outputFile = "word_frequencies_arabic.txt";
+    options.sectionMarkers = {"سورة"};  // --sections splits the book into surahs
+    if (!corpus::parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    if (!options.profile.empty()) {
+        corpus::countAllocations();  // unprofiled runs skip the shared allocation counter
+    }
+
+    std::string fileName = options.inputFile;
+    // with --normalize, orthographic variants are folded while tokenizing
+    corpus::Script script = options.normalize ? corpus::Script::ArabicNormalized : corpus::Script::Arabic;
+    if (!options.serve.empty()) {
+        // answer rank and frequency queries about a saved index instead of counting
+        return corpus::runQueryServer(options);
+    }
+    if (!options.batch.empty()) {
+        // many books at once: per-book tables plus one merged table
+        return corpus::runBatch(options, script);
+    }
+    if (options.approximate) {
+        // fixed-memory estimates instead of an exact table
+        return corpus::runApproximate(options, script);
+    }
+    if (!options.appendIndex.empty()) {
+        // nightly updates: fold the new text into the stored index and stop
+        return corpus::runIndexAppend(options, script);
+    }
+    if (options.ngram > 1) {
+        // word pairs or triples instead of single words
+        return corpus::runNgrams(options, script);
+    }
+    if (options.sections) {
+        // per-section tables and a section x word matrix, along with the global table
+        return corpus::runSections(options, script);
+    }
+    // every step is timed; the report is only written with --profile
+    corpus::RunProfile profile("Arabic");
+    profile.setInput(fileName, options.threads);
 
-    std::string fileName = "../../books/arabic.txt"; // UTF-8 encoded Arabic file
-    std::vector<wchar_t> content = arabic::readBook(fileName);
-    std::map<std::wstring, int> wordFreq = arabic::computeWordFrequency(content);
-    int uniqueWordCount = arabic::countUniqueWords(content);
-    std::multimap<int, std::wstring> sortedFreq = arabic::sortFrequencies(wordFreq);
+    // one tokenizing pass fills the frequency table, spectrum and hapax list
+    // with --heaps the same pass records the vocabulary growth curve
+    corpus::VocabularyGrowth growth;
+    corpus::VocabularyGrowth* heapsCurve = options.heaps ? &growth : nullptr;
+    corpus::CorpusStats stats;
+    profile.begin("count");
+    if (!options.tokens.empty() || !options.saveTokens.empty()) {
+        // through the dictionary-encoded token stream, loaded instead of tokenized or saved for reuse
+        corpus::TokenStream tokens;
+        if (!corpus::readTokens(options, script, tokens)) {
+            return 1;
+        }
+        stats = corpus::CorpusStats::fromTokens(tokens, heapsCurve);
+    } else if (options.stream) {
+        // count block by block, the text itself is never held in memory
+        stats = corpus::CorpusStats::fromStream(fileName, options.blockSize, script, options.threads, heapsCurve);
+    } else {
+        corpus::MappedFile book(fileName);
+        stats = options.engine == corpus::CountingEngine::Sort
+                    ? corpus::CorpusStats::fromTextBySorting(book.view(), script, options.threads)
+                    : corpus::CorpusStats::fromText(book.view(), script, options.threads, heapsCurve);
+    }
+    profile.addWork(stats.bytesProcessed(), stats.totalTokens());
+    profile.setTable(stats.frequencies());
+    if (!options.saveIndex.empty()) {
+        profile.begin("index");
+        if (corpus::writeFrequencyIndex(options.saveIndex, stats.frequencies(), script)) {
+            std::cout << "Frequency index has been written to " << options.saveIndex << std::endl;
+        }
+    }
+    std::size_t uniqueWordCount = stats.vocabularySize();
+    // rank with a counting sort over the frequencies (or only the head with --top)
+    profile.begin("rank");
+    corpus::RankIndex ranks = options.top > 0 ? corpus::RankIndex::top(stats.frequencies(), options.top)
+                                              : corpus::RankIndex(stats.frequencies());
 
     // Display word frequencies and unique words
-    std::wcout << L"\nNumber of unique words: " << uniqueWordCount << std::endl;
-    std::wcout << L"\nSorted Word Frequencies (Descending):" << std::endl;
-    for (auto it = sortedFreq.rbegin(); it != sortedFreq.rend(); ++it) {
-        std::wcout << it->second << L": " << it->first << std::endl;
+    // the words stay UTF-8 end to end, so no locale or wide stream is needed
+    std::cout << "\nNumber of unique words: " << uniqueWordCount << std::endl;
+    profile.begin("print");
+    std::cout << "\nSorted Word Frequencies (Descending):" << std::endl;
+    for (const auto& [word, frequency] : ranks) {
+        std::cout << word << ": " << frequency << "\n";
     }
 
     // Export sorted frequencies to file
-    std::string outputFileName = "word_frequencies_arabic.txt";
-    arabic::exportFrequenciesToFile(sortedFreq, outputFileName);
+    std::string outputFileName = options.outputFile;
+    profile.begin("write");
+    arabic::exportFrequenciesToFile(ranks, outputFileName, options.format);
     std::cout << "\nExported frequencies to " << outputFileName << std::endl;
+    if (options.heaps) {
+        profile.begin("heaps");
+        corpus::exportHeapsCurve(growth, outputFileName);
+    }
 
     // Print hapax legomena
-    arabic::printHapaxLegomena(sortedFreq);
+    profile.begin("hapax");
+    arabic::printHapaxLegomena(stats);
+
+    // this tool has no Matplot++, so the plot is only exported (as SVG)
+    if (!options.plotFile.empty()) {
+        profile.begin("plot");
+        corpus::exportZipfPlot(ranks, options.plotFile, "Arabic Word Frequency Distribution (Log-Log Scale)");
+    }
+
+    if (!options.profile.empty() && profile.writeJson(options.profile)) {
+        std::cout << "Run profile has been written to " << options.profile << std::endl;
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include "../include/Batch.h"
+#include "../include/MappedFile.h"
+#include "../include/ParallelCount.h"
+#include "../include/RankIndex.h"
+#include "../include/WorkStealingPool.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <numeric>
+
+namespace corpus {
+
+namespace {
+
+// Everything one book needs while its pieces are being counted.
+struct BookJob {
+    std::string path;
+    std::string output;
+    std::uintmax_t size = 0;
+    MappedFile file;
+    std::vector<std::string_view> pieces;
+    std::vector<WordCounter> partials;
+    std::atomic<std::size_t> remaining{0};
+};
+
+bool writeRanked(const WordCounter& counter, std::size_t top, const std::string& fileName, OutputFormat format) {
+    RankIndex ranks = top > 0 ? RankIndex::top(counter, top) : RankIndex(counter);
+    return writeFrequencies(ranks, fileName, format);
+}
+
+} // namespace
+
+std::vector<std::string> listBatchInputs(const std::string& path) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> books;
+    std::error_code error;
+    if (fs::is_directory(path, error)) {
+        for (const fs::directory_entry& entry : fs::directory_iterator(path, error)) {
+            if (entry.is_regular_file(error)) {
+                books.push_back(entry.path().string());
+            }
+        }
+        std::sort(books.begin(), books.end());
+        return books;
+    }
+
+    std::ifstream list(path);
+    if (!list) {
+        std::cerr << "Error: Could not open file " << path << std::endl;
+        return books;
+    }
+    std::string line;
+    while (std::getline(list, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty() && line[0] != '#') {
+            books.push_back(line);
+        }
+    }
+    return books;
+}
+
+std::string batchOutputName(const std::string& book) {
+    return std::filesystem::path(book).stem().string() + ".freq.txt";
+}
+
+BatchSummary countBatch(const std::vector<std::string>& books, const BatchSettings& settings) {
+    namespace fs = std::filesystem;
+    std::vector<std::unique_ptr<BookJob>> jobs;
+    jobs.reserve(books.size());
+    std::map<std::string, std::size_t> usedNames;
+    for (const std::string& book : books) {
+        auto job = std::make_unique<BookJob>();
+        job->path = book;
+        std::error_code error;
+        job->size = fs::file_size(book, error);
+        if (error) {
+            job->size = 0;
+        }
+        if (!settings.outputDir.empty()) {
+            // two books with the same file name in different directories get distinct tables
+            std::string name = batchOutputName(book);
+            std::size_t seen = usedNames[name]++;
+            if (seen > 0) {
+                name = fs::path(book).stem().string() + "-" + std::to_string(seen) + ".freq.txt";
+            }
+            job->output = (fs::path(settings.outputDir) / name).string();
+        }
+        jobs.push_back(std::move(job));
+    }
+
+    // largest books first, so the big ones are not the last to start
+    std::vector<std::size_t> order(jobs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return jobs[a]->size > jobs[b]->size;
+    });
+
+    WorkStealingPool pool(settings.threads);
+    std::vector<WordCounter> shares(pool.size());  // each worker's part of the global table
+    std::atomic<std::size_t> failed{0};
+    std::atomic<std::size_t> unwritten{0};
+    std::atomic<std::uint64_t> bytes{0};
+
+    auto finish = [&](BookJob& job) {
+        WordCounter counts = std::move(job.partials[0]);
+        for (std::size_t i = 1; i < job.partials.size(); ++i) {
+            counts.merge(job.partials[i]);
+        }
+        if (!job.output.empty() && !writeRanked(counts, settings.top, job.output, settings.format)) {
+            ++unwritten;
+        }
+        shares[pool.currentWorker()].merge(counts);
+        // the pieces point into the mapping, drop both as soon as the book is done
+        job.partials.clear();
+        job.pieces.clear();
+        job.file = MappedFile();
+    };
+
+    auto countPiece = [&](BookJob& job, std::size_t i) {
+        countWordsInto(settings.script, job.pieces[i], job.partials[i]);
+        if (job.remaining.fetch_sub(1) == 1) {
+            finish(job);
+        }
+    };
+
+    for (std::size_t index : order) {
+        BookJob* job = jobs[index].get();
+        pool.submit([&, job] {
+            job->file = MappedFile(job->path);
+            if (!job->file.isOpen()) {
+                ++failed;
+                return;
+            }
+            bytes += job->file.size();
+
+            std::size_t parts = settings.splitSize > 0 ? (job->file.size() + settings.splitSize - 1) / settings.splitSize : 1;
+            job->pieces = splitAtWordBoundaries(job->file.view(), parts, wordBytePredicate(settings.script));
+            job->partials.resize(job->pieces.size());
+            job->remaining = job->pieces.size();
+            // the other pieces wait on this worker's deque, where idle workers steal them
+            for (std::size_t i = 1; i < job->pieces.size(); ++i) {
+                pool.submit([&, job, i] { countPiece(*job, i); });
+            }
+            countPiece(*job, 0);
+        });
+    }
+    pool.wait();
+
+    BatchSummary summary;
+    summary.failed = failed;
+    summary.unwritten = unwritten;
+    summary.books = books.size() - summary.failed;
+    summary.bytes = bytes;
+    summary.global = mergeSharded(shares, pool.size());
+    return summary;
+}
+
+int runBatch(const Options& options, Script script) {
+    std::vector<std::string> books = listBatchInputs(options.batch);
+    if (books.empty()) {
+        std::cerr << "Error: no books found in " << options.batch << std::endl;
+        return 1;
+    }
+
+    BatchSettings settings;
+    settings.script = script;
+    settings.threads = options.threads;
+    settings.splitSize = options.splitSize;
+    settings.outputDir = options.outputDir;
+    settings.top = options.top;
+    settings.format = options.format;
+    if (!settings.outputDir.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(settings.outputDir, error);
+    }
+
+    BatchSummary summary = countBatch(books, settings);
+    bool written = writeRanked(summary.global, options.top, options.outputFile, options.format);
+    if (summary.unwritten > 0) {
+        std::cerr << "Error: " << summary.unwritten << " of the per-book tables could not be written to "
+                  << settings.outputDir << std::endl;
+    }
+    if (!written || summary.unwritten > 0) {
+        return 1;
+    }
+
+    std::cout << "Books counted: " << summary.books << " (" << summary.failed << " failed), "
+              << summary.bytes << " bytes" << std::endl;
+    std::cout << "Total number of words: " << summary.global.totalCount() << std::endl;
+    std::cout << "Number of unique words: " << summary.global.size() << std::endl;
+    if (!settings.outputDir.empty()) {
+        std::cout << "Per-book frequencies have been written to " << settings.outputDir << std::endl;
+    }
+    std::cout << "Global frequencies have been written to " << options.outputFile << std::endl;
+    return summary.failed == 0 ? 0 : 1;
+}
+
+} // namespace corpus
@@ -0,0 +1,135 @@
+#include "../include/BlockReader.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace corpus {
+
+BlockReader::BlockReader(const std::string& fileName, std::size_t blockSize, WordBytePredicate isWordByte)
+    : isWordByte_(isWordByte),
+      blockSize_(std::max<std::size_t>(blockSize, 64)),
+      buffers_(readAhead + 1),
+      free_(readAhead + 1),
+      filled_(readAhead + 2) {
+    if (fileName == "-") {
+        fd_ = STDIN_FILENO;
+    } else {
+        fd_ = ::open(fileName.c_str(), O_RDONLY);
+        ownsFd_ = fd_ >= 0;
+    }
+    if (fd_ < 0) {
+        std::cerr << "Error: Could not open file " << fileName << std::endl;
+        done_ = true;
+        return;
+    }
+
+    struct stat st;
+    regular_ = ::fstat(fd_, &st) == 0 && S_ISREG(st.st_mode);
+    if (regular_) {
+        // read front to back: the kernel doubles its own read-ahead window
+        ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    for (std::size_t i = 0; i < buffers_.size(); ++i) {
+        free_.tryPush(i);
+    }
+    reader_ = std::thread(&BlockReader::readLoop, this);
+}
+
+BlockReader::~BlockReader() {
+    stop_.store(true, std::memory_order_release);
+    if (reader_.joinable()) {
+        reader_.join();
+    }
+    if (ownsFd_) {
+        ::close(fd_);
+    }
+}
+
+bool BlockReader::next(std::string_view& block) {
+    // the previous block has been counted, its buffer can be refilled
+    if (current_ != noBuffer) {
+        free_.tryPush(current_);
+        current_ = noBuffer;
+    }
+    if (done_) {
+        return false;
+    }
+    Filled filled;
+    if (!filled_.pop(filled, stop_) || filled.buffer == noBuffer) {
+        done_ = true;
+        return false;
+    }
+    current_ = filled.buffer;
+    block = std::string_view(buffers_[current_].data(), filled.size);
+    return true;
+}
+
+// Reads until buffer holds filled + blockSize_ bytes or the input ends.
+// Returns false at the end of the input.
+bool BlockReader::fill(std::vector<char>& buffer, std::size_t& filled) {
+    std::size_t target = filled + blockSize_;
+    if (regular_) {
+        // have the disk fetch the blocks after this one while it is copied and counted
+        off_t ahead = static_cast<off_t>(bytesRead_.load(std::memory_order_relaxed) + blockSize_);
+        ::posix_fadvise(fd_, ahead, static_cast<off_t>(blockSize_ * readAhead), POSIX_FADV_WILLNEED);
+    }
+    while (filled < target) {
+        ssize_t got = ::read(fd_, buffer.data() + filled, target - filled);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            if (got < 0) {
+                std::cerr << "Error: Could not read input: " << std::strerror(errno) << std::endl;
+            }
+            return false;
+        }
+        filled += static_cast<std::size_t>(got);
+        bytesRead_.fetch_add(static_cast<std::uint64_t>(got), std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void BlockReader::readLoop() {
+    std::vector<char> carried;  // unfinished word at the end of the last block
+    std::size_t index = noBuffer;
+    bool more = true;
+    while (more) {
+        if (index == noBuffer && !free_.pop(index, stop_)) {
+            return;
+        }
+        std::vector<char>& buffer = buffers_[index];
+        // a word longer than a whole block: make room instead of cutting it
+        if (buffer.size() < carried.size() + blockSize_) {
+            buffer.resize(carried.size() + blockSize_);
+        }
+        std::copy(carried.begin(), carried.end(), buffer.begin());
+        std::size_t filled = carried.size();
+        more = fill(buffer, filled);
+
+        std::size_t cut = filled;
+        if (more) {
+            // hold back the trailing partial word
+            while (cut > 0 && isWordByte_(buffer[cut - 1])) {
+                --cut;
+            }
+        }
+        carried.assign(buffer.begin() + static_cast<std::ptrdiff_t>(cut),
+                       buffer.begin() + static_cast<std::ptrdiff_t>(filled));
+        if (cut == 0) {
+            // nothing complete yet, keep the buffer for the next read
+            continue;
+        }
+        if (!filled_.push(Filled{index, cut}, stop_)) {
+            return;
+        }
+        index = noBuffer;
+    }
+    filled_.push(Filled{noBuffer, 0}, stop_);
+}
+
+} // namespace corpus
@@ -0,0 +1,71 @@
+#include "../include/CorpusStats.h"
+#include "../include/WordEngine.h"
+#include <algorithm>
+#include <iomanip>
+#include <utility>
+
+namespace corpus {
+
+CorpusStats::CorpusStats(WordCounter counter) : counter_(std::move(counter)) {
+    spectrum_.recordTable(counter_);
+}
+
+CorpusStats CorpusStats::fromText(std::string_view text, Script script, unsigned threads, VocabularyGrowth* growth) {
+    CorpusStats stats;
+    stats.counter_ = countWords(text, script, threads, growth, &stats.spectrum_);
+    stats.bytes_ = text.size();
+    return stats;
+}
+
+CorpusStats CorpusStats::fromTextBySorting(std::string_view text, Script script, unsigned threads) {
+    SortCounting runs(threads, text.size());
+    forEachWord(script, text, [&](std::string_view word) { runs.add(word); });
+    runs.finish();
+    WordCounter counter(runs.size());
+    runs.forEach([&](std::string_view word, std::uint64_t count) { counter.add(word, count); });
+    CorpusStats stats(std::move(counter));
+    stats.bytes_ = text.size();
+    return stats;
+}
+
+CorpusStats CorpusStats::fromStream(const std::string& fileName, std::size_t blockSize, Script script, unsigned threads,
+                                    VocabularyGrowth* growth) {
+    CorpusStats stats;
+    stats.counter_ = countWordsStreaming(fileName, blockSize, script, threads, &stats.bytes_, growth, &stats.spectrum_);
+    return stats;
+}
+
+CorpusStats CorpusStats::fromTokens(const TokenStream& tokens, VocabularyGrowth* growth) {
+    CorpusStats stats(tokens.toCounter());
+    stats.bytes_ = tokens.bytesProcessed();
+    if (growth != nullptr) {
+        tokens.recordGrowth(*growth);
+    }
+    return stats;
+}
+
+std::vector<std::string_view> CorpusStats::wordsOccurring(std::uint64_t m, std::size_t limit) const {
+    std::vector<std::string_view> words;
+    for (WordCounter::WordRef word : spectrum_.wordsOf(m)) {
+        words.push_back(counter_.word(word));
+    }
+    limit = std::min(limit, words.size());
+    std::partial_sort(words.begin(), words.begin() + limit, words.end());
+    words.resize(limit);
+    return words;
+}
+
+void printSpectrumSummary(const FrequencySpectrum& spectrum, std::ostream& out) {
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << "Dis legomena (words that appear twice): " << spectrum.disLegomena() << "\n"
+        << "Good-Turing probability of an unseen word: " << std::setprecision(4) << spectrum.unseenProbability() << "\n"
+        << std::fixed << std::setprecision(4) << "Vocabulary richness: type-token ratio " << spectrum.typeTokenRatio()
+        << std::setprecision(2) << ", Yule's K " << spectrum.yulesK() << ", Honore's R " << spectrum.honoresR() << ", Sichel's S "
+        << spectrum.sichelsS() << ", Brunet's W " << spectrum.brunetsW() << ", Herdan's C " << spectrum.herdansC()
+        << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+}
+
+} // namespace corpus
@@ -0,0 +1,201 @@
+#include "../include/Counting.h"
+#include "../include/BlockReader.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace corpus {
+
+namespace {
+
+template <Script script>
+void countScriptInto(std::string_view text, WordCounter& counter) {
+    forEachWord(script, text, [&](std::string_view word) {
+        counter.add(word);
+    });
+}
+
+using CountChunk = void (*)(std::string_view, WordCounter&);
+
+CountChunk chunkCounter(Script script) {
+    switch (script) {
+    case Script::Arabic:
+        return countScriptInto<Script::Arabic>;
+    case Script::ArabicNormalized:
+        return countScriptInto<Script::ArabicNormalized>;
+    default:
+        return countScriptInto<Script::Ascii>;
+    }
+}
+
+// Serial counting with the growth curve and the frequency spectrum (either
+// may be null): a word is new exactly when its count has just become 1.
+void countTrackedInto(Script script, std::string_view text, WordCounter& counter, VocabularyGrowth* growth,
+                      FrequencySpectrum* spectrum) {
+    forEachWord(script, text, [&](std::string_view word) {
+        std::uint64_t position = counter.totalCount();
+        WordCounter::Added added = counter.addCounted(word, hashWord(word));
+        if (growth != nullptr && added.count == 1) {
+            growth->addWordAt(position);
+        }
+        if (spectrum != nullptr) {
+            spectrum->record(added.word, added.count - 1, added.count);
+        }
+    });
+}
+
+// The words a worker met for the first time in one chunk, in order, with
+// their token position in the chunk. Copied, as the tokenizer's views are
+// only valid during the callback.
+struct NewWords {
+    std::vector<std::uint64_t> positions;
+    std::vector<std::size_t> ends;  // end of each word in bytes
+    std::string bytes;
+    std::uint64_t tokens = 0;
+};
+
+void countChunkTracked(Script script, std::string_view chunk, WordCounter& counter, NewWords& fresh) {
+    std::uint64_t base = counter.totalCount();
+    forEachWord(script, chunk, [&](std::string_view word) {
+        std::size_t before = counter.size();
+        std::uint64_t position = counter.totalCount() - base;
+        counter.add(word);
+        if (counter.size() != before) {
+            fresh.positions.push_back(position);
+            fresh.bytes.append(word);
+            fresh.ends.push_back(fresh.bytes.size());
+        }
+    });
+    fresh.tokens = counter.totalCount() - base;
+}
+
+// Replays the chunks in text order. A word new to its worker is new to the
+// text unless an earlier chunk (or block) had it, which the seen set tells;
+// only each chunk's new words are replayed, not its tokens.
+void replayNewWords(std::vector<NewWords>& chunks, WordCounter& seen, std::uint64_t& position,
+                    VocabularyGrowth& growth) {
+    for (NewWords& chunk : chunks) {
+        std::size_t begin = 0;
+        for (std::size_t i = 0; i < chunk.positions.size(); ++i) {
+            std::string_view word(chunk.bytes.data() + begin, chunk.ends[i] - begin);
+            begin = chunk.ends[i];
+            std::size_t before = seen.size();
+            seen.add(word);
+            if (seen.size() != before) {
+                growth.addWordAt(position + chunk.positions[i]);
+            }
+        }
+        position += chunk.tokens;
+        // a later block may split into fewer chunks, leaving this one unused
+        chunk.tokens = 0;
+        chunk.positions.clear();
+        chunk.ends.clear();
+        chunk.bytes.clear();
+    }
+}
+
+} // namespace
+
+WordBytePredicate wordBytePredicate(Script script) {
+    return script == Script::Ascii ? AsciiText::isWordByte : ArabicText::isWordByte;
+}
+
+void countWordsInto(Script script, std::string_view text, WordCounter& counter) {
+    chunkCounter(script)(text, counter);
+}
+
+WordCounter countWords(std::string_view text, Script script, unsigned threads, VocabularyGrowth* growth,
+                       FrequencySpectrum* spectrum) {
+    if (growth != nullptr) {
+        threads = resolveThreads(threads);
+        std::vector<std::string_view> chunks = splitAtWordBoundaries(text, threads, wordBytePredicate(script));
+        if (chunks.size() <= 1) {
+            WordCounter counter;
+            countTrackedInto(script, text, counter, growth, spectrum);
+            growth->finish(counter.totalCount());
+            return counter;
+        }
+        std::vector<WordCounter> partials(chunks.size());
+        std::vector<NewWords> fresh(chunks.size());
+        runOnChunks(chunks, [&](std::size_t i, std::string_view chunk) {
+            countChunkTracked(script, chunk, partials[i], fresh[i]);
+        });
+        WordCounter seen;
+        std::uint64_t position = 0;
+        replayNewWords(fresh, seen, position, *growth);
+        growth->finish(position);
+        WordCounter counter = mergeSharded(partials, threads);
+        if (spectrum != nullptr) {
+            spectrum->recordTable(counter);
+        }
+        return counter;
+    }
+
+    auto countChunk = chunkCounter(script);
+    if (threads == 1) {
+        WordCounter counter;
+        if (spectrum != nullptr) {
+            countTrackedInto(script, text, counter, nullptr, spectrum);
+        } else {
+            countChunk(text, counter);
+        }
+        return counter;
+    }
+    WordCounter counter = countInParallel(text, threads, wordBytePredicate(script), countChunk);
+    if (spectrum != nullptr) {
+        spectrum->recordTable(counter);
+    }
+    return counter;
+}
+
+WordCounter countWordsStreaming(const std::string& fileName, std::size_t blockSize, Script script,
+                                unsigned threads, std::uint64_t* bytesRead, VocabularyGrowth* growth,
+                                FrequencySpectrum* spectrum) {
+    if (growth != nullptr || (spectrum != nullptr && resolveThreads(threads) == 1)) {
+        // as countStream; serially every token is tracked, on several threads
+        // each block's new words are replayed before the next is read
+        threads = resolveThreads(threads);
+        WordBytePredicate isWordByte = wordBytePredicate(script);
+        std::vector<WordCounter> partials(threads);
+        std::vector<NewWords> fresh(threads);
+        WordCounter seen;
+        std::uint64_t position = 0;
+        BlockReader reader(fileName, blockSize, isWordByte);
+        std::string_view block;
+        while (reader.next(block)) {
+            if (threads == 1) {
+                countTrackedInto(script, block, partials[0], growth, spectrum);
+                continue;
+            }
+            std::vector<std::string_view> chunks = splitAtWordBoundaries(block, threads, isWordByte);
+            runOnChunks(chunks, [&](std::size_t i, std::string_view chunk) {
+                countChunkTracked(script, chunk, partials[i], fresh[i]);
+            });
+            replayNewWords(fresh, seen, position, *growth);
+        }
+        if (bytesRead != nullptr) {
+            *bytesRead = reader.bytesRead();
+        }
+        if (threads == 1) {
+            if (growth != nullptr) {
+                growth->finish(partials[0].totalCount());
+            }
+            return std::move(partials[0]);
+        }
+        growth->finish(position);
+        WordCounter counter = mergeSharded(partials, threads);
+        if (spectrum != nullptr) {
+            spectrum->recordTable(counter);
+        }
+        return counter;
+    }
+
+    auto countChunk = chunkCounter(script);
+    WordCounter counter = countStream(fileName, blockSize, threads, wordBytePredicate(script), countChunk, bytesRead);
+    if (spectrum != nullptr) {
+        spectrum->recordTable(counter);
+    }
+    return counter;
+}
+
+} // namespace corpus
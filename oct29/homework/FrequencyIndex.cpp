@@ -0,0 +1,208 @@
+#include "../include/FrequencyIndex.h"
+#include "../include/TokenStream.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace corpus {
+
+namespace {
+
+constexpr char indexMagic[8] = {'C', 'O', 'R', 'P', 'I', 'D', 'X', '\0'};
+constexpr std::uint32_t byteOrderMark = 0x01020304;
+
+bool byWord(const WordCounter::Entry& a, const WordCounter::Entry& b) {
+    return a.word < b.word;
+}
+
+template <typename T>
+void writeValue(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Writes entries that are already sorted by word. The file is written next
+// to the target and renamed over it, so a reader maps either the old index
+// or the new one, never a partial file.
+bool writeSorted(const std::string& fileName, const std::vector<WordCounter::Entry>& entries, Script script,
+                 std::uint64_t totalCount) {
+    std::string temporary = fileName + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Error opening file: " << temporary << std::endl;
+        return false;
+    }
+
+    IndexHeader header{};
+    std::memcpy(header.magic, indexMagic, sizeof(indexMagic));
+    header.version = FrequencyIndex::currentVersion;
+    header.byteOrder = byteOrderMark;
+    header.script = static_cast<std::uint32_t>(script);
+    header.wordCount = entries.size();
+    header.totalCount = totalCount;
+    for (const WordCounter::Entry& entry : entries) {
+        header.bytesSize += entry.word.size();
+    }
+    writeValue(out, header);
+
+    std::uint64_t offset = 0;
+    writeValue(out, offset);
+    for (const WordCounter::Entry& entry : entries) {
+        offset += entry.word.size();
+        writeValue(out, offset);
+    }
+    for (const WordCounter::Entry& entry : entries) {
+        writeValue(out, entry.count);
+    }
+    for (const WordCounter::Entry& entry : entries) {
+        out.write(entry.word.data(), static_cast<std::streamsize>(entry.word.size()));
+    }
+
+    out.close();
+    if (!out) {
+        std::cerr << "Error: Could not write file " << temporary << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    if (std::rename(temporary.c_str(), fileName.c_str()) != 0) {
+        std::cerr << "Error: Could not replace file " << fileName << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+FrequencyIndex::FrequencyIndex(const std::string& fileName) : file_(fileName) {
+    if (!file_.isOpen()) {
+        return;
+    }
+    const auto* header = reinterpret_cast<const IndexHeader*>(file_.data());
+    if (file_.size() < sizeof(IndexHeader) || std::memcmp(header->magic, indexMagic, sizeof(indexMagic)) != 0) {
+        std::cerr << "Error: " << fileName << " is not a frequency index" << std::endl;
+        return;
+    }
+    if (header->version != currentVersion || header->byteOrder != byteOrderMark) {
+        std::cerr << "Error: " << fileName << " has index version " << header->version
+                  << ", or was written with another byte order" << std::endl;
+        return;
+    }
+    std::uint64_t words = header->wordCount;
+    // bound the header's sizes by the file first, so the sum below cannot wrap
+    std::uint64_t body = file_.size() - sizeof(IndexHeader);
+    bool fits = words <= body / (2 * sizeof(std::uint64_t)) && header->bytesSize <= body;
+    std::uint64_t expected = sizeof(IndexHeader) + (2 * words + 1) * sizeof(std::uint64_t) + header->bytesSize;
+    if (!fits || expected != file_.size()) {
+        std::cerr << "Error: " << fileName << " is truncated or corrupt" << std::endl;
+        return;
+    }
+
+    offsets_ = reinterpret_cast<const std::uint64_t*>(file_.data() + sizeof(IndexHeader));
+    counts_ = offsets_ + words + 1;
+    bytes_ = reinterpret_cast<const char*>(counts_ + words);
+    if (offsets_[words] != header->bytesSize) {
+        std::cerr << "Error: " << fileName << " is truncated or corrupt" << std::endl;
+        return;
+    }
+    header_ = header;
+}
+
+std::uint64_t FrequencyIndex::count(std::string_view word) const {
+    std::size_t low = 0;
+    std::size_t high = size();
+    while (low < high) {
+        std::size_t middle = low + (high - low) / 2;
+        if (this->word(middle) < word) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < size() && this->word(low) == word ? counts_[low] : 0;
+}
+
+WordCounter FrequencyIndex::toCounter() const {
+    WordCounter counter(size());
+    forEach([&](std::string_view word, std::uint64_t count) {
+        counter.add(word, count);
+    });
+    return counter;
+}
+
+bool writeFrequencyIndex(const std::string& fileName, const WordCounter& counter, Script script) {
+    std::vector<WordCounter::Entry> entries = counter.entries();
+    std::sort(entries.begin(), entries.end(), byWord);
+    return writeSorted(fileName, entries, script, counter.totalCount());
+}
+
+bool appendToFrequencyIndex(const std::string& fileName, const WordCounter& counter, Script script) {
+    std::error_code error;
+    if (!std::filesystem::exists(fileName, error)) {
+        return writeFrequencyIndex(fileName, counter, script);
+    }
+    FrequencyIndex index(fileName);
+    if (!index.isOpen()) {
+        return false;
+    }
+    if (index.script() != script) {
+        std::cerr << "Error: " << fileName << " was built with another script" << std::endl;
+        return false;
+    }
+
+    std::vector<WordCounter::Entry> fresh = counter.entries();
+    std::sort(fresh.begin(), fresh.end(), byWord);
+
+    // both sides are sorted, so one linear merge folds the new counts in
+    std::vector<WordCounter::Entry> merged;
+    merged.reserve(index.size() + fresh.size());
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < index.size() || j < fresh.size()) {
+        if (j == fresh.size() || (i < index.size() && index.word(i) < fresh[j].word)) {
+            merged.push_back({index.word(i), index.countAt(i)});
+            ++i;
+        } else if (i == index.size() || fresh[j].word < index.word(i)) {
+            merged.push_back(fresh[j]);
+            ++j;
+        } else {
+            merged.push_back({fresh[j].word, index.countAt(i) + fresh[j].count});
+            ++i;
+            ++j;
+        }
+    }
+    return writeSorted(fileName, merged, script, index.totalCount() + counter.totalCount());
+}
+
+int runIndexAppend(const Options& options, Script script) {
+    WordCounter counter;
+    if (!options.tokens.empty() || !options.saveTokens.empty()) {
+        // the saved stream is folded in as it is, or the input is saved on the way
+        TokenStream tokens;
+        if (!readTokens(options, script, tokens)) {
+            return 1;
+        }
+        counter = tokens.toCounter();
+    } else if (options.stream) {
+        counter = countWordsStreaming(options.inputFile, options.blockSize, script, options.threads);
+    } else {
+        MappedFile book(options.inputFile);
+        if (!book.isOpen()) {
+            return 1;
+        }
+        counter = countWords(book.view(), script, options.threads);
+    }
+    if (!appendToFrequencyIndex(options.appendIndex, counter, script)) {
+        return 1;
+    }
+
+    FrequencyIndex index(options.appendIndex);
+    std::cout << "Added " << counter.totalCount() << " words (" << counter.size() << " distinct) to "
+              << options.appendIndex << std::endl;
+    std::cout << "The index now holds " << index.totalCount() << " words, " << index.size() << " distinct" << std::endl;
+    return 0;
+}
+
+} // namespace corpus
@@ -0,0 +1,161 @@
+#include "../include/FrequencySpectrum.h"
+#include <cmath>
+#include <limits>
+#include <map>
+
+namespace corpus {
+
+FrequencySpectrum::FrequencySpectrum(std::uint64_t listedClasses)
+    : listedClasses_(std::min(listedClasses, exactLimit)), classes_(exactLimit + 2, 0), listed_(listedClasses_) {}
+
+void FrequencySpectrum::recordTable(const WordCounter& counter) {
+    counter.forEachRef([&](WordCounter::WordRef word, std::uint64_t count) { record(word, 0, count); });
+}
+
+// Everything record's fast path leaves out: new words, the listed classes,
+// and words crossing exactLimit.
+void FrequencySpectrum::recordMove(WordCounter::WordRef word, std::uint64_t from, std::uint64_t to) {
+    if (from == 0) {
+        ++vocabulary_;
+    }
+    if (from <= exactLimit) {
+        if (from != 0) {
+            --classes_[from];
+        }
+        if (to <= exactLimit) {
+            ++classes_[to];
+        } else {
+            above_.push_back(word);
+        }
+    }
+    if (from <= listedClasses_ || to <= listedClasses_) {
+        moveListed(word, from, to);
+    }
+}
+
+void FrequencySpectrum::moveListed(WordCounter::WordRef word, std::uint64_t from, std::uint64_t to) {
+    if (from != 0 && from <= listedClasses_) {
+        // swap-remove: the last word of the class takes this one's place
+        std::vector<WordCounter::WordRef>& list = listed_[from - 1];
+        std::uint32_t position = listPositions_[word.id];
+        list[position] = list.back();
+        listPositions_[list[position].id] = position;
+        list.pop_back();
+    }
+    if (to <= listedClasses_) {
+        if (word.id >= listPositions_.size()) {
+            listPositions_.resize(std::max<std::size_t>(word.id + 1, 2 * listPositions_.size()));
+        }
+        std::vector<WordCounter::WordRef>& list = listed_[to - 1];
+        listPositions_[word.id] = static_cast<std::uint32_t>(list.size());
+        list.push_back(word);
+    }
+}
+
+void FrequencySpectrum::WideSum::addWideProduct(std::uint64_t a, std::uint64_t b) {
+    // schoolbook multiplication on 32-bit halves
+    std::uint64_t aLow = a & 0xFFFFFFFF;
+    std::uint64_t aHigh = a >> 32;
+    std::uint64_t bLow = b & 0xFFFFFFFF;
+    std::uint64_t bHigh = b >> 32;
+    std::uint64_t lowLow = aLow * bLow;
+    std::uint64_t highLow = aHigh * bLow;
+    std::uint64_t lowHigh = aLow * bHigh;
+    std::uint64_t middle = (lowLow >> 32) + (highLow & 0xFFFFFFFF) + (lowHigh & 0xFFFFFFFF);
+    std::uint64_t productLow = (middle << 32) | (lowLow & 0xFFFFFFFF);
+    std::uint64_t productHigh = aHigh * bHigh + (highLow >> 32) + (lowHigh >> 32) + (middle >> 32);
+    add(productLow);
+    high += productHigh;
+}
+
+double FrequencySpectrum::WideSum::minus(std::uint64_t value) const {
+    std::uint64_t resultLow = low - value;
+    std::uint64_t resultHigh = high - (low < value);
+    return static_cast<double>(resultHigh) * 18446744073709551616.0 + static_cast<double>(resultLow);
+}
+
+std::uint64_t FrequencySpectrum::wordsWithFrequency(std::uint64_t m, const WordCounter& counter) const {
+    if (m <= exactLimit) {
+        return wordsWithFrequency(m);
+    }
+    std::uint64_t words = 0;
+    for (WordCounter::WordRef word : above_) {
+        words += counter.count(counter.word(word)) == m;
+    }
+    return words;
+}
+
+const std::vector<WordCounter::WordRef>& FrequencySpectrum::wordsOf(std::uint64_t m) const {
+    static const std::vector<WordCounter::WordRef> none;
+    return m != 0 && m <= listedClasses_ ? listed_[m - 1] : none;
+}
+
+std::vector<SpectrumClass> FrequencySpectrum::classes(const WordCounter& counter) const {
+    std::vector<SpectrumClass> spectrum;
+    for (std::uint64_t m = 1; m <= exactLimit; ++m) {
+        if (classes_[m] != 0) {
+            spectrum.push_back(SpectrumClass{m, classes_[m]});
+        }
+    }
+    std::map<std::uint64_t, std::uint64_t> high;
+    for (WordCounter::WordRef word : above_) {
+        ++high[counter.count(counter.word(word))];
+    }
+    for (const auto& [frequency, words] : high) {
+        spectrum.push_back(SpectrumClass{frequency, words});
+    }
+    return spectrum;
+}
+
+double FrequencySpectrum::goodTuringCount(std::uint64_t r) const {
+    std::uint64_t seen = wordsWithFrequency(r);
+    std::uint64_t next = wordsWithFrequency(r + 1);
+    if (seen == 0 || next == 0) {
+        return static_cast<double>(r);
+    }
+    return static_cast<double>(r + 1) * static_cast<double>(next) / static_cast<double>(seen);
+}
+
+double FrequencySpectrum::unseenProbability() const {
+    return tokens_ == 0 ? 0.0 : static_cast<double>(hapaxLegomena()) / static_cast<double>(tokens_);
+}
+
+double FrequencySpectrum::typeTokenRatio() const {
+    return tokens_ == 0 ? 0.0 : static_cast<double>(vocabulary_) / static_cast<double>(tokens_);
+}
+
+double FrequencySpectrum::yulesK() const {
+    if (tokens_ == 0) {
+        return 0.0;
+    }
+    double n = static_cast<double>(tokens_);
+    return 1e4 * squares_.minus(tokens_) / (n * n);
+}
+
+double FrequencySpectrum::honoresR() const {
+    if (vocabulary_ == 0) {
+        return 0.0;
+    }
+    if (hapaxLegomena() == vocabulary_) {
+        return std::numeric_limits<double>::infinity();
+    }
+    double share = static_cast<double>(hapaxLegomena()) / static_cast<double>(vocabulary_);
+    return 100.0 * std::log(static_cast<double>(tokens_)) / (1.0 - share);
+}
+
+double FrequencySpectrum::sichelsS() const {
+    return vocabulary_ == 0 ? 0.0 : static_cast<double>(disLegomena()) / static_cast<double>(vocabulary_);
+}
+
+double FrequencySpectrum::brunetsW() const {
+    if (vocabulary_ == 0) {
+        return 0.0;
+    }
+    return std::pow(static_cast<double>(tokens_), std::pow(static_cast<double>(vocabulary_), -0.165));
+}
+
+double FrequencySpectrum::herdansC() const {
+    return tokens_ <= 1 ? 0.0 : std::log(static_cast<double>(vocabulary_)) / std::log(static_cast<double>(tokens_));
+}
+
+} // namespace corpus
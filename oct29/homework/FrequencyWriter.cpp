@@ -0,0 +1,234 @@
+#include "../include/FrequencyWriter.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+namespace corpus {
+
+namespace {
+
+constexpr char columnarMagic[8] = {'C', 'O', 'R', 'P', 'C', 'O', 'L', '\0'};
+constexpr std::uint32_t byteOrderMark = 0x01020304;
+
+// CSV fields only need quotes when they hold a separator, a quote or a line break
+void writeCsvField(BufferedWriter& out, std::string_view field) {
+    if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out.write(field);
+        return;
+    }
+    out.put('"');
+    std::size_t start = 0;
+    for (std::size_t quote = field.find('"'); quote != std::string_view::npos; quote = field.find('"', start)) {
+        out.write(field.substr(start, quote + 1 - start));
+        out.put('"');
+        start = quote + 1;
+    }
+    out.write(field.substr(start));
+    out.put('"');
+}
+
+// Ranked entries point into the counter's arena in table order, so the
+// words are fetched a few rows ahead instead of missing the cache per row.
+constexpr std::size_t prefetchDistance = 16;
+
+template <typename Ranked>
+void prefetchWord(const Ranked& ranked, std::size_t row, std::size_t rows) {
+    if (row + prefetchDistance < rows) {
+        __builtin_prefetch(ranked.begin()[row + prefetchDistance].word.data());
+    }
+}
+
+template <typename Ranked>
+void writeDelimited(BufferedWriter& out, const Ranked& ranked, std::uint64_t rows, char separator) {
+    std::uint64_t rank = 1;
+    for (const WordCounter::Entry& entry : ranked) {
+        prefetchWord(ranked, rank - 1, rows);
+        out.writeUnsigned(rank++);
+        out.put(separator);
+        out.writeUnsigned(entry.count);
+        out.put(separator);
+        if (separator == ',') {
+            writeCsvField(out, entry.word);
+        } else {
+            out.write(entry.word);
+        }
+        out.put('\n');
+    }
+}
+
+template <typename Ranked>
+void writeColumnar(BufferedWriter& out, const Ranked& ranked, std::uint64_t rows) {
+    ColumnarHeader header{};
+    std::memcpy(header.magic, columnarMagic, sizeof(columnarMagic));
+    header.version = 1;
+    header.byteOrder = byteOrderMark;
+    header.rowCount = rows;
+    for (const WordCounter::Entry& entry : ranked) {
+        header.bytesSize += entry.word.size();
+    }
+    out.writeRaw(header);
+    for (const WordCounter::Entry& entry : ranked) {
+        out.writeRaw(entry.count);
+    }
+    std::uint64_t offset = 0;
+    out.writeRaw(offset);
+    for (const WordCounter::Entry& entry : ranked) {
+        offset += entry.word.size();
+        out.writeRaw(offset);
+    }
+    std::uint64_t row = 0;
+    for (const WordCounter::Entry& entry : ranked) {
+        prefetchWord(ranked, row++, rows);
+        out.write(entry.word);
+    }
+}
+
+template <typename Ranked>
+bool writeRanked(const Ranked& ranked, std::uint64_t rows, const std::string& fileName, OutputFormat format) {
+    BufferedWriter out(fileName);
+    if (!out.isOpen()) {
+        return false;
+    }
+    switch (format) {
+    case OutputFormat::Text:
+        writeDelimited(out, ranked, rows, ' ');
+        break;
+    case OutputFormat::Tsv:
+        out.write("rank\tcount\tword\n");
+        writeDelimited(out, ranked, rows, '\t');
+        break;
+    case OutputFormat::Csv:
+        out.write("rank,count,word\n");
+        writeDelimited(out, ranked, rows, ',');
+        break;
+    case OutputFormat::Columnar:
+        writeColumnar(out, ranked, rows);
+        break;
+    }
+    return out.close();
+}
+
+} // namespace
+
+BufferedWriter::BufferedWriter(const std::string& fileName, std::size_t bufferSize)
+    : fileName_(fileName), buffer_(bufferSize < 64 ? 64 : bufferSize), pending_(buffer_.size()) {
+    fd_ = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "Error opening file: " << fileName << std::endl;
+        failed_ = true;
+        return;
+    }
+    thread_ = std::thread([this] { run(); });
+}
+
+BufferedWriter::~BufferedWriter() {
+    close();
+}
+
+void BufferedWriter::writeSlow(std::string_view bytes) {
+    while (!bytes.empty()) {
+        std::size_t room = buffer_.size() - used_;
+        if (room == 0) {
+            handOff();
+            continue;
+        }
+        std::size_t part = bytes.size() < room ? bytes.size() : room;
+        std::memcpy(buffer_.data() + used_, bytes.data(), part);
+        used_ += part;
+        bytes.remove_prefix(part);
+    }
+}
+
+void BufferedWriter::handOff() {
+    if (fd_ < 0) {
+        used_ = 0;
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    changed_.wait(lock, [this] { return !hasPending_; });
+    buffer_.swap(pending_);
+    pendingSize_ = used_;
+    hasPending_ = true;
+    used_ = 0;
+    changed_.notify_all();
+}
+
+void BufferedWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        changed_.wait(lock, [this] { return hasPending_ || done_; });
+        if (!hasPending_) {
+            return;
+        }
+        // the caller does not touch pending_ until hasPending_ is cleared
+        lock.unlock();
+        const char* data = pending_.data();
+        std::size_t left = pendingSize_;
+        bool failed = false;
+        while (left > 0) {
+            ssize_t written = ::write(fd_, data, left);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                failed = true;
+                break;
+            }
+            data += written;
+            left -= static_cast<std::size_t>(written);
+        }
+        lock.lock();
+        failed_ = failed_ || failed;
+        hasPending_ = false;
+        changed_.notify_all();
+    }
+}
+
+bool BufferedWriter::close() {
+    if (!thread_.joinable()) {
+        return !failed_;
+    }
+    if (used_ > 0) {
+        handOff();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+    if (::close(fd_) != 0) {
+        failed_ = true;
+    }
+    fd_ = -1;
+    if (failed_) {
+        std::cerr << "Error: Could not write file " << fileName_ << std::endl;
+    }
+    return !failed_;
+}
+
+bool parseOutputFormat(std::string_view name, OutputFormat& format) {
+    if (name == "text") {
+        format = OutputFormat::Text;
+    } else if (name == "tsv") {
+        format = OutputFormat::Tsv;
+    } else if (name == "csv") {
+        format = OutputFormat::Csv;
+    } else if (name == "columnar") {
+        format = OutputFormat::Columnar;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool writeFrequencies(const std::vector<WordCounter::Entry>& ranked, const std::string& fileName, OutputFormat format) {
+    return writeRanked(ranked, ranked.size(), fileName, format);
+}
+
+bool writeFrequencies(const RankIndex& ranks, const std::string& fileName, OutputFormat format) {
+    return writeRanked(ranks, ranks.size(), fileName, format);
+}
+
+} // namespace corpus
@@ -0,0 +1,392 @@
+#include "../include/NgramCount.h"
+#include "../include/BlockReader.h"
+#include "../include/MappedFile.h"
+#include "../include/Profile.h"
+#include "../include/RankIndex.h"
+#include "../include/ZipfPlot.h"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <utility>
+
+namespace corpus {
+
+namespace {
+
+// N-grams are added this many tokens after their slot is prefetched.
+constexpr std::size_t insertDelay = 16;
+
+// The last words seen, carried from one piece of text to the next, and the
+// n-grams waiting for their prefetched slots.
+struct Window {
+    std::uint32_t ids[3] = {0, 0, 0};
+    std::uint64_t seen = 0;
+    NgramKey pending[insertDelay];
+    std::uint64_t hashes[insertDelay];
+    std::size_t queued = 0;
+};
+
+// A chunk counted on its own misses the n-grams that start in the chunks
+// before it; its first and last order - 1 words are enough to add them.
+struct ChunkEdges {
+    std::vector<std::string> head;
+    std::vector<std::string> tail;
+    std::uint64_t words = 0;
+};
+
+// Slides the window over one more word. The n-gram it completes is hashed
+// and its slot prefetched now, but only added insertDelay n-grams later.
+inline void push(Window& window, std::uint32_t id, unsigned order, NgramTable& table) {
+    window.ids[0] = window.ids[1];
+    window.ids[1] = window.ids[2];
+    window.ids[2] = id;
+    if (++window.seen < order) {
+        return;
+    }
+    NgramKey key = packNgram(window.ids + 3 - order, order);
+    std::uint64_t hash = hashNgram(key);
+    table.prefetch(hash);
+    std::size_t at = window.queued % insertDelay;
+    if (window.queued >= insertDelay) {
+        table.addHashed(window.pending[at], window.hashes[at]);
+    }
+    window.pending[at] = key;
+    window.hashes[at] = hash;
+    ++window.queued;
+}
+
+// Adds the n-grams still waiting in the window.
+void flush(Window& window, NgramTable& table) {
+    for (std::size_t i = 0; i < std::min(window.queued, insertDelay); ++i) {
+        table.addHashed(window.pending[i], window.hashes[i]);
+    }
+    window.queued = 0;
+}
+
+void countNgramsInto(Script script, std::string_view text, unsigned order, WordIds& words, NgramTable& table,
+                     Window& window) {
+    forEachWord(script, text, [&](std::string_view word) {
+        push(window, words.id(word), order, table);
+    });
+    flush(window, table);
+}
+
+void countChunk(Script script, std::string_view chunk, unsigned order, NgramCounts& partial, ChunkEdges& edges) {
+    Window window;
+    std::size_t edge = order - 1;
+    edges.head.clear();
+    forEachWord(script, chunk, [&](std::string_view word) {
+        if (edges.head.size() < edge) {
+            edges.head.emplace_back(word);
+        }
+        push(window, partial.words.id(word), order, partial.table);
+    });
+    flush(window, partial.table);
+    edges.words = window.seen;
+    edges.tail.clear();
+    std::uint64_t kept = std::min<std::uint64_t>(window.seen, edge);
+    for (std::uint64_t i = 3 - kept; i < 3; ++i) {
+        edges.tail.emplace_back(partial.words.word(window.ids[i]));
+    }
+}
+
+// Adds the n-grams that straddle chunk boundaries, walking the chunks in text order.
+class Stitcher {
+public:
+    Stitcher(unsigned order, WordIds& words, NgramTable& table) : order_(order), words_(words), table_(table) {}
+
+    void add(const ChunkEdges& edges) {
+        std::size_t edge = order_ - 1;
+        std::vector<std::uint32_t> sequence = window_;
+        std::size_t before = sequence.size();
+        for (const std::string& word : edges.head) {
+            sequence.push_back(words_.id(word));
+        }
+        // n-grams ending on one of the chunk's first words that begin before it
+        for (std::size_t end = before; end < sequence.size(); ++end) {
+            if (end + 1 >= order_ && end + 1 - order_ < before) {
+                table_.add(packNgram(sequence.data() + end + 1 - order_, order_));
+            }
+        }
+        if (edges.words >= edge) {
+            window_.clear();
+            for (const std::string& word : edges.tail) {
+                window_.push_back(words_.id(word));
+            }
+        } else {
+            // a chunk shorter than the window: its words all sit in head
+            window_ = sequence;
+            if (window_.size() > edge) {
+                window_.erase(window_.begin(), window_.end() - edge);
+            }
+        }
+    }
+
+private:
+    unsigned order_;
+    WordIds& words_;
+    NgramTable& table_;
+    std::vector<std::uint32_t> window_;
+};
+
+// Translates every partial to the dictionary of result and merges the tables
+// in hash shards, one thread per shard, as mergeSharded does for words.
+void mergeInto(NgramCounts& result, const std::vector<NgramCounts>& partials, unsigned threads) {
+    std::vector<std::vector<std::uint32_t>> remap(partials.size());
+    std::size_t largest = result.table.size();
+    for (std::size_t p = 0; p < partials.size(); ++p) {
+        const WordIds& local = partials[p].words;
+        remap[p].resize(local.size());
+        for (std::uint32_t id = 0; id < local.size(); ++id) {
+            remap[p][id] = result.words.id(local.word(id));
+        }
+        largest = std::max(largest, partials[p].table.size());
+    }
+
+    std::size_t shardCount = std::max(1u, threads);
+    std::vector<NgramTable> shards;
+    shards.reserve(shardCount);
+    for (std::size_t s = 0; s < shardCount; ++s) {
+        shards.emplace_back(largest / shardCount + 1);
+    }
+    unsigned order = result.order;
+    auto mergeShard = [&](std::size_t s, const NgramTable& table, const std::vector<std::uint32_t>* ids) {
+        table.forEach([&](NgramKey key, std::uint64_t count) {
+            std::uint32_t global[3] = {key.id(0), key.id(1), key.id(2)};
+            if (ids != nullptr) {
+                for (unsigned i = 0; i < order; ++i) {
+                    global[i] = (*ids)[global[i]];
+                }
+            }
+            NgramKey mapped = packNgram(global, order);
+            std::uint64_t hash = hashNgram(mapped);
+            if ((hash >> 40) % shardCount == s) {
+                shards[s].addHashed(mapped, hash, count);
+            }
+        });
+    };
+    std::vector<std::thread> mergers;
+    mergers.reserve(shardCount);
+    for (std::size_t s = 0; s < shardCount; ++s) {
+        mergers.emplace_back([&, s] {
+            // the result so far holds the straddling n-grams, already in global IDs
+            mergeShard(s, result.table, nullptr);
+            for (std::size_t p = 0; p < partials.size(); ++p) {
+                mergeShard(s, partials[p].table, &remap[p]);
+            }
+        });
+    }
+    for (std::thread& merger : mergers) {
+        merger.join();
+    }
+
+    std::size_t distinct = 0;
+    for (const NgramTable& shard : shards) {
+        distinct += shard.size();
+    }
+    NgramTable merged(distinct);
+    for (const NgramTable& shard : shards) {
+        shard.forEach([&](NgramKey key, std::uint64_t count) { merged.add(key, count); });
+    }
+    result.table = std::move(merged);
+}
+
+NgramCounts emptyCounts(unsigned order) {
+    NgramCounts counts;
+    counts.order = order;
+    return counts;
+}
+
+} // namespace
+
+NgramTable::NgramTable(std::size_t expected) {
+    std::size_t capacity = 16;
+    while (capacity * 3 < expected * 4) {
+        capacity *= 2;
+    }
+    slots_.assign(capacity, Slot{0, 0, 0, 0});
+    mask_ = capacity - 1;
+}
+
+void NgramTable::grow() {
+    std::vector<Slot> old(slots_.size() * 2, Slot{0, 0, 0, 0});
+    old.swap(slots_);
+    mask_ = slots_.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.count == 0) {
+            continue;
+        }
+        std::size_t i = slot.hash & mask_;
+        while (slots_[i].count != 0) {
+            i = (i + 1) & mask_;
+        }
+        slots_[i] = slot;
+    }
+}
+
+std::uint64_t NgramTable::count(NgramKey key) const {
+    std::uint64_t hash = hashNgram(key);
+    std::size_t i = hash & mask_;
+    while (slots_[i].count != 0) {
+        const Slot& slot = slots_[i];
+        if (slot.head == key.head && slot.tail == key.tail) {
+            return slot.count;
+        }
+        i = (i + 1) & mask_;
+    }
+    return 0;
+}
+
+WordCounter NgramCounts::spell(std::size_t top) const {
+    std::uint64_t threshold = 1;
+    if (top > 0 && top < table.size()) {
+        std::vector<std::uint64_t> counts;
+        counts.reserve(table.size());
+        table.forEach([&](NgramKey, std::uint64_t count) { counts.push_back(count); });
+        std::nth_element(counts.begin(), counts.begin() + (top - 1), counts.end(), std::greater<>());
+        threshold = counts[top - 1];
+    }
+
+    WordCounter spelled(top > 0 ? std::min(top, table.size()) : table.size());
+    std::string text;
+    table.forEach([&](NgramKey key, std::uint64_t count) {
+        if (count < threshold) {
+            return;
+        }
+        text.clear();
+        for (unsigned i = 0; i < order; ++i) {
+            if (i > 0) {
+                text += ' ';
+            }
+            text += words.word(key.id(i));
+        }
+        spelled.add(text, count);
+    });
+    return spelled;
+}
+
+NgramCounts countNgrams(std::string_view text, Script script, unsigned order, unsigned threads) {
+    threads = resolveThreads(threads);
+    NgramCounts result = emptyCounts(order);
+    std::vector<std::string_view> chunks = splitAtWordBoundaries(text, threads, wordBytePredicate(script));
+    if (chunks.size() <= 1) {
+        Window window;
+        countNgramsInto(script, text, order, result.words, result.table, window);
+        return result;
+    }
+
+    std::vector<NgramCounts> partials(chunks.size(), emptyCounts(order));
+    std::vector<ChunkEdges> edges(chunks.size());
+    runOnChunks(chunks, [&](std::size_t i, std::string_view chunk) {
+        countChunk(script, chunk, order, partials[i], edges[i]);
+    });
+    Stitcher stitcher(order, result.words, result.table);
+    for (const ChunkEdges& chunkEdges : edges) {
+        stitcher.add(chunkEdges);
+    }
+    mergeInto(result, partials, threads);
+    return result;
+}
+
+NgramCounts countNgramsStreaming(const std::string& fileName, std::size_t blockSize, Script script, unsigned order,
+                                 unsigned threads, std::uint64_t* bytesRead) {
+    threads = resolveThreads(threads);
+    WordBytePredicate isWordByte = wordBytePredicate(script);
+    NgramCounts result = emptyCounts(order);
+    // each worker keeps its own dictionary and table for the whole stream
+    std::vector<NgramCounts> partials(threads > 1 ? threads : 0, emptyCounts(order));
+    std::vector<ChunkEdges> edges(threads);
+    Stitcher stitcher(order, result.words, result.table);
+    Window window;
+    BlockReader reader(fileName, blockSize, isWordByte);
+    std::string_view block;
+    while (reader.next(block)) {
+        if (threads == 1) {
+            // the window carries the last words over to the next block
+            countNgramsInto(script, block, order, result.words, result.table, window);
+            continue;
+        }
+        std::vector<std::string_view> chunks = splitAtWordBoundaries(block, threads, isWordByte);
+        runOnChunks(chunks, [&](std::size_t i, std::string_view chunk) {
+            countChunk(script, chunk, order, partials[i], edges[i]);
+        });
+        for (std::size_t i = 0; i < chunks.size(); ++i) {
+            stitcher.add(edges[i]);
+        }
+    }
+    if (bytesRead != nullptr) {
+        *bytesRead = reader.bytesRead();
+    }
+    if (threads > 1) {
+        mergeInto(result, partials, threads);
+    }
+    return result;
+}
+
+NgramCounts countNgrams(const TokenStream& tokens, unsigned order) {
+    NgramCounts result = emptyCounts(order);
+    result.words = tokens.vocabulary();
+    Window window;
+    for (std::uint32_t id : tokens) {
+        push(window, id, order, result.table);
+    }
+    flush(window, result.table);
+    return result;
+}
+
+int runNgrams(const Options& options, Script script) {
+    RunProfile profile("ngrams");
+    profile.setInput(options.inputFile, options.threads);
+    profile.begin("count");
+    std::uint64_t bytes = 0;
+    bool read = true;
+    NgramCounts counts = [&] {
+        if (!options.tokens.empty() || !options.saveTokens.empty()) {
+            TokenStream tokens;
+            if (!readTokens(options, script, tokens)) {
+                read = false;
+                return emptyCounts(options.ngram);
+            }
+            bytes = tokens.bytesProcessed();
+            return countNgrams(tokens, options.ngram);
+        }
+        if (options.stream) {
+            return countNgramsStreaming(options.inputFile, options.blockSize, script, options.ngram, options.threads,
+                                        &bytes);
+        }
+        MappedFile book(options.inputFile);
+        bytes = book.view().size();
+        return countNgrams(book.view(), script, options.ngram, options.threads);
+    }();
+    if (!read) {
+        return 1;
+    }
+    profile.addWork(bytes, counts.table.totalCount());
+
+    std::cout << "Total number of " << options.ngram << "-grams: " << counts.table.totalCount() << std::endl;
+    std::cout << "Number of unique " << options.ngram << "-grams: " << counts.table.size() << " (over "
+              << counts.words.size() << " distinct words)" << std::endl;
+
+    profile.begin("rank");
+    WordCounter spelled = counts.spell(options.top);
+    RankIndex ranks = options.top > 0 ? RankIndex::top(spelled, options.top) : RankIndex(spelled);
+
+    profile.begin("write");
+    if (!writeFrequencies(ranks, options.outputFile, options.format)) {
+        return 1;
+    }
+    std::cout << options.ngram << "-gram frequencies have been written to " << options.outputFile << std::endl;
+
+    if (!options.plotFile.empty()) {
+        profile.begin("plot");
+        std::string title = std::to_string(options.ngram) + "-gram Frequency Distribution (Log-Log Scale)";
+        exportZipfPlot(ranks, options.plotFile, title);
+    }
+    if (!options.profile.empty() && profile.writeJson(options.profile)) {
+        std::cout << "Run profile has been written to " << options.profile << std::endl;
+    }
+    return 0;
+}
+
+} // namespace corpus
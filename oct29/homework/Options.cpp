@@ -0,0 +1,334 @@
+#include "../include/Options.h"
+#include <initializer_list>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace corpus {
+
+namespace {
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--threads N] [--stream] [--block-size BYTES] [--top K] [--normalize]\n"
+              << "       [--batch DIR|LIST] [--out-dir DIR] [--split-size BYTES]\n"
+              << "       [--approximate] [--distinct-error E] [--frequency-error E]\n"
+              << "       [--save-index FILE] [--append-index FILE] [--format FORMAT] [--profile FILE]\n"
+              << "       [--plot FILE] [--heaps] [--ngram N] [--save-tokens FILE] [--tokens FILE]\n"
+              << "       [--serve SOCKET] [--sections] [--section-marker TEXT] [--engine ENGINE] [input [output]]\n"
+              << "  --threads N         count with N threads (0 = all hardware threads)\n"
+              << "  --stream            read the input in blocks, memory stays proportional to the vocabulary;\n"
+              << "                      a reader thread reads ahead while the current block is counted\n"
+              << "  --block-size BYTES  block size for --stream (default 1048576)\n"
+              << "  --top K             only rank and write the K most frequent words\n"
+              << "  --normalize         Arabic: drop diacritics and tatweel, fold alef variants\n"
+              << "  --batch DIR|LIST    count every book of a directory or list file (one path per line);\n"
+              << "                      the only positional argument is then the merged output\n"
+              << "  --out-dir DIR       where --batch writes one table per book (default .)\n"
+              << "  --split-size BYTES  --batch splits books larger than this into pieces (default 8388608)\n"
+              << "  --approximate       estimate unique words (HyperLogLog) and the top words (Count-Min)\n"
+              << "                      in fixed memory; --top sets how many words are kept (default 100)\n"
+              << "  --distinct-error E  relative standard error of the unique-word estimate (default 0.01)\n"
+              << "  --frequency-error E overcount bound of a word count, as a fraction of all words (default 0.0001)\n"
+              << "  --save-index FILE   also write the counts as a binary, memory-mappable index\n"
+              << "  --append-index FILE only fold the counts of the input into an existing index\n"
+              << "  --format FORMAT     layout of the frequency tables: text (default), tsv, csv or columnar\n"
+              << "  --profile FILE      write wall/CPU time, throughput, allocations and peak memory\n"
+              << "                      of every milestone as a JSON report\n"
+              << "  --plot FILE         headless plot: fit Zipf and Zipf-Mandelbrot to the log-binned ranks,\n"
+              << "                      write the chart (.svg, or .png through Matplot++) and FILE's .csv\n"
+              << "  --heaps             record vocabulary size at log-spaced token counts while counting,\n"
+              << "                      fit Heaps' law V = K n^beta and write both to OUTPUT's .heaps.csv\n"
+              << "  --ngram N           count bigrams (2) or trigrams (3) instead of words\n"
+              << "  --save-tokens FILE  also save the input as a dictionary-encoded token stream\n"
+              << "  --tokens FILE       count a saved token stream instead of tokenizing the input\n"
+              << "  --serve SOCKET      treat the input as a frequency index (--save-index) and answer\n"
+              << "                      rank, frequency and top-K queries on this Unix socket\n"
+              << "  --sections          split the input at section headers and count every section in parallel,\n"
+              << "                      writing the global table and each section's table to OUTPUT's .sections.tsv\n"
+              << "  --section-marker TEXT  word that opens a section header (repeatable, implies --sections;\n"
+              << "                      default: the Arabic tool uses سورة, the others CHAPTER)\n"
+              << "  --engine ENGINE     count a mapped book with the hash table (hash, default) or by\n"
+              << "                      radix sorting every token and counting the runs (sort)\n"
+              << "  input '-'           read standard input (implies --stream)" << std::endl;
+}
+
+template <typename Unsigned>
+bool parseUnsigned(const char* text, Unsigned& value) {
+    try {
+        std::size_t used = 0;
+        unsigned long long parsed = std::stoull(text, &used);
+        if (text[used] != '\0' || text[0] == '-') {
+            return false;
+        }
+        value = static_cast<Unsigned>(parsed);
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool parseFraction(const char* text, double& value) {
+    try {
+        std::size_t used = 0;
+        double parsed = std::stod(text, &used);
+        if (text[used] != '\0' || !(parsed > 0 && parsed < 1)) {
+            return false;
+        }
+        value = parsed;
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// An option the chosen mode would silently drop, and whether it was given.
+struct Dropped {
+    bool given;
+    const char* name;
+};
+
+// Refuses a mode combined with options it does not honor, naming the ones that were given.
+bool refuseDropped(const char* mode, std::initializer_list<Dropped> options, const char* program) {
+    std::string given;
+    for (const Dropped& option : options) {
+        if (option.given) {
+            given += given.empty() ? "" : ", ";
+            given += option.name;
+        }
+    }
+    if (given.empty()) {
+        return true;
+    }
+    std::cerr << "Error: " << mode << " cannot be combined with " << given << std::endl;
+    printUsage(program);
+    return false;
+}
+
+// A batch writes one ranked table per book and the merged table; nothing else
+// is produced for the merged counts.
+bool checkBatch(const Options& options, const char* program) {
+    if (options.batch.empty()) {
+        return true;
+    }
+    return refuseDropped("--batch",
+                         {{options.stream, "--stream"},
+                          {!options.tokens.empty(), "--tokens"},
+                          {!options.saveTokens.empty(), "--save-tokens"},
+                          {options.heaps, "--heaps"},
+                          {!options.saveIndex.empty(), "--save-index"},
+                          {!options.plotFile.empty(), "--plot"},
+                          {!options.profile.empty(), "--profile"},
+                          {options.approximate, "--approximate"},
+                          {!options.appendIndex.empty(), "--append-index"},
+                          {options.ngram > 1, "--ngram"},
+                          {options.sections, "--sections"},
+                          {!options.serve.empty(), "--serve"}},
+                         program);
+}
+
+// The sketches keep estimates of the top words only, so there is no exact
+// table to save, plot, profile or fold into an index.
+bool checkApproximate(const Options& options, const char* program) {
+    if (!options.approximate) {
+        return true;
+    }
+    return refuseDropped("--approximate",
+                         {{!options.tokens.empty(), "--tokens"},
+                          {!options.saveTokens.empty(), "--save-tokens"},
+                          {options.heaps, "--heaps"},
+                          {!options.saveIndex.empty(), "--save-index"},
+                          {!options.plotFile.empty(), "--plot"},
+                          {!options.profile.empty(), "--profile"},
+                          {!options.appendIndex.empty(), "--append-index"},
+                          {options.ngram > 1, "--ngram"},
+                          {options.sections, "--sections"},
+                          {!options.serve.empty(), "--serve"}},
+                         program);
+}
+
+// An append only folds the counts into the index; nothing is ranked or reported.
+bool checkAppend(const Options& options, const char* program) {
+    if (options.appendIndex.empty()) {
+        return true;
+    }
+    return refuseDropped("--append-index",
+                         {{options.heaps, "--heaps"},
+                          {!options.saveIndex.empty(), "--save-index"},
+                          {!options.plotFile.empty(), "--plot"},
+                          {!options.profile.empty(), "--profile"},
+                          {options.ngram > 1, "--ngram"},
+                          {options.sections, "--sections"},
+                          {!options.serve.empty(), "--serve"}},
+                         program);
+}
+
+// N-grams are ranked and plotted like words, but have no index or growth curve.
+bool checkNgram(const Options& options, const char* program) {
+    if (options.ngram <= 1) {
+        return true;
+    }
+    return refuseDropped("--ngram",
+                         {{!options.saveIndex.empty(), "--save-index"},
+                          {options.heaps, "--heaps"},
+                          {options.sections, "--sections"}},
+                         program);
+}
+
+// The sort engine keeps every token of one mapped book until the end, so the
+// modes that read blocks or need each token as it comes cannot use it.
+bool checkEngine(const Options& options, const char* program) {
+    if (options.engine != CountingEngine::Sort) {
+        return true;
+    }
+    if (options.stream || !options.tokens.empty() || !options.saveTokens.empty() || options.heaps ||
+        !options.batch.empty() || options.approximate || !options.appendIndex.empty() || options.ngram > 1 ||
+        options.sections || !options.serve.empty()) {
+        std::cerr << "Error: --engine sort counts one mapped book; it cannot be combined with --stream, "
+                  << "standard input, --tokens, --save-tokens, --heaps, --batch, --approximate, --append-index, "
+                  << "--ngram, --sections or --serve" << std::endl;
+        printUsage(program);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    std::vector<std::string> positional;
+    bool markersGiven = false;  // the first --section-marker replaces the tool's default markers
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--threads") {
+            if (i + 1 >= argc || !parseUnsigned(argv[++i], options.threads)) {
+                std::cerr << "Error: --threads expects a number" << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--stream") {
+            options.stream = true;
+        } else if (arg == "--block-size") {
+            if (i + 1 >= argc || !parseUnsigned(argv[++i], options.blockSize) || options.blockSize == 0) {
+                std::cerr << "Error: --block-size expects a positive number of bytes" << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--top") {
+            if (i + 1 >= argc || !parseUnsigned(argv[++i], options.top)) {
+                std::cerr << "Error: --top expects a number of words" << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--normalize") {
+            options.normalize = true;
+        } else if (arg == "--heaps") {
+            options.heaps = true;
+        } else if (arg == "--batch" || arg == "--out-dir" || arg == "--save-index" || arg == "--append-index" ||
+                   arg == "--profile" || arg == "--plot" || arg == "--save-tokens" || arg == "--tokens" ||
+                   arg == "--serve") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " expects a path" << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+            std::string& path = arg == "--batch"        ? options.batch
+                              : arg == "--out-dir"      ? options.outputDir
+                              : arg == "--save-index"   ? options.saveIndex
+                              : arg == "--append-index" ? options.appendIndex
+                              : arg == "--profile"      ? options.profile
+                              : arg == "--plot"         ? options.plotFile
+                              : arg == "--save-tokens"  ? options.saveTokens
+                              : arg == "--tokens"       ? options.tokens
+                                                        : options.serve;
+            path = argv[++i];
+        } else if (arg == "--sections") {
+            options.sections = true;
+        } else if (arg == "--section-marker") {
+            if (i + 1 >= argc || argv[i + 1][0] == '\0') {
+                std::cerr << "Error: --section-marker expects a word" << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+            if (!markersGiven) {
+                options.sectionMarkers.clear();
+                markersGiven = true;
+            }
+            options.sectionMarkers.push_back(argv[++i]);
+            options.sections = true;
+        } else if (arg == "--split-size") {
+            if (i + 1 >= argc || !parseUnsigned(argv[++i], options.splitSize) || options.splitSize == 0) {
+                std::cerr << "Error: --split-size expects a positive number of bytes" << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--approximate") {
+            options.approximate = true;
+        } else if (arg == "--distinct-error" || arg == "--frequency-error") {
+            double& value = arg == "--distinct-error" ? options.distinctError : options.frequencyError;
+            if (i + 1 >= argc || !parseFraction(argv[++i], value)) {
+                std::cerr << "Error: " << arg << " expects a number between 0 and 1" << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--ngram") {
+            if (i + 1 >= argc || !parseUnsigned(argv[++i], options.ngram) || options.ngram < 1 || options.ngram > 3) {
+                std::cerr << "Error: --ngram expects 1, 2 or 3" << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--format") {
+            if (i + 1 >= argc || !parseOutputFormat(argv[++i], options.format)) {
+                std::cerr << "Error: --format expects text, tsv, csv or columnar" << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+        } else if (arg == "--engine") {
+            std::string_view name = i + 1 < argc ? argv[++i] : "";
+            if (name != "hash" && name != "sort") {
+                std::cerr << "Error: --engine expects hash or sort" << std::endl;
+                printUsage(argv[0]);
+                return false;
+            }
+            options.engine = name == "sort" ? CountingEngine::Sort : CountingEngine::Hash;
+        } else if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return false;
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << "Error: unknown option " << arg << std::endl;
+            printUsage(argv[0]);
+            return false;
+        } else if (positional.size() < 2) {
+            positional.push_back(argv[i]);
+        } else {
+            std::cerr << "Error: too many arguments" << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    if (!options.batch.empty()) {
+        // the books come from --batch, so a lone argument names the merged table
+        if (positional.size() > 1) {
+            std::cerr << "Error: --batch takes only an output file" << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+        if (!positional.empty()) {
+            options.outputFile = positional[0];
+        }
+        return checkBatch(options, argv[0]) && checkEngine(options, argv[0]);
+    }
+    if (!positional.empty()) {
+        options.inputFile = positional[0];
+    }
+    if (positional.size() > 1) {
+        options.outputFile = positional[1];
+    }
+    if (options.inputFile == "-") {
+        options.stream = true;
+    }
+    return checkApproximate(options, argv[0]) && checkAppend(options, argv[0]) && checkNgram(options, argv[0]) &&
+           checkEngine(options, argv[0]);
+}
+
+} // namespace corpus
@@ -0,0 +1,93 @@
+#include "../include/ParallelCount.h"
+#include <algorithm>
+
+namespace corpus {
+
+unsigned resolveThreads(unsigned requested) {
+    if (requested != 0) {
+        return requested;
+    }
+    unsigned hardware = std::thread::hardware_concurrency();
+    return hardware != 0 ? hardware : 1;
+}
+
+std::vector<std::string_view> splitAtWordBoundaries(std::string_view text, std::size_t parts, WordBytePredicate isWordByte) {
+    std::vector<std::string_view> chunks;
+    if (parts <= 1 || text.empty()) {
+        chunks.push_back(text);
+        return chunks;
+    }
+
+    std::size_t target = text.size() / parts;
+    std::size_t begin = 0;
+    while (begin < text.size()) {
+        // the last chunk takes the remainder, so there are never more than parts
+        std::size_t end = chunks.size() + 1 == parts ? text.size()
+                                                     : std::min(text.size(), begin + std::max<std::size_t>(target, 1));
+        while (end < text.size() && isWordByte(text[end])) {
+            ++end;
+        }
+        chunks.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    return chunks;
+}
+
+WordCounter mergeSharded(const std::vector<WordCounter>& partials, unsigned threads) {
+    std::size_t shardCount = std::max(1u, threads);
+    std::size_t workers = std::min(shardCount, std::max<std::size_t>(partials.size(), 1));
+
+    // one pass over each partial sorts its words into shards; the low hash
+    // bits index the tables, so shard on the high ones
+    struct Hashed {
+        std::string_view word;
+        std::uint64_t hash;
+        std::uint64_t count;
+    };
+    std::vector<std::vector<std::vector<Hashed>>> buckets(partials.size(), std::vector<std::vector<Hashed>>(shardCount));
+    std::vector<std::thread> splitters;
+    splitters.reserve(workers);
+    for (std::size_t w = 0; w < workers; ++w) {
+        splitters.emplace_back([&, w] {
+            for (std::size_t p = w; p < partials.size(); p += workers) {
+                for (std::vector<Hashed>& bucket : buckets[p]) {
+                    bucket.reserve(partials[p].size() / shardCount + 1);
+                }
+                partials[p].forEachHashed([&](std::string_view word, std::uint64_t hash, std::uint64_t count) {
+                    buckets[p][(hash >> 40) % shardCount].push_back({word, hash, count});
+                });
+            }
+        });
+    }
+    for (std::thread& splitter : splitters) {
+        splitter.join();
+    }
+
+    // each shard gathers its buckets from every partial, on its own thread
+    std::vector<WordCounter> shards(shardCount, WordCounter(0));
+    std::vector<std::thread> mergers;
+    mergers.reserve(shardCount);
+    for (std::size_t s = 0; s < shardCount; ++s) {
+        mergers.emplace_back([&, s] {
+            std::size_t largest = 0;
+            for (const auto& partial : buckets) {
+                largest = std::max(largest, partial[s].size());
+            }
+            shards[s] = WordCounter(largest);
+            for (auto& partial : buckets) {
+                for (const Hashed& entry : partial[s]) {
+                    shards[s].addHashed(entry.word, entry.hash, entry.count);
+                }
+                std::vector<Hashed>().swap(partial[s]);
+            }
+        });
+    }
+    for (std::thread& merger : mergers) {
+        merger.join();
+    }
+
+    // the shards share no word, so their slots are moved in without a lookup
+    return WordCounter::concatenate(shards);
+}
+
+} // namespace corpus
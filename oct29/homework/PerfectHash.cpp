@@ -0,0 +1,153 @@
+#include "../include/PerfectHash.h"
+#include <iostream>
+#include <utility>
+
+namespace corpus {
+
+namespace {
+
+constexpr std::size_t maxLevels = 40;
+constexpr std::size_t wordsPerSample = 8;  // one rank sample per 512 bits
+
+// The hash of a key at one level (murmur3 fmix64 of the key and the level).
+inline std::uint64_t levelHash(std::uint64_t hash, std::size_t level) {
+    std::uint64_t h = hash + (level + 1) * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Maps a hash to [0, bits) with a multiply instead of a division: the high
+// 64 bits of hash * bits, from 32-bit halves as standard C++ has no 128-bit type.
+inline std::uint64_t reduce(std::uint64_t hash, std::uint64_t bits) {
+    std::uint64_t high = hash >> 32;
+    std::uint64_t low = hash & 0xFFFFFFFF;
+    if ((bits >> 32) == 0) {
+        // every level of up to two billion keys
+        return (high * bits + ((low * bits) >> 32)) >> 32;
+    }
+    std::uint64_t bitsHigh = bits >> 32;
+    std::uint64_t bitsLow = bits & 0xFFFFFFFF;
+    std::uint64_t highLow = high * bitsLow;
+    std::uint64_t lowHigh = low * bitsHigh;
+    std::uint64_t middle = ((low * bitsLow) >> 32) + (highLow & 0xFFFFFFFF) + (lowHigh & 0xFFFFFFFF);
+    return high * bitsHigh + (highLow >> 32) + (lowHigh >> 32) + (middle >> 32);
+}
+
+} // namespace
+
+bool PerfectHash::build(std::vector<std::uint64_t> hashes, PerfectHash& hash) {
+    std::vector<std::uint64_t> starts{0};
+    std::vector<std::uint64_t> bits;
+    std::size_t keys = hashes.size();
+    for (std::size_t level = 0; !hashes.empty(); ++level) {
+        if (level == maxLevels) {
+            std::cerr << "Error: " << hashes.size() << " words share a 64-bit hash, no perfect hash exists" << std::endl;
+            return false;
+        }
+        // twice as many bits as keys: about 60% of them land alone
+        std::size_t words = (hashes.size() * 2 + 63) / 64;
+        std::uint64_t size = words * 64;
+        std::vector<std::uint64_t> taken(words, 0);
+        std::vector<std::uint64_t> collided(words, 0);
+        for (std::uint64_t h : hashes) {
+            std::uint64_t bit = reduce(levelHash(h, level), size);
+            std::uint64_t mask = 1ULL << (bit % 64);
+            collided[bit / 64] |= taken[bit / 64] & mask;
+            taken[bit / 64] |= mask;
+        }
+        std::size_t next = 0;
+        for (std::uint64_t h : hashes) {
+            std::uint64_t bit = reduce(levelHash(h, level), size);
+            if (collided[bit / 64] & (1ULL << (bit % 64))) {
+                hashes[next++] = h;
+            }
+        }
+        hashes.resize(next);
+        for (std::size_t i = 0; i < words; ++i) {
+            bits.push_back(taken[i] & ~collided[i]);
+        }
+        starts.push_back(bits.size());
+    }
+
+    std::vector<std::uint64_t>& out = hash.owned_;
+    out.clear();
+    out.push_back(keys);
+    out.push_back(starts.size() - 1);
+    out.insert(out.end(), starts.begin(), starts.end());
+    out.insert(out.end(), bits.begin(), bits.end());
+    std::uint64_t kept = 0;
+    for (std::size_t i = 0; i < bits.size(); ++i) {
+        if (i % wordsPerSample == 0) {
+            out.push_back(kept);
+        }
+        kept += static_cast<std::uint64_t>(__builtin_popcountll(bits[i]));
+    }
+    out.push_back(kept);
+    return hash.attach(out.data(), out.size());
+}
+
+bool PerfectHash::attach(const std::uint64_t* words, std::size_t size) {
+    if (size < 3 || words[1] > maxLevels || size < 3 + words[1]) {
+        return false;
+    }
+    std::size_t levels = words[1];
+    const std::uint64_t* starts = words + 2;
+    std::uint64_t bitWords = starts[levels];
+    std::uint64_t samples = (bitWords + wordsPerSample - 1) / wordsPerSample + 1;
+    if (starts[0] != 0 || 2 + (levels + 1) + bitWords + samples != size) {
+        return false;
+    }
+    for (std::size_t level = 0; level < levels; ++level) {
+        if (starts[level + 1] <= starts[level]) {
+            return false;
+        }
+    }
+    const std::uint64_t* bits = starts + levels + 1;
+    const std::uint64_t* ranks = bits + bitWords;
+    // find trusts the samples, so a damaged one must not send a key past size()
+    std::uint64_t kept = 0;
+    for (std::uint64_t i = 0; i < bitWords; ++i) {
+        if (i % wordsPerSample == 0 && ranks[i / wordsPerSample] != kept) {
+            return false;
+        }
+        kept += static_cast<std::uint64_t>(__builtin_popcountll(bits[i]));
+    }
+    if (ranks[samples - 1] != kept || kept != words[0]) {
+        return false;
+    }
+
+    words_ = words;
+    serializedSize_ = size;
+    keys_ = words[0];
+    levels_ = levels;
+    levelStarts_ = starts;
+    bits_ = bits;
+    ranks_ = ranks;
+    return true;
+}
+
+std::size_t PerfectHash::find(std::uint64_t hash) const {
+    for (std::size_t level = 0; level < levels_; ++level) {
+        std::uint64_t size = (levelStarts_[level + 1] - levelStarts_[level]) * 64;
+        std::uint64_t bit = levelStarts_[level] * 64 + reduce(levelHash(hash, level), size);
+        std::uint64_t word = bit / 64;
+        std::uint64_t mask = 1ULL << (bit % 64);
+        if ((bits_[word] & mask) == 0) {
+            continue;
+        }
+        // kept bits before this one: the block's sample, then the words and bits in between
+        std::uint64_t slot = ranks_[word / wordsPerSample];
+        for (std::uint64_t i = word - word % wordsPerSample; i < word; ++i) {
+            slot += static_cast<std::uint64_t>(__builtin_popcountll(bits_[i]));
+        }
+        slot += static_cast<std::uint64_t>(__builtin_popcountll(bits_[word] & (mask - 1)));
+        return static_cast<std::size_t>(slot);
+    }
+    return none;
+}
+
+} // namespace corpus
@@ -0,0 +1,168 @@
+#include "../include/Profile.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+#include <sys/resource.h>
+
+namespace corpus {
+
+namespace {
+
+double milliseconds(const timeval& time) {
+    return time.tv_sec * 1e3 + time.tv_usec / 1e3;
+}
+
+void writeJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+double perSecond(std::uint64_t amount, double ms) {
+    return ms > 0 ? amount / (ms / 1e3) : 0;
+}
+
+std::atomic<bool> counting{false};
+std::atomic<std::uint64_t> allocations{0};
+
+} // namespace
+
+void countAllocations() {
+    counting.store(true, std::memory_order_relaxed);
+}
+
+void noteAllocation() {
+    // the flag is only read, so an unprofiled run never writes the shared counter's cache line
+    if (counting.load(std::memory_order_relaxed)) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+std::uint64_t allocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+std::uint64_t peakMemoryKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<std::uint64_t>(usage.ru_maxrss);  // kB on Linux
+}
+
+RunProfile::RunProfile(std::string tool) : tool_(std::move(tool)), start_(now()), stageStart_(start_) {}
+
+RunProfile::Mark RunProfile::now() const {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    double wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    return {wall, milliseconds(usage.ru_utime) + milliseconds(usage.ru_stime), allocationCount()};
+}
+
+void RunProfile::setInput(const std::string& input, unsigned threads) {
+    input_ = input;
+    threads_ = threads;
+}
+
+void RunProfile::begin(const std::string& stage) {
+    end();
+    StageProfile profile;
+    profile.name = stage;
+    stages_.push_back(profile);
+    open_ = true;
+    stageStart_ = now();
+}
+
+void RunProfile::end() {
+    if (!open_) {
+        return;
+    }
+    Mark mark = now();
+    StageProfile& stage = stages_.back();
+    stage.wallMs = mark.wallMs - stageStart_.wallMs;
+    stage.cpuMs = mark.cpuMs - stageStart_.cpuMs;
+    stage.allocations = mark.allocations - stageStart_.allocations;
+    stage.peakMemoryKb = peakMemoryKb();
+    open_ = false;
+}
+
+void RunProfile::addWork(std::uint64_t bytes, std::uint64_t tokens) {
+    if (stages_.empty()) {
+        return;
+    }
+    stages_.back().bytes += bytes;
+    stages_.back().tokens += tokens;
+}
+
+void RunProfile::setTable(const WordCounter& counter) {
+    vocabulary_ = counter.size();
+    table_ = counter.probeStats();
+}
+
+bool RunProfile::writeJson(const std::string& fileName) {
+    end();
+    Mark mark = now();
+    double wallMs = mark.wallMs - start_.wallMs;
+    std::uint64_t bytes = 0;
+    std::uint64_t tokens = 0;
+    for (const StageProfile& stage : stages_) {
+        bytes += stage.bytes;
+        tokens += stage.tokens;
+    }
+
+    std::ofstream out(fileName);
+    if (!out) {
+        std::cerr << "Error opening file: " << fileName << std::endl;
+        return false;
+    }
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"tool\": ";
+    writeJsonString(out, tool_);
+    out << ",\n  \"input\": ";
+    writeJsonString(out, input_);
+    out << ",\n  \"threads\": " << threads_
+        << ",\n  \"wall_ms\": " << wallMs
+        << ",\n  \"cpu_ms\": " << mark.cpuMs - start_.cpuMs
+        << ",\n  \"bytes\": " << bytes
+        << ",\n  \"tokens\": " << tokens
+        << ",\n  \"tokens_per_second\": " << perSecond(tokens, wallMs)
+        << ",\n  \"allocations\": " << mark.allocations - start_.allocations
+        << ",\n  \"peak_memory_kb\": " << peakMemoryKb()
+        << ",\n  \"hash_table\": {\"words\": " << vocabulary_
+        << ", \"capacity\": " << table_.capacity
+        << ", \"load_factor\": " << table_.loadFactor
+        << ", \"mean_probe_length\": " << table_.meanProbeLength
+        << ", \"weighted_probe_length\": " << table_.weightedProbeLength
+        << ", \"max_probe_length\": " << table_.maxProbeLength << "}"
+        << ",\n  \"stages\": [";
+    for (std::size_t i = 0; i < stages_.size(); ++i) {
+        const StageProfile& stage = stages_[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+        writeJsonString(out, stage.name);
+        out << ", \"wall_ms\": " << stage.wallMs
+            << ", \"cpu_ms\": " << stage.cpuMs
+            << ", \"bytes\": " << stage.bytes
+            << ", \"tokens\": " << stage.tokens
+            << ", \"tokens_per_second\": " << perSecond(stage.tokens, stage.wallMs)
+            << ", \"allocations\": " << stage.allocations
+            << ", \"peak_memory_kb\": " << stage.peakMemoryKb << "}";
+    }
+    out << "\n  ]\n}\n";
+    out.close();
+    if (!out) {
+        std::cerr << "Error: Could not write file " << fileName << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace corpus
@@ -0,0 +1,435 @@
+#include "../include/QueryServer.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace corpus {
+
+namespace {
+
+constexpr char lookupMagic[8] = {'C', 'O', 'R', 'P', 'M', 'P', 'H', '\0'};
+constexpr std::uint32_t byteOrderMark = 0x01020304;
+
+template <typename T>
+void writeValue(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+void writeArray(std::ofstream& out, const std::vector<T>& values) {
+    out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+std::uint64_t paddedSize(std::uint64_t values) {
+    return (values + values % 2) * sizeof(std::uint32_t);
+}
+
+void appendNumber(std::string& out, std::uint64_t value) {
+    char digits[24];
+    char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    out.append(digits, static_cast<std::size_t>(end - digits));
+}
+
+// The K of a "t K" request: digits and nothing else. A number past 64 bits
+// is as good as any K over maxTopRequest.
+bool parseTopCount(std::string_view text, std::uint64_t& k) {
+    const char* end = text.data() + text.size();
+    std::from_chars_result parsed = std::from_chars(text.data(), end, k);
+    if (parsed.ptr != end || text.empty()) {
+        return false;
+    }
+    if (parsed.ec == std::errc::result_out_of_range) {
+        k = maxTopRequest;
+        return true;
+    }
+    return parsed.ec == std::errc();
+}
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void requestStop(int) {
+    stopRequested = 1;
+}
+
+// Binds a listening socket, replacing a socket file left by a server that is
+// gone; a live server, or any other kind of file, is left alone.
+int listenOn(const std::string& path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Error: socket path " << path << " is too long" << std::endl;
+        return -1;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    struct stat st;
+    if (::lstat(path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            std::cerr << "Error: " << path << " exists and is not a socket" << std::endl;
+            return -1;
+        }
+        int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool live = probe >= 0 && ::connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) {
+            ::close(probe);
+        }
+        if (live) {
+            std::cerr << "Error: a server is already listening on " << path << std::endl;
+            return -1;
+        }
+        ::unlink(path.c_str());
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, 128) != 0) {
+        std::cerr << "Error: Could not listen on " << path << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
+
+struct Client {
+    int fd;
+    std::string requests;  // received, not yet answered (at most one partial line)
+    std::string replies;   // answered, not yet sent
+    std::size_t sent = 0;
+    bool closed = false;
+};
+
+constexpr std::size_t readSize = 64 * 1024;
+constexpr std::size_t maxLine = 1 << 20;       // a client sending longer lines is dropped
+constexpr std::size_t maxPending = 4 << 20;    // stop reading a client whose replies back up
+
+std::size_t pending(const Client& client) {
+    return client.replies.size() - client.sent;
+}
+
+// Answers the complete lines received so far, up to the reply budget.
+void answer(Client& client, const RankLookup& lookup, std::uint64_t& answered) {
+    std::size_t consumed =
+        answerRequests(lookup, client.requests, client.replies, &answered, client.sent + maxPending);
+    client.requests.erase(0, consumed);
+}
+
+// Reads and answers until the socket is drained or the replies back up; what
+// is left unread waits in the socket, so a pipelining client is held back by
+// its own send buffer rather than by the server's memory.
+void receive(Client& client, const RankLookup& lookup, std::uint64_t& answered) {
+    while (pending(client) < maxPending) {
+        std::size_t old = client.requests.size();
+        client.requests.resize(old + readSize);
+        ssize_t got = ::recv(client.fd, &client.requests[old], readSize, 0);
+        client.requests.resize(old + static_cast<std::size_t>(std::max<ssize_t>(got, 0)));
+        if (got <= 0) {
+            if (got == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                client.closed = true;
+            }
+            break;
+        }
+        answer(client, lookup, answered);
+        if (client.requests.size() > maxLine && client.requests.find('\n') == std::string::npos) {
+            client.closed = true;
+            break;
+        }
+    }
+}
+
+void flush(Client& client) {
+    while (client.sent < client.replies.size()) {
+        ssize_t put = ::send(client.fd, client.replies.data() + client.sent, client.replies.size() - client.sent,
+                             MSG_NOSIGNAL);
+        if (put < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                client.closed = true;
+            }
+            // drop what a slow reader has taken, or the buffer would only grow
+            if (client.sent >= maxPending) {
+                client.replies.erase(0, client.sent);
+                client.sent = 0;
+            }
+            return;
+        }
+        client.sent += static_cast<std::size_t>(put);
+    }
+    client.replies.clear();
+    client.sent = 0;
+}
+
+void serve(int listener, const RankLookup& lookup, std::uint64_t& answered) {
+    std::vector<Client> clients;
+    std::vector<pollfd> polled;
+    while (!stopRequested) {
+        polled.assign(1, pollfd{listener, POLLIN, 0});
+        for (const Client& client : clients) {
+            short events = pending(client) < maxPending ? POLLIN : 0;
+            if (client.sent < client.replies.size()) {
+                events |= POLLOUT;
+            }
+            polled.push_back(pollfd{client.fd, events, 0});
+        }
+        // the timeout only bounds how late a stop signal is noticed
+        if (::poll(polled.data(), polled.size(), 500) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: poll failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        for (std::size_t i = 0; i < clients.size(); ++i) {
+            Client& client = clients[i];
+            short events = polled[i + 1].revents;
+            if (events & (POLLIN | POLLHUP | POLLERR)) {
+                receive(client, lookup, answered);
+            }
+            flush(client);
+            // lines held back while the replies were backed up
+            if (!client.closed && !client.requests.empty() && pending(client) < maxPending) {
+                answer(client, lookup, answered);
+                flush(client);
+            }
+        }
+        clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                     [](const Client& client) {
+                                         if (client.closed) {
+                                             ::close(client.fd);
+                                         }
+                                         return client.closed;
+                                     }),
+                      clients.end());
+
+        if (polled[0].revents & POLLIN) {
+            int fd;
+            while ((fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                clients.push_back(Client{fd, {}, {}, 0, false});
+            }
+        }
+    }
+    for (const Client& client : clients) {
+        ::close(client.fd);
+    }
+}
+
+} // namespace
+
+bool writeRankLookup(const FrequencyIndex& index, std::uint64_t checksum, const std::string& fileName) {
+    std::size_t words = index.size();
+    if (words > UINT32_MAX) {
+        std::cerr << "Error: " << words << " words are too many for a rank lookup" << std::endl;
+        return false;
+    }
+    std::vector<std::uint64_t> hashes(words);
+    for (std::size_t i = 0; i < words; ++i) {
+        hashes[i] = hashWord(index.word(i));
+    }
+    PerfectHash hash;
+    if (!PerfectHash::build(hashes, hash)) {
+        return false;
+    }
+
+    // the index is in byte order, so a stable sort by count breaks ties as RankIndex does
+    std::vector<std::uint32_t> byRank(words);
+    std::iota(byRank.begin(), byRank.end(), 0);
+    std::stable_sort(byRank.begin(), byRank.end(),
+                     [&](std::uint32_t a, std::uint32_t b) { return index.countAt(a) > index.countAt(b); });
+    std::vector<std::uint32_t> slots(2 * words);
+    for (std::size_t rank = 0; rank < words; ++rank) {
+        std::size_t slot = hash.find(hashes[byRank[rank]]);
+        slots[2 * slot] = byRank[rank];
+        slots[2 * slot + 1] = static_cast<std::uint32_t>(rank + 1);
+    }
+    if (words % 2 != 0) {
+        byRank.push_back(0);
+    }
+
+    // written next to the target and renamed over it, as the index is
+    std::string temporary = fileName + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Error opening file: " << temporary << std::endl;
+        return false;
+    }
+    LookupHeader header{};
+    std::memcpy(header.magic, lookupMagic, sizeof(lookupMagic));
+    header.version = RankLookup::currentVersion;
+    header.byteOrder = byteOrderMark;
+    header.wordCount = words;
+    header.totalCount = index.totalCount();
+    header.hashWords = hash.serializedSize();
+    header.indexChecksum = checksum;
+    writeValue(out, header);
+    out.write(reinterpret_cast<const char*>(hash.data()),
+              static_cast<std::streamsize>(hash.serializedSize() * sizeof(std::uint64_t)));
+    writeArray(out, slots);
+    writeArray(out, byRank);
+
+    out.close();
+    if (!out) {
+        std::cerr << "Error: Could not write file " << temporary << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    if (std::rename(temporary.c_str(), fileName.c_str()) != 0) {
+        std::cerr << "Error: Could not replace file " << fileName << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool RankLookup::attach(const std::string& fileName, std::uint64_t checksum) {
+    MappedFile file(fileName);
+    const auto* header = reinterpret_cast<const LookupHeader*>(file.data());
+    if (!file.isOpen() || file.size() < sizeof(LookupHeader) ||
+        std::memcmp(header->magic, lookupMagic, sizeof(lookupMagic)) != 0 || header->version != currentVersion ||
+        header->byteOrder != byteOrderMark) {
+        return false;
+    }
+    std::uint64_t words = header->wordCount;
+    if (words != index_.size() || header->totalCount != index_.totalCount() || header->indexChecksum != checksum) {
+        return false;
+    }
+    std::uint64_t expected = sizeof(LookupHeader) + header->hashWords * sizeof(std::uint64_t) +
+                             2 * words * sizeof(std::uint32_t) + paddedSize(words);
+    if (file.size() != expected) {
+        return false;
+    }
+    const auto* hashWords = reinterpret_cast<const std::uint64_t*>(file.data() + sizeof(LookupHeader));
+    PerfectHash hash;
+    if (!hash.attach(hashWords, header->hashWords) || hash.size() != words) {
+        return false;
+    }
+
+    // the positions are read back as indexes into the index, so each must be in range
+    const auto* slots = reinterpret_cast<const Slot*>(hashWords + header->hashWords);
+    const auto* byRank = reinterpret_cast<const std::uint32_t*>(slots + words);
+    for (std::uint64_t i = 0; i < words; ++i) {
+        if (slots[i].position >= words || slots[i].rank == 0 || slots[i].rank > words || byRank[i] >= words) {
+            return false;
+        }
+    }
+
+    hash_ = std::move(hash);
+    slots_ = slots;
+    byRank_ = byRank;
+    file_ = std::move(file);
+    return true;
+}
+
+bool RankLookup::open(const std::string& indexFile, RankLookup& lookup) {
+    lookup.index_ = FrequencyIndex(indexFile);
+    if (!lookup.index_.isOpen()) {
+        return false;
+    }
+    std::string name = lookupFileName(indexFile);
+    std::uint64_t checksum = lookup.index_.checksum();
+    struct stat st;
+    if (::stat(name.c_str(), &st) == 0 && lookup.attach(name, checksum)) {
+        return true;
+    }
+    // missing, or built for another version of the index
+    if (!writeRankLookup(lookup.index_, checksum, name)) {
+        return false;
+    }
+    if (!lookup.attach(name, checksum)) {
+        std::cerr << "Error: " << name << " is truncated or corrupt" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::size_t answerRequests(const RankLookup& lookup, std::string_view requests, std::string& replies,
+                           std::uint64_t* answered, std::size_t maxReplies) {
+    std::size_t consumed = 0;
+    while (replies.size() < maxReplies) {
+        std::size_t end = requests.find('\n', consumed);
+        if (end == std::string_view::npos) {
+            break;
+        }
+        std::string_view line = requests.substr(consumed, end - consumed);
+        consumed = end + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        if (line.size() >= 2 && line[0] == 'w' && line[1] == ' ') {
+            RankLookup::Answer answer = lookup.find(line.substr(2));
+            appendNumber(replies, answer.rank);
+            replies.push_back(' ');
+            appendNumber(replies, answer.count);
+            replies.push_back('\n');
+        } else if (line.size() >= 2 && line[0] == 't' && line[1] == ' ') {
+            std::uint64_t k = 0;
+            if (!parseTopCount(line.substr(2), k)) {
+                replies.append("error invalid count\n");
+            } else {
+                std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>({k, lookup.size(), maxTopRequest}));
+                appendNumber(replies, n);
+                replies.push_back('\n');
+                for (std::size_t rank = 1; rank <= n; ++rank) {
+                    appendNumber(replies, rank);
+                    replies.push_back(' ');
+                    appendNumber(replies, lookup.countAt(rank));
+                    replies.push_back(' ');
+                    replies.append(lookup.wordAt(rank));
+                    replies.push_back('\n');
+                }
+            }
+        } else if (line == "s") {
+            appendNumber(replies, lookup.size());
+            replies.push_back(' ');
+            appendNumber(replies, lookup.totalCount());
+            replies.push_back('\n');
+        } else {
+            replies.append("error unknown request\n");
+        }
+        if (answered != nullptr) {
+            ++*answered;
+        }
+    }
+    return consumed;
+}
+
+int runQueryServer(const Options& options) {
+    RankLookup lookup;
+    if (!RankLookup::open(options.inputFile, lookup)) {
+        return 1;
+    }
+    int listener = listenOn(options.serve);
+    if (listener < 0) {
+        return 1;
+    }
+
+    // no SA_RESTART: a signal interrupts poll() and the loop stops at once
+    struct sigaction action{};
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(SIGINT, &action, nullptr);
+    ::sigaction(SIGTERM, &action, nullptr);
+
+    std::cout << "Serving " << lookup.size() << " words of " << options.inputFile << " on " << options.serve
+              << " (perfect hash: " << lookup.hash().bitsPerKey() << " bits per word)" << std::endl;
+    std::uint64_t answered = 0;
+    serve(listener, lookup, answered);
+    ::close(listener);
+    ::unlink(options.serve.c_str());
+    std::cout << "Answered " << answered << " requests" << std::endl;
+    return 0;
+}
+
+} // namespace corpus
@@ -0,0 +1,97 @@
+#include "../include/RankIndex.h"
+#include <algorithm>
+
+namespace corpus {
+
+namespace {
+
+// Counts up to this value get their own bucket; larger ones are rare and sorted directly.
+constexpr std::uint64_t denseCountLimit = 1 << 16;
+
+bool ranksBefore(const WordCounter::Entry& a, const WordCounter::Entry& b) {
+    return a.count != b.count ? a.count > b.count : a.word < b.word;
+}
+
+} // namespace
+
+std::vector<WordCounter::Entry> rankByFrequency(const WordCounter& counter) {
+    std::uint64_t maxCount = 0;
+    counter.forEach([&](std::string_view, std::uint64_t count) {
+        maxCount = std::max(maxCount, count);
+    });
+    std::size_t buckets = static_cast<std::size_t>(std::min(maxCount, denseCountLimit)) + 1;
+
+    // histogram of the dense counts; everything above the limit goes to the head list
+    std::vector<std::size_t> start(buckets + 1, 0);
+    std::vector<WordCounter::Entry> head;
+    counter.forEach([&](std::string_view word, std::uint64_t count) {
+        if (count < buckets) {
+            ++start[count];
+        } else {
+            head.push_back(WordCounter::Entry{word, count});
+        }
+    });
+    std::sort(head.begin(), head.end(), ranksBefore);
+
+    // bucket offsets, highest count first, after the head
+    std::size_t offset = head.size();
+    for (std::size_t count = buckets; count-- > 0;) {
+        std::size_t n = start[count];
+        start[count] = offset;
+        offset += n;
+    }
+    start[buckets] = offset;
+
+    std::vector<WordCounter::Entry> ranked(offset);
+    std::copy(head.begin(), head.end(), ranked.begin());
+    std::vector<std::size_t> next(start.begin(), start.end());
+    counter.forEach([&](std::string_view word, std::uint64_t count) {
+        if (count < buckets) {
+            ranked[next[count]++] = WordCounter::Entry{word, count};
+        }
+    });
+
+    // ties inside a bucket are ordered by word
+    for (std::size_t count = 1; count < buckets; ++count) {
+        std::size_t end = count == 1 ? offset : start[count - 1];
+        std::sort(ranked.begin() + start[count], ranked.begin() + end,
+                  [](const WordCounter::Entry& a, const WordCounter::Entry& b) { return a.word < b.word; });
+    }
+    return ranked;
+}
+
+std::vector<WordCounter::Entry> topK(const WordCounter& counter, std::size_t k) {
+    std::vector<WordCounter::Entry> heap;
+    if (k == 0) {
+        return heap;
+    }
+    heap.reserve(k + 1);
+
+    // min-heap on rank: the front is the worst of the k best entries seen so far
+    counter.forEach([&](std::string_view word, std::uint64_t count) {
+        WordCounter::Entry entry{word, count};
+        if (heap.size() < k) {
+            heap.push_back(entry);
+            std::push_heap(heap.begin(), heap.end(), ranksBefore);
+        } else if (ranksBefore(entry, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), ranksBefore);
+            heap.back() = entry;
+            std::push_heap(heap.begin(), heap.end(), ranksBefore);
+        }
+    });
+
+    std::sort_heap(heap.begin(), heap.end(), ranksBefore);
+    return heap;
+}
+
+RankIndex RankIndex::top(const WordCounter& counter, std::size_t k) {
+    RankIndex index;
+    index.ranked_ = corpus::topK(counter, k);
+    return index;
+}
+
+std::vector<WordCounter::Entry> RankIndex::topK(std::size_t k) const {
+    return std::vector<WordCounter::Entry>(ranked_.begin(), ranked_.begin() + std::min(k, ranked_.size()));
+}
+
+} // namespace corpus
@@ -0,0 +1,305 @@
+#include "../include/SectionCount.h"
+#include "../include/FrequencyIndex.h"
+#include "../include/FrequencyWriter.h"
+#include "../include/MappedFile.h"
+#include "../include/ParallelCount.h"
+#include "../include/Profile.h"
+#include "../include/RankIndex.h"
+#include "../include/WorkStealingPool.h"
+#include "../include/ZipfPlot.h"
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <utility>
+
+namespace corpus {
+
+namespace {
+
+bool isLineSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+// The header line from the marker on, with every run of blanks made one space.
+std::string headerTitle(std::string_view line) {
+    std::string title;
+    for (char c : line) {
+        if (!isLineSpace(c)) {
+            title.push_back(c);
+        } else if (!title.empty() && title.back() != ' ') {
+            title.push_back(' ');
+        }
+    }
+    if (!title.empty() && title.back() == ' ') {
+        title.pop_back();
+    }
+    return title;
+}
+
+// Whether the marker found at `at` opens a header, and if so its title.
+bool readHeader(std::string_view text, std::size_t at, std::size_t markerSize, WordBytePredicate isWordByte,
+                std::size_t maxTitleWords, std::string& title) {
+    std::size_t end = at + markerSize;
+    if ((at > 0 && isWordByte(text[at - 1])) || (end < text.size() && isWordByte(text[end]))) {
+        return false;  // part of a longer word
+    }
+    std::size_t lineStart = text.rfind('\n', at);
+    lineStart = lineStart == std::string_view::npos ? 0 : lineStart + 1;
+    std::size_t lineEnd = std::min(text.find('\n', end), text.size());
+    bool startsLine = std::all_of(text.begin() + lineStart, text.begin() + at, isLineSpace);
+    if (!startsLine) {
+        // count the title's words back from the end of the line, giving up past the limit
+        std::size_t words = 0;
+        std::size_t i = lineEnd;
+        while (i > end && words <= maxTitleWords) {
+            if (isWordByte(text[i - 1])) {
+                ++words;
+                while (i > end && isWordByte(text[i - 1])) {
+                    --i;
+                }
+            } else {
+                --i;
+            }
+        }
+        if (words == 0 || words > maxTitleWords) {
+            return false;
+        }
+    }
+    title = headerTitle(text.substr(at, lineEnd - at));
+    return true;
+}
+
+} // namespace
+
+std::vector<Section> splitSections(std::string_view text, Script script, const SectionSettings& settings) {
+    WordBytePredicate isWordByte = wordBytePredicate(script);
+    std::vector<std::pair<std::size_t, std::size_t>> found;  // position and length of every marker
+    for (const std::string& marker : settings.markers) {
+        if (marker.empty()) {
+            continue;
+        }
+        for (std::size_t at = text.find(marker); at != std::string_view::npos; at = text.find(marker, at + 1)) {
+            found.emplace_back(at, marker.size());
+        }
+    }
+    std::sort(found.begin(), found.end());
+
+    std::vector<Section> sections;
+    std::size_t begin = 0;
+    std::string title;
+    bool opened = false;  // whether text from begin on starts with a header
+    for (const auto& [at, size] : found) {
+        if (opened && at == begin) {
+            continue;  // a second marker at the same header
+        }
+        std::string next;
+        if (!readHeader(text, at, size, isWordByte, settings.maxTitleWords, next)) {
+            continue;
+        }
+        std::string_view before = text.substr(begin, at - begin);
+        // a preamble without words is dropped, it adds nothing to any count
+        if (opened || std::any_of(before.begin(), before.end(), isWordByte)) {
+            sections.push_back(Section{std::move(title), before});
+        }
+        title = std::move(next);
+        begin = at;
+        opened = true;
+    }
+    sections.push_back(Section{std::move(title), text.substr(begin)});
+    return sections;
+}
+
+SectionMatrix::SectionMatrix(const std::vector<WordCounter>& sections, const WordCounter& global, unsigned threads)
+    : columns_(global.size()), offsets_(sections.size() + 1, 0), tokens_(sections.size()) {
+    std::vector<std::vector<std::pair<std::uint32_t, std::uint32_t>>> rows(sections.size());
+    {
+        WorkStealingPool pool(threads);
+        for (std::size_t r = 0; r < sections.size(); ++r) {
+            pool.submit([&, r] {
+                rows[r].reserve(sections[r].size());
+                // the stored hash finds the word in the global table without hashing it again
+                sections[r].forEachHashed([&](std::string_view word, std::uint64_t hash, std::uint64_t count) {
+                    WordCounter::WordRef ref{0, 0, 0};
+                    global.findHashed(word, hash, ref);
+                    rows[r].emplace_back(ref.id, static_cast<std::uint32_t>(count));
+                });
+                std::sort(rows[r].begin(), rows[r].end());
+            });
+        }
+        pool.wait();
+    }
+
+    for (std::size_t r = 0; r < rows.size(); ++r) {
+        offsets_[r + 1] = offsets_[r] + rows[r].size();
+        tokens_[r] = sections[r].totalCount();
+    }
+    ids_.reserve(offsets_.back());
+    counts_.reserve(offsets_.back());
+    for (const auto& row : rows) {
+        for (const auto& [id, count] : row) {
+            ids_.push_back(id);
+            counts_.push_back(count);
+        }
+    }
+}
+
+std::uint32_t SectionMatrix::count(std::size_t section, std::uint32_t id) const {
+    if (section >= sections()) {
+        return 0;
+    }
+    auto first = ids_.begin() + offsets_[section];
+    auto last = ids_.begin() + offsets_[section + 1];
+    auto it = std::lower_bound(first, last, id);
+    return it != last && *it == id ? counts_[it - ids_.begin()] : 0;
+}
+
+std::vector<SectionMatrix::Occurrence> SectionMatrix::sectionsOf(std::uint32_t id) const {
+    std::vector<Occurrence> occurrences;
+    for (std::size_t r = 0; r < sections(); ++r) {
+        std::uint32_t count = this->count(r, id);
+        if (count > 0) {
+            occurrences.push_back(Occurrence{r, count});
+        }
+    }
+    return occurrences;
+}
+
+std::size_t SectionMatrix::memoryUsage() const {
+    return offsets_.capacity() * sizeof(std::size_t) + (ids_.capacity() + counts_.capacity()) * sizeof(std::uint32_t) +
+           tokens_.capacity() * sizeof(std::uint64_t);
+}
+
+SectionCounts countSections(std::string_view text, Script script, const SectionSettings& settings, unsigned threads) {
+    SectionCounts result;
+    result.sections = splitSections(text, script, settings);
+    std::vector<WordCounter> tables(result.sections.size());
+
+    // largest sections first, so a long one is not the last to start
+    std::vector<std::size_t> order(tables.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return result.sections[a].text.size() > result.sections[b].text.size();
+    });
+    {
+        WorkStealingPool pool(threads);
+        for (std::size_t i : order) {
+            pool.submit([&, i] { countWordsInto(script, result.sections[i].text, tables[i]); });
+        }
+        pool.wait();
+        result.global = mergeSharded(tables, pool.size());
+    }
+    result.matrix = SectionMatrix(tables, result.global, threads);
+    return result;
+}
+
+int runSections(const Options& options, Script script) {
+    // headers are found in the mapped text, which blocks and token streams do not keep
+    if (options.stream || !options.tokens.empty() || !options.saveTokens.empty() || options.heaps) {
+        std::cerr << "Error: --sections maps the whole book from a file; it cannot be combined with --stream, "
+                  << "standard input, --tokens, --save-tokens or --heaps" << std::endl;
+        return 1;
+    }
+    RunProfile profile("sections");
+    profile.setInput(options.inputFile, options.threads);
+    profile.begin("count");
+    MappedFile book(options.inputFile);
+    if (!book.isOpen()) {
+        return 1;
+    }
+    SectionSettings settings;
+    settings.markers = options.sectionMarkers;
+    SectionCounts counts = countSections(book.view(), script, settings, options.threads);
+    const SectionMatrix& matrix = counts.matrix;
+    for (std::size_t s = 0; s < matrix.sections(); ++s) {
+        if (matrix.sectionTokens(s) > UINT32_MAX) {
+            std::cerr << "Error: section " << s + 1 << " has more words than the 32-bit section matrix holds" << std::endl;
+            return 1;
+        }
+    }
+    profile.addWork(book.view().size(), counts.global.totalCount());
+    profile.setTable(counts.global);
+    if (!options.saveIndex.empty()) {
+        profile.begin("index");
+        if (!writeFrequencyIndex(options.saveIndex, counts.global, script)) {
+            return 1;
+        }
+        std::cout << "Frequency index has been written to " << options.saveIndex << std::endl;
+    }
+
+    std::cout << "Sections: " << counts.sections.size() << std::endl;
+    for (std::size_t s = 0; s < counts.sections.size(); ++s) {
+        const std::string& title = counts.sections[s].title;
+        std::cout << s + 1 << ' ' << (title.empty() ? "(preamble)" : title) << ": " << matrix.sectionTokens(s)
+                  << " words, " << matrix.sectionWords(s) << " unique\n";
+    }
+    std::cout << "Total number of words: " << counts.global.totalCount() << std::endl;
+    std::cout << "Number of unique words: " << counts.global.size() << std::endl;
+    std::cout << "Section matrix: " << matrix.nonZeros() << " counts over " << matrix.sections() << " x "
+              << matrix.words() << ", " << matrix.memoryUsage() << " bytes" << std::endl;
+
+    profile.begin("write");
+    RankIndex ranks = options.top > 0 ? RankIndex::top(counts.global, options.top) : RankIndex(counts.global);
+    if (!writeFrequencies(ranks, options.outputFile, options.format)) {
+        return 1;
+    }
+    std::cout << "Global frequencies have been written to " << options.outputFile << std::endl;
+    if (!options.plotFile.empty()) {
+        profile.begin("plot");
+        if (!exportZipfPlot(ranks, options.plotFile, "Word Frequency Distribution (Log-Log Scale)")) {
+            return 1;
+        }
+    }
+
+    // every section ranked by its own counts; equal counts keep the global order
+    std::string sectionFile = plotSibling(options.outputFile, ".sections.tsv");
+    BufferedWriter out(sectionFile);
+    if (!out.isOpen()) {
+        return 1;
+    }
+    out.write("section\ttitle\trank\tcount\tword\n");
+    // the global rank of every column, to break ties between equal section counts
+    std::vector<std::string_view> wordOf(counts.global.size());
+    std::vector<std::uint32_t> globalRank(counts.global.size());
+    {
+        std::vector<WordCounter::Entry> ranked = rankByFrequency(counts.global);
+        for (std::size_t rank = 0; rank < ranked.size(); ++rank) {
+            WordCounter::WordRef ref{0, 0, 0};
+            counts.global.find(ranked[rank].word, ref);
+            wordOf[ref.id] = ranked[rank].word;
+            globalRank[ref.id] = static_cast<std::uint32_t>(rank);
+        }
+    }
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> row;
+    for (std::size_t s = 0; s < matrix.sections(); ++s) {
+        row.clear();
+        matrix.forEachInSection(s, [&](std::uint32_t id, std::uint32_t count) { row.emplace_back(count, id); });
+        std::size_t kept = options.top > 0 ? std::min(options.top, row.size()) : row.size();
+        auto byCount = [&](const auto& a, const auto& b) {
+            return a.first != b.first ? a.first > b.first : globalRank[a.second] < globalRank[b.second];
+        };
+        std::partial_sort(row.begin(), row.begin() + kept, row.end(), byCount);
+        for (std::size_t i = 0; i < kept; ++i) {
+            out.writeUnsigned(s + 1);
+            out.put('\t');
+            out.write(counts.sections[s].title);
+            out.put('\t');
+            out.writeUnsigned(i + 1);
+            out.put('\t');
+            out.writeUnsigned(row[i].first);
+            out.put('\t');
+            out.write(wordOf[row[i].second]);
+            out.put('\n');
+        }
+    }
+    if (!out.close()) {
+        return 1;
+    }
+    std::cout << "Per-section frequencies have been written to " << sectionFile << std::endl;
+
+    if (!options.profile.empty() && profile.writeJson(options.profile)) {
+        std::cout << "Run profile has been written to " << options.profile << std::endl;
+    }
+    return 0;
+}
+
+} // namespace corpus
@@ -0,0 +1,206 @@
+#include "../include/Sketch.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace corpus {
+
+HyperLogLog::HyperLogLog(unsigned precision)
+    : precision_(std::min(18u, std::max(4u, precision))), registers_(std::size_t(1) << precision_, 0) {}
+
+HyperLogLog HyperLogLog::forError(double relativeError) {
+    if (!(relativeError > 0)) {
+        return HyperLogLog(18);
+    }
+    double registers = (1.04 / relativeError) * (1.04 / relativeError);
+    return HyperLogLog(static_cast<unsigned>(std::ceil(std::log2(registers))));
+}
+
+bool HyperLogLog::merge(const HyperLogLog& other) {
+    if (other.precision_ != precision_) {
+        std::cerr << "Error: cannot merge HyperLogLog sketches of precision " << precision_
+                  << " and " << other.precision_ << std::endl;
+        return false;
+    }
+    for (std::size_t i = 0; i < registers_.size(); ++i) {
+        registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+    return true;
+}
+
+double HyperLogLog::estimate() const {
+    double m = static_cast<double>(registers_.size());
+    double alpha = registers_.size() == 16 ? 0.673
+                 : registers_.size() == 32 ? 0.697
+                 : registers_.size() == 64 ? 0.709
+                                           : 0.7213 / (1.0 + 1.079 / m);
+    double sum = 0;
+    std::size_t zeros = 0;
+    for (std::uint8_t r : registers_) {
+        sum += std::ldexp(1.0, -static_cast<int>(r));
+        zeros += r == 0;
+    }
+    double raw = alpha * m * m / sum;
+    // small cardinalities: linear counting over the empty registers is more accurate
+    if (raw <= 2.5 * m && zeros != 0) {
+        return m * std::log(m / static_cast<double>(zeros));
+    }
+    return raw;
+}
+
+double HyperLogLog::standardError() const {
+    return 1.04 / std::sqrt(static_cast<double>(registers_.size()));
+}
+
+CountMinSketch::CountMinSketch(std::size_t width, std::size_t depth) : depth_(std::max<std::size_t>(1, depth)) {
+    width_ = 1;
+    while (width_ < width) {
+        width_ <<= 1;
+    }
+    counters_.assign(width_ * depth_, 0);
+}
+
+CountMinSketch CountMinSketch::forError(double epsilon, double delta) {
+    std::size_t width = epsilon > 0 ? static_cast<std::size_t>(std::ceil(std::exp(1.0) / epsilon)) : 1 << 20;
+    std::size_t depth = delta > 0 && delta < 1 ? static_cast<std::size_t>(std::ceil(std::log(1.0 / delta))) : 5;
+    return CountMinSketch(width, depth);
+}
+
+std::uint64_t CountMinSketch::estimateHash(std::uint64_t hash) const {
+    std::uint64_t step = (hash >> 32) | 1;
+    std::uint64_t best = UINT64_MAX;
+    for (std::size_t row = 0; row < depth_; ++row) {
+        best = std::min(best, counters_[row * width_ + ((hash + row * step) & (width_ - 1))]);
+    }
+    return best;
+}
+
+bool CountMinSketch::merge(const CountMinSketch& other) {
+    if (other.width_ != width_ || other.depth_ != depth_) {
+        std::cerr << "Error: cannot merge Count-Min sketches of different shapes" << std::endl;
+        return false;
+    }
+    for (std::size_t i = 0; i < counters_.size(); ++i) {
+        counters_[i] += other.counters_[i];
+    }
+    return true;
+}
+
+HeavyHitters::HeavyHitters(std::size_t k, CountMinSketch sketch) : k_(k), sketch_(std::move(sketch)) {
+    heap_.reserve(k_);
+    slot_.reserve(k_);
+}
+
+void HeavyHitters::place(std::size_t i) {
+    slot_[heap_[i].hash] = i;
+}
+
+void HeavyHitters::siftUp(std::size_t i) {
+    while (i > 0) {
+        std::size_t parent = (i - 1) / 2;
+        if (heap_[parent].count <= heap_[i].count) {
+            break;
+        }
+        std::swap(heap_[parent], heap_[i]);
+        place(i);
+        i = parent;
+    }
+    place(i);
+}
+
+void HeavyHitters::siftDown(std::size_t i) {
+    while (true) {
+        std::size_t smallest = i;
+        for (std::size_t child = 2 * i + 1; child <= 2 * i + 2 && child < heap_.size(); ++child) {
+            if (heap_[child].count < heap_[smallest].count) {
+                smallest = child;
+            }
+        }
+        if (smallest == i) {
+            break;
+        }
+        std::swap(heap_[smallest], heap_[i]);
+        place(i);
+        i = smallest;
+    }
+    place(i);
+}
+
+void HeavyHitters::addHashed(std::string_view word, std::uint64_t hash, std::uint64_t n) {
+    if (k_ == 0) {
+        sketch_.addHash(hash, n);
+        return;
+    }
+    std::uint64_t estimate = sketch_.addHash(hash, n);
+    // the long tail stops here: it cannot displace anything kept
+    if (heap_.size() == k_ && estimate <= heap_[0].count) {
+        return;
+    }
+
+    auto found = slot_.find(hash);
+    if (found != slot_.end()) {
+        // estimates only grow, so the word can only move away from the root
+        heap_[found->second].count = estimate;
+        siftDown(found->second);
+        return;
+    }
+    if (heap_.size() < k_) {
+        heap_.push_back(Candidate{std::string(word), hash, estimate});
+        siftUp(heap_.size() - 1);
+        return;
+    }
+    slot_.erase(heap_[0].hash);
+    heap_[0] = Candidate{std::string(word), hash, estimate};
+    siftDown(0);
+}
+
+bool HeavyHitters::merge(const HeavyHitters& other) {
+    if (!sketch_.merge(other.sketch_)) {
+        return false;
+    }
+    std::vector<Candidate> candidates = std::move(heap_);
+    for (const Candidate& candidate : other.heap_) {
+        if (slot_.count(candidate.hash) == 0) {
+            candidates.push_back(candidate);
+        }
+    }
+    for (Candidate& candidate : candidates) {
+        candidate.count = sketch_.estimateHash(candidate.hash);
+    }
+
+    heap_.clear();
+    slot_.clear();
+    for (Candidate& candidate : candidates) {
+        if (heap_.size() < k_) {
+            heap_.push_back(std::move(candidate));
+            siftUp(heap_.size() - 1);
+        } else if (candidate.count > heap_[0].count) {
+            slot_.erase(heap_[0].hash);
+            heap_[0] = std::move(candidate);
+            siftDown(0);
+        }
+    }
+    return true;
+}
+
+std::vector<HeavyHitters::Entry> HeavyHitters::top() const {
+    std::vector<Entry> result;
+    result.reserve(heap_.size());
+    for (const Candidate& candidate : heap_) {
+        result.push_back(Entry{candidate.word, candidate.count});
+    }
+    std::sort(result.begin(), result.end(), [](const Entry& a, const Entry& b) {
+        return a.count != b.count ? a.count > b.count : a.word < b.word;
+    });
+    return result;
+}
+
+std::size_t HeavyHitters::memoryUsage() const {
+    std::size_t bytes = sketch_.memoryUsage() + heap_.capacity() * sizeof(Candidate);
+    for (const Candidate& candidate : heap_) {
+        bytes += candidate.word.capacity();
+    }
+    return bytes + slot_.size() * (sizeof(std::uint64_t) + sizeof(std::size_t) + 2 * sizeof(void*));
+}
+
+} // namespace corpus
@@ -0,0 +1,241 @@
+#include "../include/StringSort.h"
+#include "../include/ParallelCount.h"
+#include "../include/WorkStealingPool.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace corpus {
+
+namespace {
+
+constexpr std::size_t insertionLimit = 16;      // below this many words, insertion sort
+constexpr std::size_t quicksortLimit = 2048;    // below this many, multikey quicksort
+constexpr std::size_t taskLimit = 1 << 15;      // buckets at least this big become pool tasks
+constexpr std::size_t cachedBytes = 8;          // bytes of each word kept next to its view
+
+// Bytes depth..depth+7 of a word, first byte highest and zeros past its
+// end. As words hold no zero bytes, a zero byte means the word has ended.
+inline std::uint64_t loadPrefix(std::string_view word, std::size_t depth) {
+    std::size_t left = depth < word.size() ? word.size() - depth : 0;
+    std::uint64_t prefix = 0;
+    if (left >= cachedBytes) {
+        std::memcpy(&prefix, word.data() + depth, cachedBytes);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        prefix = __builtin_bswap64(prefix);
+#endif
+        return prefix;
+    }
+    for (std::size_t i = 0; i < left; ++i) {
+        prefix |= static_cast<std::uint64_t>(static_cast<unsigned char>(word[depth + i])) << (8 * (cachedBytes - 1 - i));
+    }
+    return prefix;
+}
+
+// Sorts ranges of the words, all equal up to the depth they are sorted
+// from, and notes every run of equal words by its first position. Every
+// word's bytes from the last multiple of 8 at or below the depth are cached
+// in prefixes_, so the levels in between read a sequential array instead
+// of the words.
+class RunSorter {
+public:
+    RunSorter(std::string_view* words, WorkStealingPool* pool, std::size_t size)
+        : words_(words), prefixes_(size), pool_(pool), runs_(pool != nullptr ? pool->size() : 1) {
+        load(0, size, 0);
+    }
+
+    void sort(std::size_t begin, std::size_t n, std::size_t depth) {
+        if (n <= 1) {
+            if (n == 1) {
+                emit(begin, 1);
+            }
+        } else if (n < insertionLimit) {
+            insertionSort(begin, n, depth);
+        } else if (n < quicksortLimit) {
+            multikeyQuicksort(begin, n, depth);
+        } else {
+            radixSort(begin, n, depth);
+        }
+    }
+
+    // the runs found by every worker, in byte order
+    std::vector<WordCounter::Entry> runs() const {
+        std::vector<Run> all;
+        for (const std::vector<Run>& found : runs_) {
+            all.insert(all.end(), found.begin(), found.end());
+        }
+        std::sort(all.begin(), all.end(), [](const Run& a, const Run& b) { return a.begin < b.begin; });
+        std::vector<WordCounter::Entry> entries;
+        entries.reserve(all.size());
+        for (const Run& run : all) {
+            entries.push_back({words_[run.begin], run.count});
+        }
+        return entries;
+    }
+
+private:
+    struct Run {
+        std::size_t begin;
+        std::uint64_t count;
+    };
+
+    void emit(std::size_t begin, std::uint64_t count) {
+        runs_[pool_ != nullptr ? pool_->currentWorker() : 0].push_back({begin, count});
+    }
+
+    void load(std::size_t begin, std::size_t n, std::size_t depth) {
+        for (std::size_t i = begin; i < begin + n; ++i) {
+            prefixes_[i] = loadPrefix(words_[i], depth);
+        }
+    }
+
+    // the byte of word i at a depth, 0 past its end
+    unsigned byteAt(std::size_t i, std::size_t depth) const {
+        return static_cast<unsigned>(prefixes_[i] >> (8 * (cachedBytes - 1 - depth % cachedBytes))) & 0xFF;
+    }
+
+    void swap(std::size_t i, std::size_t j) {
+        std::swap(words_[i], words_[j]);
+        std::swap(prefixes_[i], prefixes_[j]);
+    }
+
+    // moves on to the next byte, refilling the cache when it runs out
+    void descend(std::size_t begin, std::size_t n, std::size_t depth) {
+        if ((depth + 1) % cachedBytes == 0 && n > 1) {
+            load(begin, n, depth + 1);
+        }
+        sort(begin, n, depth + 1);
+    }
+
+    // word i before word j, both equal up to the depth
+    bool less(std::size_t i, std::size_t j, std::size_t depth) const {
+        if (prefixes_[i] != prefixes_[j]) {
+            return prefixes_[i] < prefixes_[j];
+        }
+        std::size_t next = depth - depth % cachedBytes + cachedBytes;
+        return (prefixes_[i] & 0xFF) != 0 && words_[i].substr(next) < words_[j].substr(next);
+    }
+
+    bool equal(std::size_t i, std::size_t j, std::size_t depth) const {
+        if (prefixes_[i] != prefixes_[j]) {
+            return false;
+        }
+        std::size_t next = depth - depth % cachedBytes + cachedBytes;
+        return (prefixes_[i] & 0xFF) == 0 || words_[i].substr(next) == words_[j].substr(next);
+    }
+
+    void insertionSort(std::size_t begin, std::size_t n, std::size_t depth) {
+        for (std::size_t i = begin + 1; i < begin + n; ++i) {
+            for (std::size_t j = i; j > begin && less(j, j - 1, depth); --j) {
+                swap(j, j - 1);
+            }
+        }
+        for (std::size_t i = begin; i < begin + n;) {
+            std::size_t j = i + 1;
+            while (j < begin + n && equal(j, i, depth)) {
+                ++j;
+            }
+            emit(i, j - i);
+            i = j;
+        }
+    }
+
+    // Bentley and Sedgewick: three-way partition on the byte at the depth;
+    // only the middle part moves on to the next byte.
+    void multikeyQuicksort(std::size_t begin, std::size_t n, std::size_t depth) {
+        while (n >= insertionLimit) {
+            std::size_t end = begin + n;
+            unsigned a = byteAt(begin, depth);
+            unsigned b = byteAt(begin + n / 2, depth);
+            unsigned c = byteAt(end - 1, depth);
+            unsigned pivot = std::max(std::min(a, b), std::min(std::max(a, b), c));
+
+            std::size_t lt = begin;
+            std::size_t gt = end;
+            for (std::size_t i = begin; i < gt;) {
+                unsigned key = byteAt(i, depth);
+                if (key < pivot) {
+                    swap(lt++, i++);
+                } else if (key > pivot) {
+                    swap(i, --gt);
+                } else {
+                    ++i;
+                }
+            }
+
+            sort(begin, lt - begin, depth);
+            if (pivot == 0) {
+                // every word of the middle part ends here: one run
+                emit(lt, gt - lt);
+            } else {
+                descend(lt, gt - lt, depth);
+            }
+            begin = gt;
+            n = end - gt;
+        }
+        sort(begin, n, depth);
+    }
+
+    // American flag sort: count the buckets, then swap every word into its
+    // bucket in place, following the cycles of the permutation.
+    void radixSort(std::size_t begin, std::size_t n, std::size_t depth) {
+        std::size_t counts[256] = {};
+        for (std::size_t i = begin; i < begin + n; ++i) {
+            ++counts[byteAt(i, depth)];
+        }
+        std::size_t starts[257];
+        std::size_t next[256];
+        starts[0] = begin;
+        for (unsigned b = 0; b < 256; ++b) {
+            next[b] = starts[b];
+            starts[b + 1] = starts[b] + counts[b];
+        }
+        for (unsigned b = 0; b < 256; ++b) {
+            while (next[b] < starts[b + 1]) {
+                std::size_t i = next[b];
+                for (unsigned key = byteAt(i, depth); key != b; key = byteAt(i, depth)) {
+                    swap(i, next[key]++);
+                }
+                ++next[b];
+            }
+        }
+
+        if (counts[0] > 0) {
+            // the words that end here are all equal
+            emit(begin, counts[0]);
+        }
+        for (unsigned b = 1; b < 256; ++b) {
+            std::size_t first = starts[b];
+            std::size_t size = counts[b];
+            if (pool_ != nullptr && size >= taskLimit) {
+                pool_->submit([this, first, size, depth] { descend(first, size, depth); });
+            } else if (size > 0) {
+                descend(first, size, depth);
+            }
+        }
+    }
+
+    std::string_view* words_;
+    std::vector<std::uint64_t> prefixes_;
+    WorkStealingPool* pool_;
+    std::vector<std::vector<Run>> runs_;  // per worker, so emitting needs no lock
+};
+
+} // namespace
+
+std::vector<WordCounter::Entry> sortAndCountRuns(std::vector<std::string_view>& words, unsigned threads) {
+    threads = resolveThreads(threads);
+    if (threads <= 1 || words.size() < taskLimit) {
+        RunSorter sorter(words.data(), nullptr, words.size());
+        sorter.sort(0, words.size(), 0);
+        return sorter.runs();
+    }
+    WorkStealingPool pool(threads);
+    RunSorter sorter(words.data(), &pool, words.size());
+    pool.submit([&] { sorter.sort(0, words.size(), 0); });
+    pool.wait();
+    return sorter.runs();
+}
+
+} // namespace corpus
@@ -0,0 +1,275 @@
+#include "../include/TokenStream.h"
+#include "../include/BlockReader.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+namespace corpus {
+
+namespace {
+
+constexpr char tokenMagic[8] = {'C', 'O', 'R', 'P', 'T', 'O', 'K', '\0'};
+constexpr std::uint32_t byteOrderMark = 0x01020304;
+
+template <typename T>
+void writeValue(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Zero bytes after an array of 32-bit values, up to the next 8-byte boundary.
+void padToEight(std::ofstream& out, std::uint64_t values) {
+    if (values % 2 != 0) {
+        writeValue(out, std::uint32_t{0});
+    }
+}
+
+std::uint64_t paddedSize(std::uint64_t values) {
+    return (values + values % 2) * sizeof(std::uint32_t);
+}
+
+// Appends the IDs of the words of text to ids, serially or on several threads.
+// Workers encode their chunk with a dictionary of their own; joining those in
+// chunk order and by local ID gives every new word the ID a serial pass would.
+void encodeInto(std::string_view text, Script script, unsigned threads, WordIds& words,
+                std::vector<std::uint32_t>& ids) {
+    std::vector<std::string_view> chunks = splitAtWordBoundaries(text, threads, wordBytePredicate(script));
+    if (chunks.size() <= 1) {
+        forEachWord(script, text, [&](std::string_view word) {
+            ids.push_back(words.id(word));
+        });
+        return;
+    }
+
+    std::vector<WordIds> local(chunks.size());
+    std::vector<std::vector<std::uint32_t>> localIds(chunks.size());
+    runOnChunks(chunks, [&](std::size_t i, std::string_view chunk) {
+        forEachWord(script, chunk, [&](std::string_view word) {
+            localIds[i].push_back(local[i].id(word));
+        });
+    });
+
+    std::vector<std::vector<std::uint32_t>> remap(chunks.size());
+    std::vector<std::size_t> offsets(chunks.size() + 1, ids.size());
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        remap[i].resize(local[i].size());
+        for (std::uint32_t id = 0; id < local[i].size(); ++id) {
+            remap[i][id] = words.id(local[i].word(id));
+        }
+        offsets[i + 1] = offsets[i] + localIds[i].size();
+    }
+    ids.resize(offsets.back());
+    runOnChunks(chunks, [&](std::size_t i, std::string_view) {
+        std::uint32_t* out = ids.data() + offsets[i];
+        for (std::uint32_t id : localIds[i]) {
+            *out++ = remap[i][id];
+        }
+    });
+}
+
+} // namespace
+
+void TokenStream::adopt(std::vector<std::uint32_t> ids) {
+    owned_ = std::move(ids);
+    ids_ = owned_.data();
+    size_ = owned_.size();
+}
+
+TokenStream TokenStream::fromText(std::string_view text, Script script, unsigned threads) {
+    TokenStream stream;
+    stream.script_ = script;
+    std::vector<std::uint32_t> ids;
+    // about one token per six bytes of prose; a guess only saves regrowing
+    ids.reserve(text.size() / 6);
+    encodeInto(text, script, resolveThreads(threads), stream.words_, ids);
+    stream.adopt(std::move(ids));
+    stream.bytes_ = text.size();
+    return stream;
+}
+
+TokenStream TokenStream::fromStream(const std::string& fileName, std::size_t blockSize, Script script,
+                                    unsigned threads) {
+    TokenStream stream;
+    stream.script_ = script;
+    threads = resolveThreads(threads);
+    std::vector<std::uint32_t> ids;
+    BlockReader reader(fileName, blockSize, wordBytePredicate(script));
+    std::string_view block;
+    while (reader.next(block)) {
+        encodeInto(block, script, threads, stream.words_, ids);
+    }
+    stream.adopt(std::move(ids));
+    stream.bytes_ = reader.bytesRead();
+    return stream;
+}
+
+bool TokenStream::load(const std::string& fileName, TokenStream& stream) {
+    MappedFile file(fileName);
+    if (!file.isOpen()) {
+        return false;
+    }
+    const auto* header = reinterpret_cast<const TokenHeader*>(file.data());
+    if (file.size() < sizeof(TokenHeader) || std::memcmp(header->magic, tokenMagic, sizeof(tokenMagic)) != 0) {
+        std::cerr << "Error: " << fileName << " is not a token stream" << std::endl;
+        return false;
+    }
+    if (header->version != currentVersion || header->byteOrder != byteOrderMark) {
+        std::cerr << "Error: " << fileName << " has token stream version " << header->version
+                  << ", or was written with another byte order" << std::endl;
+        return false;
+    }
+    std::uint64_t words = header->wordCount;
+    std::uint64_t tokens = header->tokenCount;
+    // bound the header's sizes by the file first, so the sum below cannot wrap
+    std::uint64_t body = file.size() - sizeof(TokenHeader);
+    bool fits = words <= body / sizeof(std::uint64_t) && tokens <= body / sizeof(std::uint32_t) &&
+                header->bytesSize <= body;
+    std::uint64_t expected = sizeof(TokenHeader) + words * sizeof(std::uint64_t) + paddedSize(tokens) + header->bytesSize;
+    if (!fits || expected != file.size()) {
+        std::cerr << "Error: " << fileName << " is truncated or corrupt" << std::endl;
+        return false;
+    }
+
+    const auto* ends = reinterpret_cast<const std::uint64_t*>(file.data() + sizeof(TokenHeader));
+    const auto* ids = reinterpret_cast<const std::uint32_t*>(ends + words);
+    const char* bytes = reinterpret_cast<const char*>(ids) + paddedSize(tokens);
+    // rebuild the dictionary; the words come in ID order, so they get their IDs back
+    WordIds dictionary(words);
+    std::uint64_t begin = 0;
+    for (std::uint64_t id = 0; id < words; ++id) {
+        if (ends[id] < begin || ends[id] > header->bytesSize) {
+            std::cerr << "Error: " << fileName << " is truncated or corrupt" << std::endl;
+            return false;
+        }
+        dictionary.id(std::string_view(bytes + begin, ends[id] - begin));
+        begin = ends[id];
+    }
+    if (dictionary.size() != words) {
+        std::cerr << "Error: " << fileName << " repeats a word of its dictionary" << std::endl;
+        return false;
+    }
+    for (std::uint64_t i = 0; i < tokens; ++i) {
+        if (ids[i] >= words) {
+            std::cerr << "Error: " << fileName << " is truncated or corrupt" << std::endl;
+            return false;
+        }
+    }
+
+    stream.script_ = static_cast<Script>(header->script);
+    stream.words_ = std::move(dictionary);
+    stream.owned_.clear();
+    stream.ids_ = ids;
+    stream.size_ = tokens;
+    stream.bytes_ = header->sourceBytes;
+    stream.file_ = std::move(file);
+    return true;
+}
+
+bool TokenStream::save(const std::string& fileName) const {
+    // written next to the target and renamed over it, as the frequency index is
+    std::string temporary = fileName + ".tmp";
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Error opening file: " << temporary << std::endl;
+        return false;
+    }
+
+    TokenHeader header{};
+    std::memcpy(header.magic, tokenMagic, sizeof(tokenMagic));
+    header.version = currentVersion;
+    header.byteOrder = byteOrderMark;
+    header.script = static_cast<std::uint32_t>(script_);
+    header.wordCount = words_.size();
+    header.tokenCount = size_;
+    header.sourceBytes = bytes_;
+    std::vector<std::uint64_t> ends(words_.size());
+    std::uint64_t end = 0;
+    for (std::uint32_t id = 0; id < words_.size(); ++id) {
+        end += words_.word(id).size();
+        ends[id] = end;
+    }
+    header.bytesSize = end;
+    writeValue(out, header);
+
+    out.write(reinterpret_cast<const char*>(ends.data()), static_cast<std::streamsize>(ends.size() * sizeof(std::uint64_t)));
+    out.write(reinterpret_cast<const char*>(ids_), static_cast<std::streamsize>(size_ * sizeof(std::uint32_t)));
+    padToEight(out, size_);
+    for (std::uint32_t id = 0; id < words_.size(); ++id) {
+        std::string_view word = words_.word(id);
+        out.write(word.data(), static_cast<std::streamsize>(word.size()));
+    }
+
+    out.close();
+    if (!out) {
+        std::cerr << "Error: Could not write file " << temporary << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    if (std::rename(temporary.c_str(), fileName.c_str()) != 0) {
+        std::cerr << "Error: Could not replace file " << fileName << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::uint64_t> TokenStream::frequencies() const {
+    std::vector<std::uint64_t> counts(words_.size(), 0);
+    for (std::uint32_t id : *this) {
+        ++counts[id];
+    }
+    return counts;
+}
+
+WordCounter TokenStream::toCounter() const {
+    std::vector<std::uint64_t> counts = frequencies();
+    WordCounter counter(counts.size());
+    for (std::uint32_t id = 0; id < counts.size(); ++id) {
+        counter.add(words_.word(id), counts[id]);
+    }
+    return counter;
+}
+
+void TokenStream::recordGrowth(VocabularyGrowth& growth) const {
+    std::uint32_t next = 0;
+    for (std::size_t i = 0; i < size_; ++i) {
+        if (ids_[i] == next) {
+            growth.addWordAt(i);
+            ++next;
+        }
+    }
+    growth.finish(size_);
+}
+
+bool readTokens(const Options& options, Script script, TokenStream& stream) {
+    if (!options.tokens.empty()) {
+        if (!TokenStream::load(options.tokens, stream)) {
+            return false;
+        }
+        if (stream.script() != script) {
+            std::cerr << "Error: " << options.tokens << " was tokenized for another script" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    if (options.stream) {
+        stream = TokenStream::fromStream(options.inputFile, options.blockSize, script, options.threads);
+    } else {
+        MappedFile book(options.inputFile);
+        if (!book.isOpen()) {
+            return false;
+        }
+        stream = TokenStream::fromText(book.view(), script, options.threads);
+    }
+    if (!options.saveTokens.empty()) {
+        if (!stream.save(options.saveTokens)) {
+            return false;
+        }
+        std::cout << "Token stream has been written to " << options.saveTokens << std::endl;
+    }
+    return true;
+}
+
+} // namespace corpus
@@ -0,0 +1,226 @@
+#include "../include/Tokenizer.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CORPUS_HAVE_X86_KERNELS 1
+#endif
+
+namespace corpus {
+
+namespace {
+
+// Folds and classifies bytes [i, n) one at a time; masks must already be zeroed.
+void foldScalarFrom(const char* in, std::size_t i, std::size_t n, char* folded, std::uint64_t* letterMasks) {
+    for (; i < n; ++i) {
+        char c = in[i];
+        folded[i] = toLowerAscii(c);
+        letterMasks[i / 64] |= static_cast<std::uint64_t>(isAsciiLetter(c)) << (i % 64);
+    }
+}
+
+void foldScalar(const char* in, std::size_t n, char* folded, std::uint64_t* letterMasks) {
+    std::memset(letterMasks, 0, (n + 63) / 64 * sizeof(std::uint64_t));
+    foldScalarFrom(in, 0, n, folded, letterMasks);
+}
+
+#ifdef CORPUS_HAVE_X86_KERNELS
+
+// Both kernels use the same trick: adding (128 - 'a') moves 'a'..'z' to the
+// bottom of the signed byte range, so one signed compare against -128 + 26
+// tells letters from everything else, 16 or 32 bytes at a time.
+
+__attribute__((target("sse2")))
+void foldSse2(const char* in, std::size_t n, char* folded, std::uint64_t* letterMasks) {
+    std::memset(letterMasks, 0, (n + 63) / 64 * sizeof(std::uint64_t));
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i lowerShift = _mm_set1_epi8(static_cast<char>(128 - 'a'));
+    const __m128i upperShift = _mm_set1_epi8(static_cast<char>(128 - 'A'));
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(-128 + 26));
+
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i letter = _mm_cmplt_epi8(_mm_add_epi8(_mm_or_si128(c, caseBit), lowerShift), limit);
+        __m128i upper = _mm_cmplt_epi8(_mm_add_epi8(c, upperShift), limit);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(folded + i), _mm_or_si128(c, _mm_and_si128(upper, caseBit)));
+        std::uint64_t bits = static_cast<std::uint32_t>(_mm_movemask_epi8(letter));
+        letterMasks[i / 64] |= bits << (i % 64);
+    }
+    foldScalarFrom(in, i, n, folded, letterMasks);
+}
+
+__attribute__((target("avx2")))
+void foldAvx2(const char* in, std::size_t n, char* folded, std::uint64_t* letterMasks) {
+    std::memset(letterMasks, 0, (n + 63) / 64 * sizeof(std::uint64_t));
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i lowerShift = _mm256_set1_epi8(static_cast<char>(128 - 'a'));
+    const __m256i upperShift = _mm256_set1_epi8(static_cast<char>(128 - 'A'));
+    const __m256i limit = _mm256_set1_epi8(static_cast<char>(-128 + 26));
+
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i letter = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(_mm256_or_si256(c, caseBit), lowerShift));
+        __m256i upper = _mm256_cmpgt_epi8(limit, _mm256_add_epi8(c, upperShift));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(folded + i), _mm256_or_si256(c, _mm256_and_si256(upper, caseBit)));
+        std::uint64_t bits = static_cast<std::uint32_t>(_mm256_movemask_epi8(letter));
+        letterMasks[i / 64] |= bits << (i % 64);
+    }
+    foldScalarFrom(in, i, n, folded, letterMasks);
+}
+
+#endif // CORPUS_HAVE_X86_KERNELS
+
+// Classifies bytes [i, n) one at a time; masks must already be zeroed.
+void classifyArabicScalarFrom(const char* in, std::size_t i, std::size_t n, std::uint64_t* leadMasks, std::uint64_t* contMasks) {
+    for (; i < n; ++i) {
+        unsigned char b = static_cast<unsigned char>(in[i]);
+        leadMasks[i / 64] |= static_cast<std::uint64_t>(isArabicLeadByte(b)) << (i % 64);
+        contMasks[i / 64] |= static_cast<std::uint64_t>(isContinuationByte(b)) << (i % 64);
+    }
+}
+
+void classifyArabicScalar(const char* in, std::size_t n, std::uint64_t* leadMasks, std::uint64_t* contMasks) {
+    std::memset(leadMasks, 0, (n + 63) / 64 * sizeof(std::uint64_t));
+    std::memset(contMasks, 0, (n + 63) / 64 * sizeof(std::uint64_t));
+    classifyArabicScalarFrom(in, 0, n, leadMasks, contMasks);
+}
+
+#ifdef CORPUS_HAVE_X86_KERNELS
+
+// Lead bytes use the same shifted signed compare as the ASCII kernels
+// (0xD8..0xDB lands on -128..-125); continuation bytes are (b & 0xC0) == 0x80.
+
+__attribute__((target("sse2")))
+void classifyArabicSse2(const char* in, std::size_t n, std::uint64_t* leadMasks, std::uint64_t* contMasks) {
+    std::memset(leadMasks, 0, (n + 63) / 64 * sizeof(std::uint64_t));
+    std::memset(contMasks, 0, (n + 63) / 64 * sizeof(std::uint64_t));
+    const __m128i leadShift = _mm_set1_epi8(static_cast<char>(128 - 0xD8));
+    const __m128i leadLimit = _mm_set1_epi8(static_cast<char>(-128 + 4));
+    const __m128i topBits = _mm_set1_epi8(static_cast<char>(0xC0));
+    const __m128i contBits = _mm_set1_epi8(static_cast<char>(0x80));
+
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i lead = _mm_cmplt_epi8(_mm_add_epi8(c, leadShift), leadLimit);
+        __m128i cont = _mm_cmpeq_epi8(_mm_and_si128(c, topBits), contBits);
+        leadMasks[i / 64] |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_movemask_epi8(lead))) << (i % 64);
+        contMasks[i / 64] |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm_movemask_epi8(cont))) << (i % 64);
+    }
+    classifyArabicScalarFrom(in, i, n, leadMasks, contMasks);
+}
+
+__attribute__((target("avx2")))
+void classifyArabicAvx2(const char* in, std::size_t n, std::uint64_t* leadMasks, std::uint64_t* contMasks) {
+    std::memset(leadMasks, 0, (n + 63) / 64 * sizeof(std::uint64_t));
+    std::memset(contMasks, 0, (n + 63) / 64 * sizeof(std::uint64_t));
+    const __m256i leadShift = _mm256_set1_epi8(static_cast<char>(128 - 0xD8));
+    const __m256i leadLimit = _mm256_set1_epi8(static_cast<char>(-128 + 4));
+    const __m256i topBits = _mm256_set1_epi8(static_cast<char>(0xC0));
+    const __m256i contBits = _mm256_set1_epi8(static_cast<char>(0x80));
+
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i lead = _mm256_cmpgt_epi8(leadLimit, _mm256_add_epi8(c, leadShift));
+        __m256i cont = _mm256_cmpeq_epi8(_mm256_and_si256(c, topBits), contBits);
+        leadMasks[i / 64] |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(lead))) << (i % 64);
+        contMasks[i / 64] |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(cont))) << (i % 64);
+    }
+    classifyArabicScalarFrom(in, i, n, leadMasks, contMasks);
+}
+
+#endif // CORPUS_HAVE_X86_KERNELS
+
+const AsciiFoldKernel scalarKernel{"scalar", foldScalar};
+const ArabicClassifyKernel arabicScalarKernel{"scalar", classifyArabicScalar};
+#ifdef CORPUS_HAVE_X86_KERNELS
+const AsciiFoldKernel sse2Kernel{"sse2", foldSse2};
+const AsciiFoldKernel avx2Kernel{"avx2", foldAvx2};
+const ArabicClassifyKernel arabicSse2Kernel{"sse2", classifyArabicSse2};
+const ArabicClassifyKernel arabicAvx2Kernel{"avx2", classifyArabicAvx2};
+#endif
+
+} // namespace
+
+const AsciiFoldKernel& bestAsciiFoldKernel() {
+#ifdef CORPUS_HAVE_X86_KERNELS
+    static const AsciiFoldKernel& best = __builtin_cpu_supports("avx2") ? avx2Kernel
+                                       : __builtin_cpu_supports("sse2") ? sse2Kernel
+                                                                        : scalarKernel;
+    return best;
+#else
+    return scalarKernel;
+#endif
+}
+
+std::vector<AsciiFoldKernel> supportedAsciiFoldKernels() {
+    std::vector<AsciiFoldKernel> kernels{scalarKernel};
+#ifdef CORPUS_HAVE_X86_KERNELS
+    if (__builtin_cpu_supports("sse2")) {
+        kernels.push_back(sse2Kernel);
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back(avx2Kernel);
+    }
+#endif
+    return kernels;
+}
+
+const ArabicClassifyKernel& bestArabicClassifyKernel() {
+#ifdef CORPUS_HAVE_X86_KERNELS
+    static const ArabicClassifyKernel& best = __builtin_cpu_supports("avx2") ? arabicAvx2Kernel
+                                            : __builtin_cpu_supports("sse2") ? arabicSse2Kernel
+                                                                             : arabicScalarKernel;
+    return best;
+#else
+    return arabicScalarKernel;
+#endif
+}
+
+std::vector<ArabicClassifyKernel> supportedArabicClassifyKernels() {
+    std::vector<ArabicClassifyKernel> kernels{arabicScalarKernel};
+#ifdef CORPUS_HAVE_X86_KERNELS
+    if (__builtin_cpu_supports("sse2")) {
+        kernels.push_back(arabicSse2Kernel);
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back(arabicAvx2Kernel);
+    }
+#endif
+    return kernels;
+}
+
+namespace detail {
+
+void arabicWordMasks(const char* in, std::size_t n, bool prevIsLead, int next,
+                     const ArabicClassifyKernel& kernel, std::uint64_t* wordMasks) {
+    std::uint64_t lead[scanBlockSize / 64 + 1];
+    std::uint64_t cont[scanBlockSize / 64 + 1];
+    std::size_t words = (n + 63) / 64;
+    kernel.classify(in, n, lead, cont);
+
+    // the byte after the block sits at position n, so a character cut by the edge still pairs up
+    lead[words] = 0;
+    cont[words] = 0;
+    if (next >= 0 && isContinuationByte(static_cast<unsigned char>(next))) {
+        cont[n / 64] |= 1ULL << (n % 64);
+    }
+
+    // a character is a lead byte whose next byte is a continuation: mark both bytes
+    std::uint64_t carry = prevIsLead ? (cont[0] & 1) : 0;
+    for (std::size_t w = 0; w < words; ++w) {
+        std::uint64_t pairs = lead[w] & ((cont[w] >> 1) | (cont[w + 1] << 63));
+        wordMasks[w] = pairs | (pairs << 1) | carry;
+        carry = pairs >> 63;
+    }
+    if (n % 64 != 0) {
+        wordMasks[words - 1] &= (1ULL << (n % 64)) - 1;
+    }
+}
+
+} // namespace detail
+
+} // namespace corpus
@@ -0,0 +1,81 @@
+#include "../include/VocabularyGrowth.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "../include/ZipfPlot.h"
+
+namespace corpus {
+
+VocabularyGrowth::VocabularyGrowth(unsigned pointsPerDecade) : pointsPerDecade_(std::max(1u, pointsPerDecade)) {}
+
+void VocabularyGrowth::checkpoint() {
+    points_.push_back(HeapsPoint{next_, vocabulary_});
+    // checkpoints closer than one token apart collapse into consecutive ones
+    ++step_;
+    double target = std::ceil(std::pow(10.0, step_ / pointsPerDecade_));
+    next_ = std::max(next_ + 1, static_cast<std::uint64_t>(target));
+}
+
+void VocabularyGrowth::finish(std::uint64_t tokens) {
+    while (next_ <= tokens) {
+        checkpoint();
+    }
+    if (tokens > 0 && (points_.empty() || points_.back().tokens != tokens)) {
+        points_.push_back(HeapsPoint{tokens, vocabulary_});
+    }
+}
+
+HeapsFit fitHeaps(const std::vector<HeapsPoint>& points, std::uint64_t minTokens) {
+    HeapsFit fit;
+    std::size_t fitted = std::count_if(points.begin(), points.end(), [&](const HeapsPoint& point) {
+        return point.tokens >= minTokens;
+    });
+    if (fitted < 2) {
+        minTokens = 0;
+    }
+    std::vector<double> x;
+    std::vector<double> y;
+    for (const HeapsPoint& point : points) {
+        if (point.tokens >= minTokens) {
+            x.push_back(std::log(static_cast<double>(point.tokens)));
+            y.push_back(std::log(static_cast<double>(point.vocabulary)));
+        }
+    }
+    if (x.size() < 2) {
+        return fit;
+    }
+    LineFit line = leastSquares(x, y);
+    fit.beta = line.slope;
+    fit.k = std::exp(line.intercept);
+    fit.rSquared = line.rSquared;
+    return fit;
+}
+
+bool writeHeapsCsv(const std::string& fileName, const std::vector<HeapsPoint>& points, const HeapsFit& fit) {
+    std::ofstream out(fileName);
+    if (!out) {
+        std::cerr << "Error opening file: " << fileName << std::endl;
+        return false;
+    }
+    out << std::setprecision(10) << "# heaps K=" << fit.k << " beta=" << fit.beta << " r2=" << fit.rSquared << '\n'
+        << "tokens,vocabulary,heaps\n";
+    for (const HeapsPoint& point : points) {
+        out << point.tokens << ',' << point.vocabulary << ',' << fit.predict(static_cast<double>(point.tokens)) << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+bool exportHeapsCurve(const VocabularyGrowth& growth, const std::string& tableFile) {
+    HeapsFit fit = fitHeaps(growth.points());
+    std::cout << "Heaps fit: K = " << fit.k << ", beta = " << fit.beta << " (R^2 = " << fit.rSquared << ")"
+              << std::endl;
+    std::string csvFile = plotSibling(tableFile, ".heaps.csv");
+    if (!writeHeapsCsv(csvFile, growth.points(), fit)) {
+        return false;
+    }
+    std::cout << "Vocabulary growth curve has been written to " << csvFile << std::endl;
+    return true;
+}
+
+} // namespace corpus
@@ -0,0 +1,141 @@
+#include "../include/WordCounter.h"
+#include <algorithm>
+
+namespace corpus {
+
+WordCounter::WordCounter(std::size_t expectedWords) {
+    std::size_t capacity = 16;
+    while (capacity * 3 < expectedWords * 4) {
+        capacity *= 2;
+    }
+    slots_.assign(capacity, Slot{});
+    mask_ = capacity - 1;
+    arena_.reserve(expectedWords * 8);
+}
+
+void WordCounter::grow() {
+    std::vector<Slot> old(slots_.size() * 2, Slot{});
+    old.swap(slots_);
+    mask_ = slots_.size() - 1;
+
+    // the stored hashes make rehashing a pure slot shuffle, words are not touched
+    for (const Slot& slot : old) {
+        if (slot.count == 0) {
+            continue;
+        }
+        std::size_t i = slot.hash & mask_;
+        while (slots_[i].count != 0) {
+            i = (i + 1) & mask_;
+        }
+        slots_[i] = slot;
+    }
+}
+
+void WordCounter::merge(const WordCounter& other) {
+    for (const Slot& slot : other.slots_) {
+        if (slot.count != 0) {
+            addHashed(other.wordAt(slot), slot.hash, slot.count);
+        }
+    }
+}
+
+WordCounter WordCounter::concatenate(const std::vector<WordCounter>& parts) {
+    std::size_t words = 0;
+    std::size_t bytes = 0;
+    for (const WordCounter& part : parts) {
+        words += part.size_;
+        bytes += part.arena_.size();
+    }
+    WordCounter result(words);
+    result.arena_.reserve(bytes);
+
+    for (const WordCounter& part : parts) {
+        std::uint64_t base = result.arena_.size();
+        std::uint32_t firstId = static_cast<std::uint32_t>(result.size_);
+        result.arena_.insert(result.arena_.end(), part.arena_.begin(), part.arena_.end());
+        // like grow(): the stored hash finds the slot, and the words are known to be new
+        for (const Slot& slot : part.slots_) {
+            if (slot.count == 0) {
+                continue;
+            }
+            std::size_t i = slot.hash & result.mask_;
+            while (result.slots_[i].count != 0) {
+                i = (i + 1) & result.mask_;
+            }
+            Slot& moved = result.slots_[i];
+            moved = slot;
+            moved.offset += base;
+            moved.id += firstId;
+        }
+        result.size_ += part.size_;
+        result.total_ += part.total_;
+    }
+    return result;
+}
+
+const WordCounter::Slot* WordCounter::lookup(std::string_view word, std::uint64_t hash) const {
+    std::size_t i = hash & mask_;
+    while (slots_[i].count != 0) {
+        const Slot& slot = slots_[i];
+        if (slot.hash == hash && wordAt(slot) == word) {
+            return &slot;
+        }
+        i = (i + 1) & mask_;
+    }
+    return nullptr;
+}
+
+std::uint64_t WordCounter::count(std::string_view word) const {
+    const Slot* slot = lookup(word, hashWord(word));
+    return slot != nullptr ? slot->count : 0;
+}
+
+bool WordCounter::findHashed(std::string_view word, std::uint64_t hash, WordRef& ref) const {
+    const Slot* slot = lookup(word, hash);
+    if (slot == nullptr) {
+        return false;
+    }
+    ref = WordRef{slot->offset, slot->length, slot->id};
+    return true;
+}
+
+std::vector<WordCounter::Entry> WordCounter::entries() const {
+    std::vector<Entry> result;
+    result.reserve(size_);
+    forEach([&](std::string_view word, std::uint64_t count) {
+        result.push_back(Entry{word, count});
+    });
+    return result;
+}
+
+std::size_t WordCounter::memoryUsage() const {
+    return slots_.capacity() * sizeof(Slot) + arena_.capacity();
+}
+
+WordCounter::ProbeStats WordCounter::probeStats() const {
+    ProbeStats stats;
+    stats.capacity = slots_.size();
+    if (size_ == 0) {
+        return stats;
+    }
+    std::uint64_t probes = 0;
+    double weighted = 0;
+    std::uint64_t counted = 0;
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+        const Slot& slot = slots_[i];
+        if (slot.count == 0) {
+            continue;
+        }
+        std::size_t length = ((i - slot.hash) & mask_) + 1;
+        probes += length;
+        weighted += static_cast<double>(length) * slot.count;
+        counted += slot.count;
+        stats.maxProbeLength = std::max(stats.maxProbeLength, length);
+    }
+    stats.loadFactor = static_cast<double>(size_) / slots_.size();
+    stats.meanProbeLength = static_cast<double>(probes) / size_;
+    stats.weightedProbeLength = weighted / counted;
+    return stats;
+}
+
+} // namespace corpus
@@ -0,0 +1,50 @@
+#include "../include/WordIds.h"
+
+namespace corpus {
+
+WordIds::WordIds(std::size_t expectedWords) {
+    std::size_t capacity = 16;
+    while (capacity * 3 < expectedWords * 4) {
+        capacity *= 2;
+    }
+    slots_.assign(capacity, Slot{0, 0});
+    mask_ = capacity - 1;
+    ends_.reserve(expectedWords);
+    arena_.reserve(expectedWords * 8);
+}
+
+void WordIds::grow() {
+    std::vector<Slot> old(slots_.size() * 2, Slot{0, 0});
+    old.swap(slots_);
+    mask_ = slots_.size() - 1;
+    for (const Slot& slot : old) {
+        if (slot.id == 0) {
+            continue;
+        }
+        std::size_t i = slot.hash & mask_;
+        while (slots_[i].id != 0) {
+            i = (i + 1) & mask_;
+        }
+        slots_[i] = slot;
+    }
+}
+
+bool WordIds::find(std::string_view word, std::uint32_t& id) const {
+    std::uint64_t hash = hashWord(word);
+    std::size_t i = hash & mask_;
+    while (slots_[i].id != 0) {
+        const Slot& slot = slots_[i];
+        if (slot.hash == hash && this->word(slot.id - 1) == word) {
+            id = slot.id - 1;
+            return true;
+        }
+        i = (i + 1) & mask_;
+    }
+    return false;
+}
+
+std::size_t WordIds::memoryUsage() const {
+    return slots_.capacity() * sizeof(Slot) + ends_.capacity() * sizeof(std::uint64_t) + arena_.capacity();
+}
+
+} // namespace corpus
@@ -0,0 +1,117 @@
+#include "../include/WorkStealingPool.h"
+#include "../include/ParallelCount.h"
+
+namespace corpus {
+
+namespace {
+
+// which pool the calling thread works for, and its index there
+thread_local const WorkStealingPool* currentPool = nullptr;
+thread_local int currentIndex = -1;
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(unsigned threads) {
+    threads = resolveThreads(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    workers_.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers_.emplace_back([this, i] { run(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+int WorkStealingPool::currentWorker() const {
+    return currentPool == this ? currentIndex : -1;
+}
+
+void WorkStealingPool::submit(Task task) {
+    int self = currentWorker();
+    std::size_t target;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++pending_;
+        ++queued_;  // counted before the push, so it never drops below zero
+        target = self >= 0 ? static_cast<std::size_t>(self) : nextQueue_++ % queues_.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return pending_ == 0; });
+}
+
+bool WorkStealingPool::takeTask(unsigned index, Task& task) {
+    // own deque first, newest task
+    {
+        Queue& own = *queues_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    // then steal the oldest task of the next busy worker
+    for (std::size_t k = 1; k < queues_.size(); ++k) {
+        Queue& victim = *queues_[(index + k) % queues_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(unsigned index) {
+    currentPool = this;
+    currentIndex = static_cast<int>(index);
+    Task task;
+    while (true) {
+        if (takeTask(index, task)) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --queued_;
+            }
+            task();
+            task = nullptr;
+            bool drained;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                drained = --pending_ == 0;
+            }
+            if (drained) {
+                idle_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [this] { return stop_ || queued_ > 0; });
+        if (stop_ && queued_ == 0) {
+            return;
+        }
+    }
+}
+
+} // namespace corpus
@@ -7,64 +7,64 @@
 #include <map>
 #include <set>
 #include "../include/ZipF.h"
+#include "../include/MappedFile.h"
+#include "../include/Tokenizer.h"
+#include "../include/Options.h"
+#include "../include/CorpusStats.h"
+#include "../include/RankIndex.h"
+#include "../include/Batch.h"
+#include "../include/ApproximateCount.h"
+#include "../include/FrequencyIndex.h"
+#include "../include/NgramCount.h"
+#include "../include/Profile.h"
+#include "../include/QueryServer.h"
+#include "../include/SectionCount.h"
+#include "../include/TokenStream.h"
+#include "../include/VocabularyGrowth.h"
+#include "../include/ZipfMatplot.h"
+#include "../include/ZipfPlot.h"
 
 namespace zipF {
 
 std::vector<char> readBook(const std::string& fileName) {
-    std::ifstream file(fileName);
-    std::vector<char> result;
-
-    if (file.is_open()) {
-        char c;
-        while (file.get(c)) {
-            if (std::isalpha(c)) {
-                result.push_back(std::tolower(c));  // lowercase
-            } else {
-                result.push_back(' ');
-            }
-        }
-    }
-    return result;
+    return Engine::readBook(fileName);
 }
 
+void countWordsInto(std::string_view text, corpus::WordCounter& counter){
+    corpus::countWordsInto(corpus::Script::Ascii, text, counter);
+}
 
-std::map<std::string, int> computeWordFrequency(const std::vector<char>& book){
+corpus::WordCounter countWords(std::string_view text){
+    return corpus::countWords(text, corpus::Script::Ascii);
+}
+
+corpus::WordCounter countWords(std::string_view text, unsigned threads){
+    return corpus::countWords(text, corpus::Script::Ascii, threads);
+}
+
+corpus::WordCounter countWordsStreaming(const std::string& fileName, std::size_t blockSize, unsigned threads,
+                                        std::uint64_t* bytesRead){
+    return corpus::countWordsStreaming(fileName, blockSize, corpus::Script::Ascii, threads, bytesRead);
+}
+
+std::map<std::string, int> computeWordFrequency(std::string_view text){
     std::map<std::string, int> wordFrequency;
-    std::stringstream ss;
-    std::string word;
-    for (char c : book){
-        if (c == ' '){
-            ss >> word;
-            if (wordFrequency.find(word) == wordFrequency.end()){
-                wordFrequency[word] = 1;
-            } else {
-                wordFrequency[word]++;
-            }
-            ss.clear();
-            ss.str("");
-        } else {
-            ss << c;
-        }
-    }
+    Engine::count(text).forEach([&](std::string_view word, std::uint64_t count) {
+        wordFrequency.emplace(std::string(word), static_cast<int>(count));
+    });
     return wordFrequency;
 }
 
-int countUniqueWords(const std::vector<char>& book){
-    std::set<std::string> uniqueWords;
-    std::stringstream ss;
-    std::string word;
-    for (char c : book){
-        if (c == ' '){
-            ss >> word;
-            uniqueWords.insert(word);
-            ss.clear();
-            ss.str("");
-        } else {
-            ss << c;
-        }
-    }
-    return uniqueWords.size();
+std::map<std::string, int> computeWordFrequency(const std::vector<char>& book){
+    return computeWordFrequency(std::string_view(book.data(), book.size()));
+}
+
+int countUniqueWords(std::string_view text){
+    return static_cast<int>(Engine::uniqueWords(text));
+}
 
+int countUniqueWords(const std::vector<char>& book){
+    return countUniqueWords(std::string_view(book.data(), book.size()));
 }
 
 std::multimap<int, std::string, std::greater<>> sortFrequencies(const std::map<std::string, int>& frequencies){
@@ -75,6 +75,14 @@ std::multimap<int, std::string, std::greater<>> sortFrequencies(const std::map<s
     return sortedFrequencies;
 }
 
+std::multimap<int, std::string, std::greater<>> sortFrequencies(const corpus::WordCounter& counter){
+    std::multimap<int, std::string, std::greater<>> sortedFrequencies;
+    for (const auto& entry : corpus::rankByFrequency(counter)){
+        sortedFrequencies.emplace_hint(sortedFrequencies.end(), static_cast<int>(entry.count), std::string(entry.word));
+    }
+    return sortedFrequencies;
+}
+
 void outputFrequencies(const std::multimap<int, std::string, std::greater<>>& sortedFreq, const std::string& outputFileName) {
     std::ofstream outFile(outputFileName);
 
@@ -85,11 +93,15 @@ void outputFrequencies(const std::multimap<int, std::string, std::greater<>>& so
 
     int rank = 1;
     for (const auto& [frequency, word] : sortedFreq) {  // Structured Binding
-        outFile << rank << " " << frequency << " " << word << std::endl;
+        outFile << rank << " " << frequency << " " << word << "\n";
         rank++;
     }
 }
 
+void outputFrequencies(const corpus::RankIndex& ranks, const std::string& outputFileName, corpus::OutputFormat format) {
+    corpus::writeFrequencies(ranks, outputFileName, format);
+}
+
 
 void plotFrequencies(const std::multimap<int, std::string, std::greater<>>& sortedFreq) {
     std::vector<double> ranks;
@@ -118,6 +130,10 @@ void plotFrequencies(const std::multimap<int, std::string, std::greater<>>& sort
     matplot::show();
 }
 
+void plotFrequencies(const corpus::RankIndex& ranks, const std::string& plotFile) {
+    corpus::plotZipf(ranks, plotFile, "Word Frequency Distribution (Log-Log Scale)", corpus::drawWithMatplot);
+}
+
 // for printing the hapax legomena
 void printHapaxLegomena(const std::multimap<int, std::string, std::greater<>>& sortedFreq) {
     int count = 0;
@@ -134,34 +150,120 @@ void printHapaxLegomena(const std::multimap<int, std::string, std::greater<>>& s
     std::cout << "Total hapax legomena: " << count << std::endl;
 }
 
+// the hapax list is kept by the frequency spectrum as the words are counted
+void printHapaxLegomena(const corpus::CorpusStats& stats) {
+    // only the ten printed words are sorted
+    for (std::string_view word : stats.hapaxLegomena(10)) {
+        std::cout << word << "\n";
+    }
 
+    std::cout << "Total hapax legomena: " << stats.frequencySpectrum().hapaxLegomena() << std::endl;
+    corpus::printSpectrumSummary(stats.frequencySpectrum(), std::cout);
 }
 
-int main() {
-    std::string inputFileName = "../../books/pg2701.txt";    // Replace with your input file name
-    std::string outputFileName = "output.txt";  // Replace with your desired output file name
 
-    // Milestone 1: Read the book
-    std::vector<char> bookContent = zipF::readBook(inputFileName);
+}
+
+int main(int argc, char* argv[]) {
+    corpus::Options options;
+    options.inputFile = "../../books/pg2701.txt";    // default input, override on the command line
+    options.outputFile = "output.txt";  // default output, override on the command line
+    options.sectionMarkers = {"CHAPTER"};  // --sections splits the book into chapters
+    if (!corpus::parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    if (!options.profile.empty()) {
+        corpus::countAllocations();  // unprofiled runs skip the shared allocation counter
+    }
+    if (!options.serve.empty()) {
+        // answer rank and frequency queries about a saved index instead of counting
+        return corpus::runQueryServer(options);
+    }
+    if (!options.batch.empty()) {
+        // many books at once: per-book tables plus one merged table
+        return corpus::runBatch(options, corpus::Script::Ascii);
+    }
+    if (options.approximate) {
+        // fixed-memory estimates instead of an exact table
+        return corpus::runApproximate(options, corpus::Script::Ascii);
+    }
+    if (!options.appendIndex.empty()) {
+        // nightly updates: fold the new text into the stored index and stop
+        return corpus::runIndexAppend(options, corpus::Script::Ascii);
+    }
+    if (options.ngram > 1) {
+        // word pairs or triples instead of single words
+        return corpus::runNgrams(options, corpus::Script::Ascii);
+    }
+    if (options.sections) {
+        // per-section tables and a section x word matrix, along with the global table
+        return corpus::runSections(options, corpus::Script::Ascii);
+    }
+    std::string inputFileName = options.inputFile;
+    std::string outputFileName = options.outputFile;
+    // every milestone is timed; the report is only written with --profile
+    corpus::RunProfile profile("ZipF");
+    profile.setInput(inputFileName, options.threads);
 
-    // Milestone 2: Compute word frequencies
-    std::map<std::string, int> wordFreq = zipF::computeWordFrequency(bookContent);
+    // Milestones 1 and 2: Read the book and compute every statistic in one tokenizing pass
+    // with --heaps the same pass records the vocabulary growth curve
+    corpus::VocabularyGrowth growth;
+    corpus::VocabularyGrowth* heapsCurve = options.heaps ? &growth : nullptr;
+    corpus::CorpusStats stats;
+    profile.begin("count");
+    if (!options.tokens.empty() || !options.saveTokens.empty()) {
+        // through the dictionary-encoded token stream, loaded instead of tokenized or saved for reuse
+        corpus::TokenStream tokens;
+        if (!corpus::readTokens(options, corpus::Script::Ascii, tokens)) {
+            return 1;
+        }
+        stats = corpus::CorpusStats::fromTokens(tokens, heapsCurve);
+    } else if (options.stream) {
+        // blocks of the file (or stdin) are counted as they arrive, the text itself is never kept
+        stats = corpus::CorpusStats::fromStream(inputFileName, options.blockSize, corpus::Script::Ascii, options.threads, heapsCurve);
+    } else {
+        // map the book (no copy, the tokenizer reads the mapping directly)
+        corpus::MappedFile book(inputFileName);
+        stats = options.engine == corpus::CountingEngine::Sort
+                    ? corpus::CorpusStats::fromTextBySorting(book.view(), corpus::Script::Ascii, options.threads)
+                    : corpus::CorpusStats::fromText(book.view(), corpus::Script::Ascii, options.threads, heapsCurve);
+    }
+    profile.addWork(stats.bytesProcessed(), stats.totalTokens());
+    profile.setTable(stats.frequencies());
 
-    // Milestone 3: Count unique words
-    int uniqueWordCount = zipF::countUniqueWords(bookContent);
-    std::cout << "Number of unique words: " << uniqueWordCount << std::endl;
+    if (!options.saveIndex.empty()) {
+        profile.begin("index");
+        if (corpus::writeFrequencyIndex(options.saveIndex, stats.frequencies(), corpus::Script::Ascii)) {
+            std::cout << "Frequency index has been written to " << options.saveIndex << std::endl;
+        }
+    }
+    // Milestone 3: Count unique words (already known from the statistics pass)
+    std::cout << "Total number of words: " << stats.totalTokens() << std::endl;
+    std::cout << "Number of unique words: " << stats.vocabularySize() << std::endl;
 
-    // Milestone 4: Sort the frequencies
-    auto sortedFreq = zipF::sortFrequencies(wordFreq);
+    // Milestone 4: Rank the words by frequency (counting sort, or only the head with --top)
+    profile.begin("rank");
+    corpus::RankIndex ranks = options.top > 0 ? corpus::RankIndex::top(stats.frequencies(), options.top)
+                                              : corpus::RankIndex(stats.frequencies());
 
     // Milestone 5: Output frequencies to file
-    zipF::outputFrequencies(sortedFreq, outputFileName);
+    profile.begin("write");
+    zipF::outputFrequencies(ranks, outputFileName, options.format);
     std::cout << "Word frequencies have been written to " << outputFileName << std::endl;
+    if (options.heaps) {
+        profile.begin("heaps");
+        corpus::exportHeapsCurve(growth, outputFileName);
+    }
 
-    zipF::printHapaxLegomena(sortedFreq);
+    profile.begin("hapax");
+    zipF::printHapaxLegomena(stats);
 
     // Advanced Milestone: Plot frequencies
-    zipF::plotFrequencies(sortedFreq);
+    profile.begin("plot");
+    zipF::plotFrequencies(ranks, options.plotFile);
 
+    if (!options.profile.empty() && profile.writeJson(options.profile)) {
+        std::cout << "Run profile has been written to " << options.profile << std::endl;
+    }
     return 0;
 }
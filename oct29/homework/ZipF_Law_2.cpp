@@ -1,4 +1,20 @@
 #include "../include/ZipF_2.h"
+#include "../include/MappedFile.h"
+#include "../include/Tokenizer.h"
+#include "../include/Options.h"
+#include "../include/CorpusStats.h"
+#include "../include/RankIndex.h"
+#include "../include/Batch.h"
+#include "../include/ApproximateCount.h"
+#include "../include/FrequencyIndex.h"
+#include "../include/NgramCount.h"
+#include "../include/Profile.h"
+#include "../include/QueryServer.h"
+#include "../include/SectionCount.h"
+#include "../include/TokenStream.h"
+#include "../include/VocabularyGrowth.h"
+#include "../include/ZipfMatplot.h"
+#include "../include/ZipfPlot.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -9,55 +25,71 @@ namespace zipF2 {
 
 // for reading the book
 std::vector<char> readBook(const std::string& fileName) {
-    std::ifstream file(fileName);
-    std::vector<char> result;
-
-    if (file.is_open()) {
-        char c;
-        while (file.get(c)) {
-            if (std::isalpha(c)) {
-                result.push_back(std::tolower(c));  // lowercase
-            } else {
-                result.push_back(' ');
-            }
-        }
-    }
-    return result;
+    return Engine::readBook(fileName);
 }
 
-// for counting the frequency of each word
-std::vector<std::pair<std::string, int>> computeWordFrequency(const std::vector<char>& book) {
-    std::stringstream ss(std::string(book.begin(), book.end()));
-    std::vector<std::string> words;
-    std::string word;
+// for adding the words of a piece of text to the hash table
+void countWordsInto(std::string_view text, corpus::WordCounter& counter) {
+    corpus::countWordsInto(corpus::Script::Ascii, text, counter);
+}
 
-    while (ss >> word) {
-        words.push_back(word);
+// for turning ranked words into word-frequency pairs
+std::vector<std::pair<std::string, int>> computeWordFrequency(const corpus::RankIndex& ranks) {
+    // the ranked entries are already sorted by frequency in descending order
+    std::vector<std::pair<std::string, int>> wordFrequency;
+    wordFrequency.reserve(ranks.size());
+    for (const auto& entry : ranks) {
+        wordFrequency.emplace_back(std::string(entry.word), static_cast<int>(entry.count));
     }
 
-    std::sort(words.begin(), words.end()); 
+    return wordFrequency;
+}
 
-    // Vector to store pairs
-    std::vector<std::pair<std::string, int>> wordFrequency;
+// for turning the hash table into word-frequency pairs
+std::vector<std::pair<std::string, int>> computeWordFrequency(const corpus::WordCounter& counter) {
+    return computeWordFrequency(corpus::RankIndex(counter));
+}
 
-    // counting the frequency of each word by iterating through the sorted vector
-    auto it = words.begin();
-    while (it != words.end()) {
-        auto endIt = std::find_if(it, words.end(), [it](const std::string& w) { return w != *it; });
-        int count = std::distance(it, endIt);
-        wordFrequency.emplace_back(*it, count);
-        it = endIt;
-    }
+// for counting the frequency of each word with the hash table
+std::vector<std::pair<std::string, int>> computeWordFrequency(std::string_view text) {
+    return computeWordFrequency(Engine::count(text).table());
+}
+
+// for counting the frequency of each word with several threads
+std::vector<std::pair<std::string, int>> computeWordFrequency(std::string_view text, unsigned threads) {
+    return computeWordFrequency(corpus::countWords(text, corpus::Script::Ascii, threads));
+}
+
+// for counting the IDs of an already tokenized book
+std::vector<std::pair<std::string, int>> computeWordFrequency(const corpus::TokenStream& tokens) {
+    return computeWordFrequency(tokens.toCounter());
+}
 
-    // Sort wordFrequency vector by frequency in descending order
-    std::sort(wordFrequency.begin(), wordFrequency.end(), [](const auto& a, const auto& b) {
-        return a.second > b.second;
-    });
+// for counting a file or stdin block by block
+corpus::WordCounter countWordsStreaming(const std::string& fileName, std::size_t blockSize, unsigned threads,
+                                        std::uint64_t* bytesRead) {
+    return corpus::countWordsStreaming(fileName, blockSize, corpus::Script::Ascii, threads, bytesRead);
+}
 
+// for counting the frequency of each word by sorting all the words
+std::vector<std::pair<std::string, int>> computeWordFrequencyBySorting(std::string_view text, unsigned threads) {
+    // ties stay in alphabetical order, as with the hash table
+    std::vector<std::pair<std::string, int>> wordFrequency;
+    for (auto& [word, count] : SortingEngine::rank(SortingEngine::count(text, corpus::SortCounting(threads, text.size())))) {
+        wordFrequency.emplace_back(std::move(word), static_cast<int>(count));
+    }
     return wordFrequency;
 }
 
+std::vector<std::pair<std::string, int>> computeWordFrequency(const std::vector<char>& book) {
+    return computeWordFrequency(std::string_view(book.data(), book.size()));
+}
+
 // for counting the number of unique words
+int countUniqueWords(const std::vector<char>& book) {
+    return static_cast<int>(Engine::uniqueWords(std::string_view(book.data(), book.size())));
+}
+
 int countUniqueWords(const std::vector<std::pair<std::string, int>>& wordFrequency) {
     return wordFrequency.size(); 
 }
@@ -73,6 +105,14 @@ void writeFrequenciesToFile(const std::vector<std::pair<std::string, int>>& sort
     }
 }
 
+void writeFrequenciesToFile(const corpus::RankIndex& ranks, const std::string& outputFile, corpus::OutputFormat format) {
+    corpus::writeFrequencies(ranks, outputFile, format);
+}
+
+void plotFrequencies(const corpus::RankIndex& ranks, const std::string& plotFile) {
+    corpus::plotZipf(ranks, plotFile, "Word Frequency Distribution (Log-Log Scale)", corpus::drawWithMatplot);
+}
+
 // for printing the hapax legomena by iterating through the sorted vector
 void printHapaxLegomena(const std::vector<std::pair<std::string, int>>& sortedFrequencies) {
     int count = 0;
@@ -89,73 +129,161 @@ void printHapaxLegomena(const std::vector<std::pair<std::string, int>>& sortedFr
     std::cout << "Total hapax legomena: " << count << std::endl;
 }
 
-} 
+// for printing the hapax legomena kept by the frequency spectrum, without scanning
+void printHapaxLegomena(const corpus::CorpusStats& stats) {
+    // only the ten printed words are sorted
+    for (std::string_view word : stats.hapaxLegomena(10)) {
+        std::cout << word << "\n";
+    }
 
-void plotFrequencies(const std::multimap<int, std::string, std::greater<>>& sortedFreq) {
+    std::cout << "Total hapax legomena: " << stats.frequencySpectrum().hapaxLegomena() << std::endl;
+    corpus::printSpectrumSummary(stats.frequencySpectrum(), std::cout);
+}
+
+// for plotting frequency against rank on a log-log scale
+void plotFrequencies(const std::vector<std::pair<std::string, int>>& sortedFreq) {
     std::vector<double> ranks;
     std::vector<double> frequencies;
+    ranks.reserve(sortedFreq.size());
+    frequencies.reserve(sortedFreq.size());
 
     int rank = 1;
     for (const auto& pair : sortedFreq) {
         ranks.push_back(static_cast<double>(rank));
-        frequencies.push_back(static_cast<double>(pair.first));
+        frequencies.push_back(static_cast<double>(pair.second));
         rank++;
     }
 
     // Create a new figure
     matplot::figure();
-    
+
     // Plot on a log-log scale
     matplot::loglog(ranks, frequencies, "r*-");
     matplot::xlabel("Rank");
     matplot::ylabel("Frequency");
     matplot::title("Word Frequency Distribution (Log-Log Scale)");
-    
+
     // Optionally, add grid for better readability
     matplot::grid(matplot::on);
-    
+
     // Display the plot
     matplot::show();
 }
 
-int main() {
-    // Specify the input and output file paths
-    std::string inputFileName = "../../books/pg2701.txt";       // Replace with your input file path
-    std::string outputFileName = "results.txt"; // Replace with your desired output file path
+} 
 
-    // Step 1: Read the book
-    std::cout << "Reading the book from " << inputFileName << "..." << std::endl;
-    std::vector<char> bookContent = zipF2::readBook(inputFileName);
-    std::cout << "Book content read successfully. Total characters: " << bookContent.size() << std::endl;
+int main(int argc, char* argv[]) {
+    // Specify the input and output file paths (both can be overridden on the command line)
+    corpus::Options options;
+    options.inputFile = "../../books/pg2701.txt";
+    options.outputFile = "results.txt";
+    options.sectionMarkers = {"CHAPTER"};  // --sections splits the book into chapters
+    if (!corpus::parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    if (!options.profile.empty()) {
+        corpus::countAllocations();  // unprofiled runs skip the shared allocation counter
+    }
+    if (!options.serve.empty()) {
+        // answer rank and frequency queries about a saved index instead of counting
+        return corpus::runQueryServer(options);
+    }
+    if (!options.batch.empty()) {
+        // many books at once: per-book tables plus one merged table
+        return corpus::runBatch(options, corpus::Script::Ascii);
+    }
+    if (options.approximate) {
+        // fixed-memory estimates instead of an exact table
+        return corpus::runApproximate(options, corpus::Script::Ascii);
+    }
+    if (!options.appendIndex.empty()) {
+        // nightly updates: fold the new text into the stored index and stop
+        return corpus::runIndexAppend(options, corpus::Script::Ascii);
+    }
+    if (options.ngram > 1) {
+        // word pairs or triples instead of single words
+        return corpus::runNgrams(options, corpus::Script::Ascii);
+    }
+    if (options.sections) {
+        // per-section tables and a section x word matrix, along with the global table
+        return corpus::runSections(options, corpus::Script::Ascii);
+    }
+    std::string inputFileName = options.inputFile;
+    std::string outputFileName = options.outputFile;
+    // every step is timed; the report is only written with --profile
+    corpus::RunProfile profile("ZipF2");
+    profile.setInput(inputFileName, options.threads);
 
-    // Step 2: Compute word frequencies
-    std::cout << "Computing word frequencies..." << std::endl;
-    std::vector<std::pair<std::string, int>> wordFreq = zipF2::computeWordFrequency(bookContent);
-    std::cout << "Word frequencies computed successfully. Total unique words: " << wordFreq.size() << std::endl;
+    // Steps 1 and 2: Read the book and compute every statistic in one tokenizing pass
+    // with --heaps the same pass records the vocabulary growth curve
+    corpus::VocabularyGrowth growth;
+    corpus::VocabularyGrowth* heapsCurve = options.heaps ? &growth : nullptr;
+    corpus::CorpusStats stats;
+    profile.begin("count");
+    if (!options.tokens.empty() || !options.saveTokens.empty()) {
+        // through the dictionary-encoded token stream, loaded instead of tokenized or saved for reuse
+        corpus::TokenStream tokens;
+        if (!corpus::readTokens(options, corpus::Script::Ascii, tokens)) {
+            return 1;
+        }
+        stats = corpus::CorpusStats::fromTokens(tokens, heapsCurve);
+    } else if (options.stream) {
+        // each block is counted as soon as it is read
+        std::cout << "Streaming the book from " << inputFileName << " in blocks of " << options.blockSize << " bytes..." << std::endl;
+        stats = corpus::CorpusStats::fromStream(inputFileName, options.blockSize, corpus::Script::Ascii, options.threads, heapsCurve);
+    } else {
+        std::cout << "Reading the book from " << inputFileName << "..." << std::endl;
+        corpus::MappedFile book(inputFileName);
+        std::cout << "Computing word frequencies..." << std::endl;
+        // --engine sort radix sorts the tokens and counts the runs instead of hashing
+        stats = options.engine == corpus::CountingEngine::Sort
+                    ? corpus::CorpusStats::fromTextBySorting(book.view(), corpus::Script::Ascii, options.threads)
+                    : corpus::CorpusStats::fromText(book.view(), corpus::Script::Ascii, options.threads, heapsCurve);
+    }
+    profile.addWork(stats.bytesProcessed(), stats.totalTokens());
+    profile.setTable(stats.frequencies());
+    if (!options.saveIndex.empty()) {
+        profile.begin("index");
+        if (corpus::writeFrequencyIndex(options.saveIndex, stats.frequencies(), corpus::Script::Ascii)) {
+            std::cout << "Frequency index has been written to " << options.saveIndex << std::endl;
+        }
+    }
+    std::cout << "Book content read successfully. Total characters: " << stats.bytesProcessed() << std::endl;
+    // rank with a counting sort over the frequencies (or only the head with --top)
+    profile.begin("rank");
+    corpus::RankIndex ranks = options.top > 0 ? corpus::RankIndex::top(stats.frequencies(), options.top)
+                                              : corpus::RankIndex(stats.frequencies());
+    std::cout << "Word frequencies computed successfully. Total words: " << stats.totalTokens() << std::endl;
 
     // Step 3: Count unique words
-    int uniqueWordCount = zipF2::countUniqueWords(wordFreq);
-    std::cout << "Number of unique words: " << uniqueWordCount << std::endl;
+    std::cout << "Number of unique words: " << stats.vocabularySize() << std::endl;
 
     // Step 4: Write frequencies to output file
     std::cout << "Writing word frequencies to " << outputFileName << "..." << std::endl;
-    zipF2::writeFrequenciesToFile(wordFreq, outputFileName);
+    profile.begin("write");
+    zipF2::writeFrequenciesToFile(ranks, outputFileName, options.format);
     std::cout << "Word frequencies written to " << outputFileName << " successfully." << std::endl;
+    if (options.heaps) {
+        profile.begin("heaps");
+        corpus::exportHeapsCurve(growth, outputFileName);
+    }
 
     // Step 5: Print hapax legomena
     std::cout << "\nHapax Legomena (words that appear only once):" << std::endl;
-    zipF2::printHapaxLegomena(wordFreq);
+    profile.begin("hapax");
+    zipF2::printHapaxLegomena(stats);
 
-    // Step 6: Convert word frequency vector to multimap for plotting
-    std::multimap<int, std::string, std::greater<>> sortedFreq;
-    for (const auto& pair : wordFreq) {
-        sortedFreq.emplace(pair.second, pair.first);
+    // Step 6: Plot frequencies (log-binned and fitted, or exported with --plot)
+    std::cout << "\nPlotting word frequency distribution..." << std::endl;
+    profile.begin("plot");
+    zipF2::plotFrequencies(ranks, options.plotFile);
+    if (options.plotFile.empty()) {
+        std::cout << "Plot displayed successfully." << std::endl;
     }
 
-    // Step 7: Plot frequencies
-    std::cout << "\nPlotting word frequency distribution..." << std::endl;
-    plotFrequencies(sortedFreq);
-    std::cout << "Plot displayed successfully." << std::endl;
+    if (!options.profile.empty() && profile.writeJson(options.profile)) {
+        std::cout << "Run profile has been written to " << options.profile << std::endl;
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,337 @@
+#include "../include/ZipfPlot.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace corpus {
+
+namespace {
+
+LineFit fitWithShift(const std::vector<RankPoint>& points, const std::vector<double>& logFrequency, double shift,
+                     std::vector<double>& logRank) {
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        logRank[i] = std::log(points[i].rank + shift);
+    }
+    return leastSquares(logRank, logFrequency);
+}
+
+ZipfFit toFit(const LineFit& line, double shift) {
+    ZipfFit fit;
+    fit.exponent = -line.slope;
+    fit.constant = std::exp(line.intercept);
+    fit.shift = shift;
+    fit.rSquared = line.rSquared;
+    return fit;
+}
+
+std::vector<double> logFrequencies(const std::vector<RankPoint>& points) {
+    std::vector<double> logFrequency(points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        logFrequency[i] = std::log(points[i].frequency);
+    }
+    return logFrequency;
+}
+
+std::string escapeXml(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        switch (c) {
+        case '&': escaped += "&amp;"; break;
+        case '<': escaped += "&lt;"; break;
+        case '>': escaped += "&gt;"; break;
+        case '"': escaped += "&quot;"; break;
+        default: escaped += c; break;
+        }
+    }
+    return escaped;
+}
+
+// Chart geometry, in SVG user units.
+constexpr double chartWidth = 800;
+constexpr double chartHeight = 560;
+constexpr double marginLeft = 80;
+constexpr double marginRight = 30;
+constexpr double marginTop = 50;
+constexpr double marginBottom = 60;
+
+struct Axes {
+    int xMin, xMax, yMin, yMax;  // decades
+
+    double x(double rank) const {
+        return marginLeft + (std::log10(rank) - xMin) / (xMax - xMin) * (chartWidth - marginLeft - marginRight);
+    }
+    double y(double frequency) const {
+        return marginTop + (yMax - std::log10(frequency)) / (yMax - yMin) * (chartHeight - marginTop - marginBottom);
+    }
+};
+
+void writeCurve(std::ostream& out, const Axes& axes, const ZipfFit& fit, double lastRank, const char* style) {
+    constexpr int samples = 200;
+    out << "<polyline clip-path=\"url(#plot)\" fill=\"none\" " << style << " points=\"";
+    for (int i = 0; i <= samples; ++i) {
+        double rank = std::pow(lastRank, static_cast<double>(i) / samples);
+        double frequency = fit.predict(rank);
+        if (frequency > 0) {
+            out << axes.x(rank) << ',' << axes.y(frequency) << ' ';
+        }
+    }
+    out << "\"/>\n";
+}
+
+} // namespace
+
+// Plain loops over contiguous arrays, which the compiler vectorizes.
+LineFit leastSquares(const std::vector<double>& x, const std::vector<double>& y) {
+    LineFit line;
+    std::size_t n = x.size();
+    if (n < 2) {
+        return line;
+    }
+    double sumX = 0;
+    double sumY = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        sumX += x[i];
+        sumY += y[i];
+    }
+    double meanX = sumX / n;
+    double meanY = sumY / n;
+    double sxx = 0;
+    double sxy = 0;
+    double syy = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        double dx = x[i] - meanX;
+        double dy = y[i] - meanY;
+        sxx += dx * dx;
+        sxy += dx * dy;
+        syy += dy * dy;
+    }
+    if (sxx == 0) {
+        return line;
+    }
+    line.slope = sxy / sxx;
+    line.intercept = meanY - line.slope * meanX;
+    line.residual = std::max(0.0, syy - line.slope * sxy);
+    line.rSquared = syy > 0 ? 1 - line.residual / syy : 1;
+    return line;
+}
+
+std::vector<RankPoint> logBinRanks(const RankIndex& ranks, std::size_t maxPoints) {
+    std::vector<RankPoint> points;
+    std::size_t n = ranks.size();
+    if (n == 0) {
+        return points;
+    }
+    double ratio = n > 1 ? std::pow(static_cast<double>(n), 1.0 / std::max<std::size_t>(maxPoints, 1)) : 2.0;
+    std::size_t first = 1;
+    while (first <= n) {
+        auto last = static_cast<std::size_t>(first * ratio);
+        last = std::min(std::max(last, first), n);
+        double sum = 0;
+        for (std::size_t rank = first; rank <= last; ++rank) {
+            sum += static_cast<double>(ranks[rank - 1].count);
+        }
+        std::size_t words = last - first + 1;
+        points.push_back({std::sqrt(static_cast<double>(first) * last), sum / words, words});
+        first = last + 1;
+    }
+    return points;
+}
+
+ZipfFit fitZipf(const std::vector<RankPoint>& points) {
+    std::vector<double> logRank(points.size());
+    return toFit(fitWithShift(points, logFrequencies(points), 0, logRank), 0);
+}
+
+ZipfFit fitZipfMandelbrot(const std::vector<RankPoint>& points) {
+    if (points.size() < 3) {
+        return fitZipf(points);
+    }
+    std::vector<double> logFrequency = logFrequencies(points);
+    std::vector<double> logRank(points.size());
+    auto residual = [&](double t) { return fitWithShift(points, logFrequency, std::expm1(t), logRank).residual; };
+
+    // golden-section search over t = log(1 + q), so small and large shifts get the same resolution
+    const double golden = 0.6180339887498949;
+    double low = 0;
+    double high = std::log1p(std::max(points.back().rank, 10.0));
+    double a = high - golden * (high - low);
+    double b = low + golden * (high - low);
+    double fa = residual(a);
+    double fb = residual(b);
+    for (int i = 0; i < 80 && high - low > 1e-9; ++i) {
+        if (fa < fb) {
+            high = b;
+            b = a;
+            fb = fa;
+            a = high - golden * (high - low);
+            fa = residual(a);
+        } else {
+            low = a;
+            a = b;
+            fa = fb;
+            b = low + golden * (high - low);
+            fb = residual(b);
+        }
+    }
+    double best = (low + high) / 2;
+    if (residual(0) <= residual(best)) {
+        best = 0;
+    }
+    double shift = std::expm1(best);
+    return toFit(fitWithShift(points, logFrequency, shift, logRank), shift);
+}
+
+bool writeFitCsv(const std::string& fileName, const std::vector<RankPoint>& points, const ZipfFit& zipf,
+                 const ZipfFit& mandelbrot) {
+    std::ofstream out(fileName);
+    if (!out) {
+        std::cerr << "Error opening file: " << fileName << std::endl;
+        return false;
+    }
+    out << std::setprecision(10) << "rank,frequency,words,zipf,zipf_mandelbrot\n";
+    for (const RankPoint& point : points) {
+        out << point.rank << ',' << point.frequency << ',' << point.words << ',' << zipf.predict(point.rank) << ','
+            << mandelbrot.predict(point.rank) << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+bool writePlotSvg(const std::string& fileName, const std::vector<RankPoint>& points, const ZipfFit& zipf,
+                  const ZipfFit& mandelbrot, const std::string& title) {
+    std::ofstream out(fileName);
+    if (!out) {
+        std::cerr << "Error opening file: " << fileName << std::endl;
+        return false;
+    }
+    double lastRank = points.empty() ? 10 : std::max(points.back().rank, 10.0);
+    double lowest = 1;
+    double highest = 10;
+    for (const RankPoint& point : points) {
+        lowest = std::min(lowest, point.frequency);
+        highest = std::max(highest, point.frequency);
+    }
+    Axes axes{0, static_cast<int>(std::ceil(std::log10(lastRank))), static_cast<int>(std::floor(std::log10(lowest))),
+              static_cast<int>(std::ceil(std::log10(highest)))};
+    double right = chartWidth - marginRight;
+    double bottom = chartHeight - marginBottom;
+
+    out << std::fixed << std::setprecision(1);
+    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << chartWidth << "\" height=\"" << chartHeight
+        << "\" viewBox=\"0 0 " << chartWidth << ' ' << chartHeight << "\" font-family=\"sans-serif\" font-size=\"13\">\n"
+        << "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n"
+        << "<clipPath id=\"plot\"><rect x=\"" << marginLeft << "\" y=\"" << marginTop << "\" width=\""
+        << right - marginLeft << "\" height=\"" << bottom - marginTop << "\"/></clipPath>\n"
+        << "<text x=\"" << chartWidth / 2 << "\" y=\"28\" text-anchor=\"middle\" font-size=\"16\">" << escapeXml(title)
+        << "</text>\n";
+
+    // decade grid with 10^k labels
+    for (int k = axes.xMin; k <= axes.xMax; ++k) {
+        double x = axes.x(std::pow(10.0, k));
+        out << "<line x1=\"" << x << "\" y1=\"" << marginTop << "\" x2=\"" << x << "\" y2=\"" << bottom
+            << "\" stroke=\"#ddd\"/>\n<text x=\"" << x << "\" y=\"" << bottom + 20 << "\" text-anchor=\"middle\">10"
+            << "<tspan dy=\"-6\" font-size=\"10\">" << k << "</tspan></text>\n";
+    }
+    for (int k = axes.yMin; k <= axes.yMax; ++k) {
+        double y = axes.y(std::pow(10.0, k));
+        out << "<line x1=\"" << marginLeft << "\" y1=\"" << y << "\" x2=\"" << right << "\" y2=\"" << y
+            << "\" stroke=\"#ddd\"/>\n<text x=\"" << marginLeft - 8 << "\" y=\"" << y + 4
+            << "\" text-anchor=\"end\">10<tspan dy=\"-6\" font-size=\"10\">" << k << "</tspan></text>\n";
+    }
+    out << "<rect x=\"" << marginLeft << "\" y=\"" << marginTop << "\" width=\"" << right - marginLeft
+        << "\" height=\"" << bottom - marginTop << "\" fill=\"none\" stroke=\"black\"/>\n"
+        << "<text x=\"" << (marginLeft + right) / 2 << "\" y=\"" << chartHeight - 15
+        << "\" text-anchor=\"middle\">Rank</text>\n"
+        << "<text transform=\"translate(20 " << (marginTop + bottom) / 2
+        << ") rotate(-90)\" text-anchor=\"middle\">Frequency</text>\n";
+
+    out << "<g fill=\"#d62728\">\n";
+    for (const RankPoint& point : points) {
+        out << "<circle cx=\"" << axes.x(point.rank) << "\" cy=\"" << axes.y(point.frequency) << "\" r=\"2.5\"/>\n";
+    }
+    out << "</g>\n";
+    writeCurve(out, axes, zipf, lastRank, "stroke=\"#1f77b4\" stroke-width=\"2\"");
+    writeCurve(out, axes, mandelbrot, lastRank, "stroke=\"#2ca02c\" stroke-width=\"2\" stroke-dasharray=\"6 4\"");
+
+    out << std::setprecision(3) << "<g transform=\"translate(" << right - 300 << ' ' << marginTop + 20 << ")\">\n"
+        << "<circle cx=\"8\" cy=\"-4\" r=\"2.5\" fill=\"#d62728\"/><text x=\"22\" y=\"0\">words (log-binned)</text>\n"
+        << "<line x1=\"0\" y1=\"14\" x2=\"16\" y2=\"14\" stroke=\"#1f77b4\" stroke-width=\"2\"/>"
+        << "<text x=\"22\" y=\"18\">Zipf s=" << zipf.exponent << " (R²=" << zipf.rSquared << ")</text>\n"
+        << "<line x1=\"0\" y1=\"32\" x2=\"16\" y2=\"32\" stroke=\"#2ca02c\" stroke-width=\"2\" stroke-dasharray=\"6 4\"/>"
+        << "<text x=\"22\" y=\"36\">Zipf-Mandelbrot s=" << mandelbrot.exponent << " q=" << mandelbrot.shift
+        << " (R²=" << mandelbrot.rSquared << ")</text>\n</g>\n</svg>\n";
+    out.close();
+    if (!out) {
+        std::cerr << "Error: Could not write file " << fileName << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string plotSibling(const std::string& plotFile, const std::string& extension) {
+    std::size_t dot = plotFile.find_last_of('.');
+    std::size_t slash = plotFile.find_last_of('/');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return plotFile + extension;
+    }
+    return plotFile.substr(0, dot) + extension;
+}
+
+void printZipfFits(const ZipfFit& zipf, const ZipfFit& mandelbrot) {
+    std::cout << "Zipf fit: s = " << zipf.exponent << ", C = " << zipf.constant << " (R^2 = " << zipf.rSquared << ")"
+              << std::endl;
+    std::cout << "Zipf-Mandelbrot fit: s = " << mandelbrot.exponent << ", q = " << mandelbrot.shift
+              << ", C = " << mandelbrot.constant << " (R^2 = " << mandelbrot.rSquared << ")" << std::endl;
+}
+
+bool exportZipfPlot(const RankIndex& ranks, const std::string& plotFile, const std::string& title) {
+    if (plotFile.size() < 4 || plotFile.compare(plotFile.size() - 4, 4, ".svg") != 0) {
+        std::cerr << "Error: " << plotFile << " must end in .svg (PNG export needs Matplot++)" << std::endl;
+        return false;
+    }
+    std::vector<RankPoint> points = logBinRanks(ranks);
+    ZipfFit zipf = fitZipf(points);
+    ZipfFit mandelbrot = fitZipfMandelbrot(points);
+    printZipfFits(zipf, mandelbrot);
+
+    std::string csvFile = plotSibling(plotFile, ".csv");
+    if (!writePlotSvg(plotFile, points, zipf, mandelbrot, title) || !writeFitCsv(csvFile, points, zipf, mandelbrot)) {
+        return false;
+    }
+    std::cout << "Plot has been written to " << plotFile << " and the fitted curve to " << csvFile << std::endl;
+    return true;
+}
+
+bool plotZipf(const RankIndex& ranks, const std::string& plotFile, const std::string& title, DrawZipfChart draw) {
+    bool png = plotFile.size() >= 4 && plotFile.compare(plotFile.size() - 4, 4, ".png") == 0;
+    if (!plotFile.empty() && !png) {
+        // SVG is drawn directly, with neither gnuplot nor a display
+        return exportZipfPlot(ranks, plotFile, title);
+    }
+
+    // a few hundred log-binned points instead of one per word, with both fitted laws
+    ZipfChart chart;
+    chart.points = logBinRanks(ranks);
+    chart.zipf = fitZipf(chart.points);
+    chart.mandelbrot = fitZipfMandelbrot(chart.points);
+    printZipfFits(chart.zipf, chart.mandelbrot);
+    for (const RankPoint& point : chart.points) {
+        chart.ranks.push_back(point.rank);
+        chart.frequencies.push_back(point.frequency);
+        chart.zipfCurve.push_back(chart.zipf.predict(point.rank));
+        chart.mandelbrotCurve.push_back(chart.mandelbrot.predict(point.rank));
+    }
+    draw(chart, title, plotFile);
+    if (plotFile.empty()) {
+        return true;
+    }
+
+    std::string csvFile = plotSibling(plotFile, ".csv");
+    if (!writeFitCsv(csvFile, chart.points, chart.zipf, chart.mandelbrot)) {
+        return false;
+    }
+    std::cout << "Plot has been written to " << plotFile << " and the fitted curve to " << csvFile << std::endl;
+    return true;
+}
+
+} // namespace corpus
@@ -0,0 +1,123 @@
+#ifndef APPROXIMATE_COUNT_H
+#define APPROXIMATE_COUNT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Counting.h"
+#include "Options.h"
+#include "Sketch.h"
+#include "WordCounter.h"
+
+namespace corpus {
+
+/**
+ * @brief Error bounds of the approximate mode.
+ */
+struct SketchSettings {
+    double distinctError = 0.01;        ///< Relative standard error of the unique-word estimate.
+    double frequencyError = 1e-4;       ///< Overcount bound of a word's count, as a fraction of all tokens.
+    double failureProbability = 0.01;   ///< Chance that a count exceeds that bound.
+    std::size_t top = 100;              ///< Number of heavy hitters kept.
+};
+
+/**
+ * @brief Unique-word and top-K estimates of a corpus, in memory fixed by the settings.
+ *
+ * Combines a HyperLogLog sketch for the vocabulary size with a Count-Min
+ * sketch and heap for the most frequent words. Each word is hashed once
+ * for both sketches. Counters built with the same settings merge, so
+ * chunks, threads or whole files can be counted separately.
+ */
+class ApproximateCounter {
+public:
+    explicit ApproximateCounter(const SketchSettings& settings = SketchSettings());
+
+    /**
+     * @brief Adds one occurrence of a word.
+     */
+    void add(std::string_view word) {
+        std::uint64_t hash = hashWord(word);
+        distinct_.addHash(hash);
+        heavy_.addHashed(word, hash);
+        ++total_;
+    }
+
+    /**
+     * @brief Adds another counter built with the same settings.
+     * @return false (after printing an error) if the settings differ.
+     */
+    bool merge(const ApproximateCounter& other);
+
+    /**
+     * @brief Estimated number of distinct words.
+     */
+    double distinctEstimate() const { return distinct_.estimate(); }
+
+    /**
+     * @brief Exact number of words added, including repeats.
+     */
+    std::uint64_t totalCount() const { return total_; }
+
+    /**
+     * @brief The most frequent words with their estimated counts, best first.
+     */
+    std::vector<HeavyHitters::Entry> top() const { return heavy_.top(); }
+
+    const HyperLogLog& distinct() const { return distinct_; }
+    const HeavyHitters& heavyHitters() const { return heavy_; }
+
+    /**
+     * @brief Bytes used by both sketches and the kept words.
+     */
+    std::size_t memoryUsage() const { return distinct_.memoryUsage() + heavy_.memoryUsage(); }
+
+private:
+    HyperLogLog distinct_;
+    HeavyHitters heavy_;
+    std::uint64_t total_ = 0;
+};
+
+/**
+ * @brief Sketches every word of text, serially or on several threads.
+ * @param text The whole text, e.g. the view of a MappedFile.
+ * @param script Which characters make up a word.
+ * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+ * @param settings Error bounds of the sketches.
+ * @return The merged sketches.
+ */
+ApproximateCounter approximateCount(std::string_view text, Script script, unsigned threads,
+                                    const SketchSettings& settings);
+
+/**
+ * @brief Sketches every word of a file or stdin, reading it in fixed-size blocks.
+ * @param fileName Path of the file, or "-" for standard input.
+ * @param blockSize Number of bytes read at a time.
+ * @param script Which characters make up a word.
+ * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+ * @param settings Error bounds of the sketches.
+ * @param bytesRead If not null, receives the number of bytes read.
+ * @return The merged sketches.
+ */
+ApproximateCounter approximateCountStreaming(const std::string& fileName, std::size_t blockSize, Script script,
+                                             unsigned threads, const SketchSettings& settings,
+                                             std::uint64_t* bytesRead = nullptr);
+
+/**
+ * @brief Runs the --approximate mode of a tool.
+ *
+ * Prints the exact token count, the estimated number of unique words with
+ * its error, and writes the estimated top words to options.outputFile in
+ * options.format ("rank freq word" by default). There is no exact table, so
+ * parseOptions refuses the options that save, plot or profile one.
+ * @param options Parsed command line.
+ * @param script Which characters make up a word.
+ * @return Exit status for main.
+ */
+int runApproximate(const Options& options, Script script);
+
+} // namespace corpus
+
+#endif // APPROXIMATE_COUNT_H
@@ -5,14 +5,25 @@
 #include <fstream>
 #include <vector>
 #include <string>
-#include <sstream>
+#include <string_view>
 #include <map>
-#include <set>
 #include <locale>
-#include <codecvt>
+#include "WordCounter.h"
+#include "CorpusStats.h"
+#include "RankIndex.h"
+#include "SectionCount.h"
+#include "FrequencyWriter.h"
+#include "WordEngine.h"
 
 namespace arabic {
 
+/**
+ * @brief The counting engine of this tool: runs of Arabic-block characters, as UTF-8, in the hash table.
+ *
+ * readBook below stays wide-character based, as its callers expect code points.
+ */
+using Engine = corpus::WordEngine<corpus::ArabicText>;
+
 /**
  * @brief Sets up the locale for UTF-8 output.
  */
@@ -38,9 +49,105 @@ bool isArabicAlphabet(wchar_t ch);
  */
 std::vector<wchar_t> readBook(const std::string& fileName);
 
+/**
+ * @brief Decodes a UTF-8 word made of Arabic-block characters into a wide string.
+ *
+ * @param word UTF-8 bytes of the word, as produced by corpus::forEachArabicWord.
+ * @return The word as a wide string.
+ */
+std::wstring decodeArabicWord(std::string_view word);
+
+/**
+ * @brief Encodes wide characters as UTF-8.
+ *
+ * Used wherever a wide string has to be written out, so no codecvt facet or
+ * wide stream is involved.
+ *
+ * @param text Wide characters (code points).
+ * @return The UTF-8 bytes of the text.
+ */
+std::string encodeUtf8(std::wstring_view text);
+
+/**
+ * @brief Counts every word of UTF-8 text in a flat hash table.
+ *
+ * Words are kept as their UTF-8 bytes; this is the counting engine behind
+ * computeWordFrequency and countUniqueWords.
+ *
+ * @param text UTF-8 encoded book content.
+ * @return Counter holding each distinct word and its frequency.
+ */
+corpus::WordCounter countWords(std::string_view text);
+
+/**
+ * @brief Counts every word of UTF-8 text, splitting the work across threads.
+ *
+ * Gives exactly the same counts as the serial countWords.
+ *
+ * @param text UTF-8 encoded book content.
+ * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+ * @return Counter holding each distinct word and its frequency.
+ */
+corpus::WordCounter countWords(std::string_view text, unsigned threads);
+
+/**
+ * @brief Counts every word of a UTF-8 file or stdin, reading it in fixed-size blocks.
+ *
+ * Memory use stays proportional to the vocabulary, not to the size of the input.
+ *
+ * @param fileName Path of the UTF-8 file, or "-" for standard input.
+ * @param blockSize Number of bytes read at a time.
+ * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+ * @param bytesRead If not null, receives the number of bytes read.
+ * @return Counter holding each distinct word and its frequency.
+ */
+corpus::WordCounter countWordsStreaming(const std::string& fileName, std::size_t blockSize, unsigned threads = 1,
+                                        std::uint64_t* bytesRead = nullptr);
+
+/**
+ * @brief Adds every word of UTF-8 text to an existing counter.
+ *
+ * @param text UTF-8 text; it must not start or end in the middle of a word.
+ * @param counter Counter receiving the words as UTF-8 bytes.
+ */
+void countWordsInto(std::string_view text, corpus::WordCounter& counter);
+
+/**
+ * @brief Counts every surah of UTF-8 text, along with the whole text, in one pass.
+ *
+ * The book is split at its "سورة ..." headers and the surahs are counted in
+ * parallel; see corpus::countSections.
+ *
+ * @param text UTF-8 encoded book content.
+ * @param threads Number of worker threads (0 uses all hardware threads).
+ * @return The surahs, the global table and the surah x word matrix.
+ */
+corpus::SectionCounts countSurahs(std::string_view text, unsigned threads = 1);
+
+/**
+ * @brief Computes the frequency of each word directly from UTF-8 text.
+ *
+ * Words are maximal runs of Arabic-block characters, read straight from the
+ * text (e.g. a corpus::MappedFile) without decoding the whole book first.
+ *
+ * @param text UTF-8 encoded book content.
+ * @return A map where keys are words and values are their respective frequencies.
+ */
+std::map<std::wstring, int> computeWordFrequency(std::string_view text);
+
+/**
+ * @brief Counts the number of unique words directly from UTF-8 text.
+ *
+ * @param text UTF-8 encoded book content.
+ * @return The number of unique words in the text.
+ */
+int countUniqueWords(std::string_view text);
+
 /**
  * @brief Computes the frequency of each word in the provided book.
- * 
+ *
+ * The book is encoded back to UTF-8 and counted by the byte tokenizer.
+ *
  * @param book A vector of wide characters representing the contents of the book.
  * @return A map where keys are words and values are their respective frequencies.
  */
@@ -62,6 +169,14 @@ int countUniqueWords(const std::vector<wchar_t>& book);
  */
 std::multimap<int, std::wstring> sortFrequencies(const std::map<std::wstring, int>& frequencies);
 
+/**
+ * @brief Sorts the words of a counter by frequency, decoding each distinct word once.
+ *
+ * @param counter Counter filled by countWords.
+ * @return A multimap with frequencies as keys and words as values, sorted in descending order.
+ */
+std::multimap<int, std::wstring> sortFrequencies(const corpus::WordCounter& counter);
+
 /**
  * @brief Exports sorted word frequencies to a specified output file.
  * 
@@ -70,6 +185,19 @@ std::multimap<int, std::wstring> sortFrequencies(const std::map<std::wstring, in
  */
 void exportFrequenciesToFile(const std::multimap<int, std::wstring>& sortedFreq, const std::string& outputFileName);
 
+/**
+ * @brief Exports ranked words to a file, by default in "rank freq word" format.
+ *
+ * The words are written as their UTF-8 bytes, with no wide-character conversion,
+ * through the buffered background writer.
+ *
+ * @param ranks Words in rank order.
+ * @param outputFileName The name of the file to which frequencies will be exported.
+ * @param format Text, TSV, CSV or binary columnar layout.
+ */
+void exportFrequenciesToFile(const corpus::RankIndex& ranks, const std::string& outputFileName,
+                             corpus::OutputFormat format = corpus::OutputFormat::Text);
+
 /**
  * @brief Prints hapax legomena from the sorted frequency data.
  * 
@@ -80,6 +208,16 @@ void exportFrequenciesToFile(const std::multimap<int, std::wstring>& sortedFreq,
  */
 void printHapaxLegomena(const std::multimap<int, std::wstring>& sortedFreq);
 
+/**
+ * @brief Prints hapax legomena collected by the statistics pass.
+ *
+ * Same output as the multimap version, but the list is read from the
+ * statistics instead of scanning the whole frequency table.
+ *
+ * @param stats Statistics of the book.
+ */
+void printHapaxLegomena(const corpus::CorpusStats& stats);
+
 } // namespace arabic
 
 #endif // ARABIC_H
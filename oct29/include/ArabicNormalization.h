@@ -0,0 +1,77 @@
+#ifndef ARABIC_NORMALIZATION_H
+#define ARABIC_NORMALIZATION_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace corpus {
+
+namespace detail {
+
+// One entry per code point of U+0600..U+06FF: the code point it is folded
+// to, or 0 when it is dropped. Built at compile time.
+constexpr std::array<std::uint16_t, 256> makeArabicFoldTable() {
+    std::array<std::uint16_t, 256> table{};
+    for (std::size_t i = 0; i < table.size(); ++i) {
+        table[i] = static_cast<std::uint16_t>(0x0600 + i);
+    }
+
+    auto drop = [&table](std::uint16_t first, std::uint16_t last) {
+        for (std::uint16_t cp = first; cp <= last; ++cp) {
+            table[cp - 0x0600] = 0;
+        }
+    };
+    drop(0x0610, 0x061A);  // Quranic honorifics and small high letters
+    drop(0x0640, 0x0640);  // tatweel
+    drop(0x064B, 0x065F);  // tashkeel: tanween, fatha, damma, kasra, shadda, sukun, maddah and hamza marks
+    drop(0x0670, 0x0670);  // superscript alef
+    drop(0x06D6, 0x06DC);  // Quranic pause marks
+    drop(0x06DF, 0x06E4);  // Quranic small high marks
+    drop(0x06E7, 0x06E8);
+    drop(0x06EA, 0x06ED);
+
+    // alef carrying a hamza or madda, and alef wasla, become a bare alef
+    for (std::uint16_t cp : {0x0622, 0x0623, 0x0625, 0x0671, 0x0672, 0x0673}) {
+        table[cp - 0x0600] = 0x0627;
+    }
+    return table;
+}
+
+inline constexpr std::array<std::uint16_t, 256> arabicFoldTable = makeArabicFoldTable();
+
+} // namespace detail
+
+/**
+ * @brief Writes the normalized form of an Arabic word into a reusable buffer.
+ *
+ * Diacritics (tashkeel), tatweel and Quranic annotation marks are dropped,
+ * and the alef variants (with hamza above or below, with madda, wasla) are
+ * folded to a bare alef, using a table built at compile time. Every
+ * character in and out of the table is two UTF-8 bytes, so the word is
+ * rewritten in place pair by pair.
+ * @param word UTF-8 bytes of a word, as produced by forEachArabicWord.
+ * @param out Buffer that receives the normalized word; its capacity is reused between calls.
+ *            It is empty when the word was made only of dropped marks.
+ */
+inline void foldArabicWord(std::string_view word, std::string& out) {
+    out.resize(word.size());
+    std::size_t size = 0;
+    for (std::size_t i = 0; i + 1 < word.size(); i += 2) {
+        auto lead = static_cast<unsigned char>(word[i]);
+        auto tail = static_cast<unsigned char>(word[i + 1]);
+        std::uint16_t cp = detail::arabicFoldTable[((lead & 0x03) << 6) | (tail & 0x3F)];
+        if (cp != 0) {
+            out[size] = static_cast<char>(0xC0 | (cp >> 6));
+            out[size + 1] = static_cast<char>(0x80 | (cp & 0x3F));
+            size += 2;
+        }
+    }
+    out.resize(size);
+}
+
+} // namespace corpus
+
+#endif // ARABIC_NORMALIZATION_H
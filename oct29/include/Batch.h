@@ -0,0 +1,82 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Counting.h"
+#include "Options.h"
+#include "WordCounter.h"
+
+namespace corpus {
+
+/**
+ * @brief Settings of a multi-book run.
+ */
+struct BatchSettings {
+    Script script = Script::Ascii;     ///< Which characters make up a word.
+    unsigned threads = 1;              ///< Pool workers (0 uses every hardware thread).
+    std::size_t splitSize = 8 << 20;   ///< Books larger than this are counted in pieces of about this size.
+    std::string outputDir = ".";       ///< Where the per-book tables go (empty to skip them).
+    std::size_t top = 0;               ///< When non-zero, only the K most frequent words are written.
+    OutputFormat format = OutputFormat::Text;  ///< Layout of the written tables.
+};
+
+/**
+ * @brief Totals of a multi-book run.
+ */
+struct BatchSummary {
+    std::size_t books = 0;       ///< Books that were counted.
+    std::size_t failed = 0;      ///< Books that could not be opened.
+    std::size_t unwritten = 0;   ///< Books whose per-book table could not be written.
+    std::uint64_t bytes = 0;     ///< Bytes read over all books.
+    WordCounter global;          ///< Merged counts of every book.
+};
+
+/**
+ * @brief Lists the books of a batch.
+ *
+ * A directory gives its regular files (not recursively), in name order;
+ * any other path is read as a list with one book path per line (blank
+ * lines and lines starting with '#' are skipped).
+ * @param path Directory or list file.
+ * @return Book paths; empty (after printing an error) if the path cannot be read.
+ */
+std::vector<std::string> listBatchInputs(const std::string& path);
+
+/**
+ * @brief Name of the per-book table written for a book, e.g. "pg2701.freq.txt".
+ */
+std::string batchOutputName(const std::string& book);
+
+/**
+ * @brief Counts many books on a work-stealing pool.
+ *
+ * Books are queued largest first. A book larger than splitSize is split at
+ * word boundaries and its pieces are queued as separate tasks, so idle
+ * workers steal them and one huge file does not finish long after the
+ * rest. When the last piece of a book is done, its counts are merged,
+ * ranked and written to outputDir/batchOutputName(book), and folded into
+ * the calling worker's share of the global table.
+ * @param books Paths of the books.
+ * @param settings Script, threads, split size and output directory.
+ * @return Totals, including the merged global counter.
+ */
+BatchSummary countBatch(const std::vector<std::string>& books, const BatchSettings& settings);
+
+/**
+ * @brief Runs the --batch mode of a tool.
+ *
+ * Lists the books of options.batch, counts them with countBatch, writes
+ * the merged global table to options.outputFile and prints a summary.
+ * @param options Parsed command line.
+ * @param script Which characters make up a word.
+ * @return Exit status for main: 1 when a book could not be read or a table
+ *         could not be written.
+ */
+int runBatch(const Options& options, Script script);
+
+} // namespace corpus
+
+#endif // BATCH_H
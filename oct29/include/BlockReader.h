@@ -0,0 +1,138 @@
+#ifndef BLOCK_READER_H
+#define BLOCK_READER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "ParallelCount.h"
+#include "SpscQueue.h"
+
+namespace corpus {
+
+/**
+ * @brief Reads a file or stdin in fixed-size blocks that end on word boundaries.
+ *
+ * Only a few blocks (plus the unfinished word carried over between them)
+ * are in memory at a time, so a corpus of any size can be streamed
+ * through the counters. A reader thread fills blocks ahead of the caller
+ * and hands them over through a lock-free queue, so the disk reads the
+ * next blocks while the current one is counted. The file name "-" reads
+ * standard input.
+ */
+class BlockReader {
+public:
+    /**
+     * @brief Number of blocks the reader thread may fill ahead of the one being counted.
+     */
+    static constexpr std::size_t readAhead = 3;
+
+    /**
+     * @brief Opens the input and starts reading it.
+     * @param fileName Path of the file to read, or "-" for standard input.
+     * @param blockSize Number of bytes read per block.
+     * @param isWordByte Tells which bytes may belong to a word, so blocks are never cut inside one.
+     */
+    BlockReader(const std::string& fileName, std::size_t blockSize, WordBytePredicate isWordByte);
+
+    /**
+     * @brief Stops the reader thread, even if the input was not read to the end.
+     */
+    ~BlockReader();
+
+    BlockReader(const BlockReader&) = delete;
+    BlockReader& operator=(const BlockReader&) = delete;
+
+    /**
+     * @brief Tells whether the input could be opened.
+     */
+    bool isOpen() const { return fd_ >= 0; }
+
+    /**
+     * @brief Returns the next block, waiting for it if the reader is behind.
+     *
+     * The view stays valid until the next call. A word cut by the end of the
+     * read is held back and handed out at the front of the next block.
+     * @param block Receives the block.
+     * @return false once the input is exhausted.
+     */
+    bool next(std::string_view& block);
+
+    /**
+     * @brief Number of bytes read from the input so far.
+     */
+    std::uint64_t bytesRead() const { return bytesRead_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr std::size_t noBuffer = static_cast<std::size_t>(-1);
+
+    struct Filled {
+        std::size_t buffer;  // index into buffers_, noBuffer marks the end of the input
+        std::size_t size;    // bytes of the block at the front of the buffer
+    };
+
+    void readLoop();
+    bool fill(std::vector<char>& buffer, std::size_t& filled);
+
+    int fd_ = -1;
+    bool ownsFd_ = false;
+    bool regular_ = false;  // a regular file, so the kernel can be told what comes next
+    bool done_ = false;
+    WordBytePredicate isWordByte_;
+    std::size_t blockSize_;
+    std::vector<std::vector<char>> buffers_;
+    SpscQueue<std::size_t> free_;  // buffers handed back to the reader thread
+    SpscQueue<Filled> filled_;     // blocks ready for next(), in input order
+    std::size_t current_ = noBuffer;  // buffer of the block returned by the last call
+    std::atomic<bool> stop_{false};
+    std::atomic<std::uint64_t> bytesRead_{0};
+    std::thread reader_;
+};
+
+/**
+ * @brief Counts the words of a file or stdin without holding the whole text in memory.
+ *
+ * Memory use is a few blocks plus the counters, i.e. proportional to the
+ * vocabulary rather than to the corpus; the next blocks are read while
+ * the current one is counted. With several threads every block is split
+ * at word boundaries across workers that each keep their own counter for
+ * the whole stream; the counters are merged once at the end.
+ * @param fileName Path of the file to read, or "-" for standard input.
+ * @param blockSize Number of bytes read per block.
+ * @param threads Number of worker threads (1 counts serially, 0 uses all hardware threads).
+ * @param isWordByte Tells which bytes may belong to a word.
+ * @param countChunk Callable (std::string_view block, WordCounter& counter) that counts one block.
+ * @param bytesRead If not null, receives the number of bytes read.
+ * @return Counter holding every word of the input.
+ */
+template <typename CountChunk>
+WordCounter countStream(const std::string& fileName, std::size_t blockSize, unsigned threads,
+                        WordBytePredicate isWordByte, CountChunk countChunk, std::uint64_t* bytesRead = nullptr) {
+    threads = resolveThreads(threads);
+    std::vector<WordCounter> partials(threads);
+    BlockReader reader(fileName, blockSize, isWordByte);
+    std::string_view block;
+    while (reader.next(block)) {
+        if (threads == 1) {
+            countChunk(block, partials[0]);
+            continue;
+        }
+        std::vector<std::string_view> chunks = splitAtWordBoundaries(block, threads, isWordByte);
+        runOnChunks(chunks, [&](std::size_t i, std::string_view chunk) { countChunk(chunk, partials[i]); });
+    }
+    if (bytesRead != nullptr) {
+        *bytesRead = reader.bytesRead();
+    }
+    if (threads == 1) {
+        return std::move(partials[0]);
+    }
+    return mergeSharded(partials, threads);
+}
+
+} // namespace corpus
+
+#endif // BLOCK_READER_H
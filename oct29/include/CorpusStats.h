@@ -0,0 +1,145 @@
+#ifndef CORPUS_STATS_H
+#define CORPUS_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Counting.h"
+#include "FrequencySpectrum.h"
+#include "TokenStream.h"
+#include "WordCounter.h"
+
+namespace corpus {
+
+/**
+ * @brief Every statistic the tools report, computed from a single tokenizing pass.
+ *
+ * The text is tokenized once into a WordCounter, and a FrequencySpectrum
+ * follows the counts as they change, so the vocabulary size, V(m), the
+ * hapax list and the richness measures are read without walking the table.
+ */
+class CorpusStats {
+public:
+    CorpusStats() = default;
+
+    /**
+     * @brief Builds the statistics from an already filled counter.
+     * @param counter Counter holding every word of the corpus.
+     */
+    explicit CorpusStats(WordCounter counter);
+
+    /**
+     * @brief Tokenizes text once and builds the statistics.
+     * @param text The whole text, e.g. the view of a MappedFile.
+     * @param script Which characters make up a word.
+     * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+     * @param growth If not null, receives the vocabulary growth curve of the same pass.
+     */
+    static CorpusStats fromText(std::string_view text, Script script, unsigned threads = 1,
+                                VocabularyGrowth* growth = nullptr);
+
+    /**
+     * @brief Counts text by sorting its tokens (SortCounting) and builds the statistics.
+     *
+     * The same counts as fromText, reached by radix sorting every token and
+     * counting the runs; the runs then fill the table in one insert per
+     * distinct word. There is no growth curve, as no word is seen in text
+     * order.
+     * @param text The whole text, e.g. the view of a MappedFile.
+     * @param script Which characters make up a word.
+     * @param threads Threads for the sort (0 uses all hardware threads).
+     */
+    static CorpusStats fromTextBySorting(std::string_view text, Script script, unsigned threads = 1);
+
+    /**
+     * @brief Streams a file or stdin once and builds the statistics.
+     * @param fileName Path of the file, or "-" for standard input.
+     * @param blockSize Number of bytes read at a time.
+     * @param script Which characters make up a word.
+     * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+     * @param growth If not null, receives the vocabulary growth curve of the same pass.
+     */
+    static CorpusStats fromStream(const std::string& fileName, std::size_t blockSize, Script script, unsigned threads = 1,
+                                  VocabularyGrowth* growth = nullptr);
+
+    /**
+     * @brief Builds the statistics from a dictionary-encoded token stream, without tokenizing.
+     * @param tokens The stream, e.g. loaded from a file saved by an earlier run.
+     * @param growth If not null, receives the vocabulary growth curve of the stream.
+     */
+    static CorpusStats fromTokens(const TokenStream& tokens, VocabularyGrowth* growth = nullptr);
+
+    // copying would duplicate the whole table; move it instead
+    CorpusStats(const CorpusStats&) = delete;
+    CorpusStats& operator=(const CorpusStats&) = delete;
+    CorpusStats(CorpusStats&&) = default;
+    CorpusStats& operator=(CorpusStats&&) = default;
+
+    /**
+     * @brief Number of words in the corpus, repeats included.
+     */
+    std::uint64_t totalTokens() const { return counter_.totalCount(); }
+
+    /**
+     * @brief Number of distinct words.
+     */
+    std::size_t vocabularySize() const { return counter_.size(); }
+
+    /**
+     * @brief Number of bytes of input that were tokenized.
+     */
+    std::uint64_t bytesProcessed() const { return bytes_; }
+
+    /**
+     * @brief The frequency table.
+     */
+    const WordCounter& frequencies() const { return counter_; }
+
+    /**
+     * @brief The frequency spectrum with its richness measures and Good-Turing estimates.
+     */
+    const FrequencySpectrum& frequencySpectrum() const { return spectrum_; }
+
+    /**
+     * @brief The frequency spectrum, by increasing frequency; classes with no words are left out.
+     */
+    std::vector<SpectrumClass> spectrum() const { return spectrum_.classes(counter_); }
+
+    /**
+     * @brief V(m): how many distinct words occur exactly m times.
+     */
+    std::uint64_t wordsWithFrequency(std::uint64_t m) const { return spectrum_.wordsWithFrequency(m, counter_); }
+
+    /**
+     * @brief The first words, in byte order, of a class that keeps its words (hapax or dis legomena).
+     * @param m The frequency, at most frequencySpectrum().listedClasses().
+     * @param limit How many words to return; only those are sorted.
+     */
+    std::vector<std::string_view> wordsOccurring(std::uint64_t m,
+                                                 std::size_t limit = std::numeric_limits<std::size_t>::max()) const;
+
+    /**
+     * @brief The first words that occur only once, in byte order.
+     */
+    std::vector<std::string_view> hapaxLegomena(std::size_t limit = std::numeric_limits<std::size_t>::max()) const {
+        return wordsOccurring(1, limit);
+    }
+
+private:
+    WordCounter counter_;
+    std::uint64_t bytes_ = 0;
+    FrequencySpectrum spectrum_;
+};
+
+/**
+ * @brief Prints the dis legomena count, the Good-Turing unseen mass and the richness measures, one per line.
+ */
+void printSpectrumSummary(const FrequencySpectrum& spectrum, std::ostream& out);
+
+} // namespace corpus
+
+#endif // CORPUS_STATS_H
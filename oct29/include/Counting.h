@@ -0,0 +1,101 @@
+#ifndef COUNTING_H
+#define COUNTING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "FrequencySpectrum.h"
+#include "ParallelCount.h"
+#include "Tokenizer.h"
+#include "VocabularyGrowth.h"
+#include "WordCounter.h"
+#include "WordEngine.h"
+
+namespace corpus {
+
+/**
+ * @brief Which characters make up a word, chosen at runtime.
+ *
+ * Each script names one encoding policy of WordEngine.h (AsciiText,
+ * ArabicText, NormalizedArabicText); the functions below switch to it once
+ * per call.
+ */
+enum class Script {
+    Ascii,   ///< Runs of ASCII letters, lowercased (ZipF, ZipF2).
+    Arabic,  ///< Runs of U+0600..U+06FF characters, kept as UTF-8 bytes (Arabic).
+    ArabicNormalized  ///< As Arabic, with diacritics and tatweel dropped and alef variants folded.
+};
+
+/**
+ * @brief The bytes that may belong to a word of the given script.
+ */
+WordBytePredicate wordBytePredicate(Script script);
+
+/**
+ * @brief Calls onWord for every word of text, exactly as the counters see it.
+ *
+ * ASCII words arrive lowercased, Arabic words as UTF-8 bytes (normalized
+ * for Script::ArabicNormalized). The views are only valid during the call.
+ * @param script Which characters make up a word.
+ * @param text Text that does not start or end in the middle of a word.
+ * @param onWord Callable taking a std::string_view.
+ */
+template <typename OnWord>
+void forEachWord(Script script, std::string_view text, OnWord&& onWord) {
+    // one switch per call, then the encoding policy's loop runs inlined
+    switch (script) {
+    case Script::Arabic:
+        ArabicText::forEachWord(text, onWord);
+        break;
+    case Script::ArabicNormalized:
+        NormalizedArabicText::forEachWord(text, onWord);
+        break;
+    default:
+        AsciiText::forEachWord(text, onWord);
+        break;
+    }
+}
+
+/**
+ * @brief Adds every word of text to an existing counter.
+ * @param script Which characters make up a word.
+ * @param text Text that does not start or end in the middle of a word.
+ * @param counter Counter receiving the words.
+ */
+void countWordsInto(Script script, std::string_view text, WordCounter& counter);
+
+/**
+ * @brief Counts every word of text, serially or on several threads.
+ * @param text The whole text, e.g. the view of a MappedFile.
+ * @param script Which characters make up a word.
+ * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+ * @param growth If not null, receives the vocabulary growth curve; it is exact
+ *        with any number of threads.
+ * @param spectrum If not null, receives the frequency spectrum of the table: token
+ *        by token when counting serially, from the merged table otherwise.
+ * @return Counter holding each distinct word and its frequency.
+ */
+WordCounter countWords(std::string_view text, Script script, unsigned threads = 1, VocabularyGrowth* growth = nullptr,
+                       FrequencySpectrum* spectrum = nullptr);
+
+/**
+ * @brief Counts every word of a file or stdin, reading it in fixed-size blocks.
+ * @param fileName Path of the file, or "-" for standard input.
+ * @param blockSize Number of bytes read at a time.
+ * @param script Which characters make up a word.
+ * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+ * @param bytesRead If not null, receives the number of bytes read.
+ * @param growth If not null, receives the vocabulary growth curve; it is exact
+ *        with any number of threads.
+ * @param spectrum If not null, receives the frequency spectrum of the table: token
+ *        by token when counting serially, from the merged table otherwise.
+ * @return Counter holding each distinct word and its frequency.
+ */
+WordCounter countWordsStreaming(const std::string& fileName, std::size_t blockSize, Script script,
+                                unsigned threads = 1, std::uint64_t* bytesRead = nullptr,
+                                VocabularyGrowth* growth = nullptr, FrequencySpectrum* spectrum = nullptr);
+
+} // namespace corpus
+
+#endif // COUNTING_H
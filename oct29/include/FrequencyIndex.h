@@ -0,0 +1,163 @@
+#ifndef FREQUENCY_INDEX_H
+#define FREQUENCY_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include "Counting.h"
+#include "MappedFile.h"
+#include "Options.h"
+#include "WordCounter.h"
+
+namespace corpus {
+
+/**
+ * @brief Fixed-size header at the start of a frequency index file.
+ *
+ * Layout of the file, all integers in the byte order of the machine that
+ * wrote it (checked through byteOrder):
+ *   header (64 bytes)
+ *   offsets: wordCount + 1 uint64, start of each word in the byte section
+ *   counts:  wordCount uint64, in the same order as the words
+ *   bytes:   the words, sorted in byte order and concatenated
+ * Every section starts on an 8-byte boundary, so the arrays are used in
+ * place from the mapping.
+ */
+struct IndexHeader {
+    char magic[8];              ///< "CORPIDX" followed by a zero byte.
+    std::uint32_t version;      ///< Format version, currently 1.
+    std::uint32_t byteOrder;    ///< 0x01020304 as written by the producer.
+    std::uint32_t script;       ///< The Script the words were tokenized with.
+    std::uint32_t reserved;
+    std::uint64_t wordCount;    ///< Number of distinct words.
+    std::uint64_t totalCount;   ///< Number of tokens, including repeats.
+    std::uint64_t bytesSize;    ///< Size of the byte section.
+    std::uint64_t padding[2];
+};
+
+static_assert(sizeof(IndexHeader) == 64, "the index header must stay 64 bytes");
+
+/**
+ * @brief Read-only view of a frequency index file, queried straight from the mapping.
+ *
+ * Nothing is parsed when the file is opened beyond checking the header;
+ * a lookup is a binary search over the sorted vocabulary.
+ * If the file is missing or not a valid index, an error is printed and the
+ * index is empty.
+ */
+class FrequencyIndex {
+public:
+    static constexpr std::uint32_t currentVersion = 1;
+
+    FrequencyIndex() = default;
+
+    /**
+     * @brief Maps an index file and checks its header.
+     * @param fileName Path of the index.
+     */
+    explicit FrequencyIndex(const std::string& fileName);
+
+    /**
+     * @brief Tells whether a valid index is mapped.
+     */
+    bool isOpen() const { return header_ != nullptr; }
+
+    /**
+     * @brief Number of distinct words.
+     */
+    std::size_t size() const { return header_ != nullptr ? header_->wordCount : 0; }
+
+    /**
+     * @brief Number of tokens, including repeats.
+     */
+    std::uint64_t totalCount() const { return header_ != nullptr ? header_->totalCount : 0; }
+
+    /**
+     * @brief The script the words were tokenized with.
+     */
+    Script script() const { return static_cast<Script>(header_ != nullptr ? header_->script : 0); }
+
+    /**
+     * @brief The word at a position in byte order.
+     */
+    std::string_view word(std::size_t i) const {
+        return std::string_view(bytes_ + offsets_[i], offsets_[i + 1] - offsets_[i]);
+    }
+
+    /**
+     * @brief The count of the word at a position in byte order.
+     */
+    std::uint64_t countAt(std::size_t i) const { return counts_[i]; }
+
+    /**
+     * @brief Returns how many times a word was counted (0 if never), by binary search.
+     */
+    std::uint64_t count(std::string_view word) const;
+
+    /**
+     * @brief Calls fn(std::string_view word, std::uint64_t count) for every word, in byte order.
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (std::size_t i = 0; i < size(); ++i) {
+            fn(word(i), counts_[i]);
+        }
+    }
+
+    /**
+     * @brief Copies the index into a counter, e.g. to rank it.
+     */
+    WordCounter toCounter() const;
+
+    /**
+     * @brief A 64-bit hash of the whole file, so files derived from an index can tell it changed.
+     */
+    std::uint64_t checksum() const { return header_ != nullptr ? hashWord(file_.view()) : 0; }
+
+private:
+    MappedFile file_;
+    const IndexHeader* header_ = nullptr;
+    const std::uint64_t* offsets_ = nullptr;
+    const std::uint64_t* counts_ = nullptr;
+    const char* bytes_ = nullptr;
+};
+
+/**
+ * @brief Writes the words of a counter as a new index file (replacing any existing one).
+ * @param fileName Path of the index.
+ * @param counter Counts to store.
+ * @param script The script the words were tokenized with.
+ * @return false (after printing an error) if the file cannot be written.
+ */
+bool writeFrequencyIndex(const std::string& fileName, const WordCounter& counter, Script script);
+
+/**
+ * @brief Folds new counts into an existing index, without the text it was built from.
+ *
+ * The sorted vocabulary of the index and the sorted new words are merged
+ * in one linear pass into a temporary file that then replaces the index,
+ * so readers never see a half-written file. A missing index is created.
+ * @param fileName Path of the index.
+ * @param counter Counts of the new text.
+ * @param script The script of the new text; it must match the index.
+ * @return false (after printing an error) if the index cannot be updated.
+ */
+bool appendToFrequencyIndex(const std::string& fileName, const WordCounter& counter, Script script);
+
+/**
+ * @brief Runs the --append-index mode of a tool.
+ *
+ * Counts the input (mapped or streamed, or the saved token stream of
+ * --tokens) and folds it into options.appendIndex; with --save-tokens the
+ * input is also saved as a token stream.
+ * @param options Parsed command line.
+ * @param script Which characters make up a word.
+ * @return Exit status for main.
+ */
+int runIndexAppend(const Options& options, Script script);
+
+} // namespace corpus
+
+#endif // FREQUENCY_INDEX_H
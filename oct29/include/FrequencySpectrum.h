@@ -0,0 +1,215 @@
+#ifndef FREQUENCY_SPECTRUM_H
+#define FREQUENCY_SPECTRUM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "WordCounter.h"
+
+namespace corpus {
+
+/**
+ * @brief One class of the frequency spectrum: how many words occur exactly m times.
+ */
+struct SpectrumClass {
+    std::uint64_t frequency;  ///< m
+    std::uint64_t words;      ///< V(m), the number of distinct words seen m times
+};
+
+/**
+ * @brief The frequency spectrum of a WordCounter, kept up to date as it counts.
+ *
+ * Every change of a word's count is recorded as it happens (record, fed
+ * from WordCounter::addCounted), so V(m), the lexical richness measures and
+ * the Good-Turing estimates are read in constant time at any point of the
+ * count, without walking the table. The lowest classes (hapax and dis
+ * legomena by default) also keep their words, with a swap-remove list per
+ * class; a word passes through each of them at most once, so keeping them
+ * costs a bounded number of updates per distinct word. A word's place in
+ * its list is kept in a flat array indexed by WordRef::id.
+ *
+ * Counting serially feeds every change as it happens; the parallel and
+ * streaming paths count into separate tables and record the merged table
+ * once (recordTable). Either way the finished spectrum describes the
+ * returned table exactly; only the order of the listed words differs.
+ *
+ * V(m) is kept in an array for m up to exactLimit. The few words that go
+ * beyond it are only noted when they cross it, so their tokens cost no
+ * spectrum update beyond the running sums; queries above the limit look up
+ * their current counts in the counter.
+ */
+class FrequencySpectrum {
+public:
+    /// Highest frequency whose V(m) is kept exactly as counting goes.
+    static constexpr std::uint64_t exactLimit = 1 << 12;
+
+    /**
+     * @param listedClasses Classes 1..listedClasses keep their words (2: hapax and dis legomena).
+     */
+    explicit FrequencySpectrum(std::uint64_t listedClasses = 2);
+
+    /**
+     * @brief Records that a word's count went from one value to another.
+     * @param word The word, as WordCounter::addCounted reports it.
+     * @param from Count before (0 for a new word).
+     * @param to Count after.
+     */
+    void record(WordCounter::WordRef word, std::uint64_t from, std::uint64_t to) {
+        if (from == to) {
+            return;
+        }
+        tokens_ += to - from;
+        squares_.addProduct(to - from, to + from);  // to^2 - from^2
+        // Mostly a word moving up between two classes that only count words.
+        // Counts past exactLimit land in a spare cell, where they cancel out,
+        // so frequent and rare words take the same branch.
+        std::uint64_t before = std::min(from, exactLimit + 1);
+        std::uint64_t after = std::min(to, exactLimit + 1);
+        if ((from > listedClasses_) & !(before <= exactLimit && after > exactLimit)) {
+            --classes_[before];
+            ++classes_[after];
+            return;
+        }
+        recordMove(word, from, to);
+    }
+
+    /**
+     * @brief Records every word of a finished table, as if it had been counted in one go.
+     */
+    void recordTable(const WordCounter& counter);
+
+    /**
+     * @brief Number of distinct words, V.
+     */
+    std::uint64_t vocabularySize() const { return vocabulary_; }
+
+    /**
+     * @brief Number of tokens, N.
+     */
+    std::uint64_t tokens() const { return tokens_; }
+
+    /**
+     * @brief V(m) for m up to exactLimit, in constant time.
+     */
+    std::uint64_t wordsWithFrequency(std::uint64_t m) const {
+        return m != 0 && m <= exactLimit ? classes_[m] : 0;
+    }
+
+    /**
+     * @brief V(m) for any m; above exactLimit the counter the spectrum was fed from is consulted.
+     */
+    std::uint64_t wordsWithFrequency(std::uint64_t m, const WordCounter& counter) const;
+
+    /**
+     * @brief Words that occur only once, V(1).
+     */
+    std::uint64_t hapaxLegomena() const { return wordsWithFrequency(1); }
+
+    /**
+     * @brief Words that occur exactly twice, V(2).
+     */
+    std::uint64_t disLegomena() const { return wordsWithFrequency(2); }
+
+    /**
+     * @brief Number of classes that keep their words.
+     */
+    std::uint64_t listedClasses() const { return listedClasses_; }
+
+    /**
+     * @brief The words occurring exactly m times, in no particular order; empty above listedClasses().
+     */
+    const std::vector<WordCounter::WordRef>& wordsOf(std::uint64_t m) const;
+
+    /**
+     * @brief The whole spectrum, by increasing frequency; classes with no words are left out.
+     * @param counter The counter the spectrum was fed from.
+     */
+    std::vector<SpectrumClass> classes(const WordCounter& counter) const;
+
+    /**
+     * @brief Good-Turing adjusted count of a word seen r times: (r + 1) V(r + 1) / V(r).
+     *
+     * Falls back to r itself where V(r) or V(r + 1) is zero, as the raw
+     * estimate is unusable there.
+     */
+    double goodTuringCount(std::uint64_t r) const;
+
+    /**
+     * @brief Good-Turing probability that the next token is a word not seen yet: V(1) / N.
+     */
+    double unseenProbability() const;
+
+    /**
+     * @brief Type-token ratio V / N.
+     */
+    double typeTokenRatio() const;
+
+    /**
+     * @brief Yule's K, 10^4 (sum of m^2 V(m) - N) / N^2; lower means a richer vocabulary.
+     */
+    double yulesK() const;
+
+    /**
+     * @brief Honore's R, 100 ln N / (1 - V(1) / V); infinite when every word is a hapax.
+     */
+    double honoresR() const;
+
+    /**
+     * @brief Sichel's S, V(2) / V.
+     */
+    double sichelsS() const;
+
+    /**
+     * @brief Brunet's W, N^(V^-0.165); lower means a richer vocabulary.
+     */
+    double brunetsW() const;
+
+    /**
+     * @brief Herdan's C, ln V / ln N.
+     */
+    double herdansC() const;
+
+private:
+    // An unsigned 128-bit sum as two 64-bit halves, as standard C++ has no
+    // 128-bit integer; the sum of squared counts of a large crawl passes 2^64.
+    struct WideSum {
+        std::uint64_t high = 0;
+        std::uint64_t low = 0;
+
+        void add(std::uint64_t value) {
+            low += value;
+            high += low < value;
+        }
+
+        void addProduct(std::uint64_t a, std::uint64_t b) {
+            if (((a | b) >> 32) == 0) {
+                add(a * b);  // the usual case, a count moving up by one
+            } else {
+                addWideProduct(a, b);
+            }
+        }
+
+        void addWideProduct(std::uint64_t a, std::uint64_t b);
+
+        /// The sum minus value, as a double.
+        double minus(std::uint64_t value) const;
+    };
+
+    void recordMove(WordCounter::WordRef word, std::uint64_t from, std::uint64_t to);
+    void moveListed(WordCounter::WordRef word, std::uint64_t from, std::uint64_t to);
+
+    std::uint64_t listedClasses_;
+    std::uint64_t vocabulary_ = 0;
+    std::uint64_t tokens_ = 0;
+    WideSum squares_;                               // sum over words of count^2
+    std::vector<std::uint64_t> classes_;            // V(m) for m <= exactLimit, then the spare cell
+    std::vector<WordCounter::WordRef> above_;       // words whose count went past exactLimit
+    std::vector<std::vector<WordCounter::WordRef>> listed_;  // words of classes 1..listedClasses_
+    std::vector<std::uint32_t> listPositions_;      // place of a listed word in its list, by WordRef::id
+};
+
+} // namespace corpus
+
+#endif // FREQUENCY_SPECTRUM_H
@@ -0,0 +1,163 @@
+#ifndef FREQUENCY_WRITER_H
+#define FREQUENCY_WRITER_H
+
+#include <charconv>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "RankIndex.h"
+#include "WordCounter.h"
+
+namespace corpus {
+
+/**
+ * @brief Output file that is filled in large buffers and written by a background thread.
+ *
+ * The caller formats into one buffer while the writer thread hands the
+ * previous one to the kernel, so formatting and I/O overlap and there is
+ * one write call per buffer instead of one flush per line.
+ * If the file cannot be created, an error is printed and writes are dropped.
+ */
+class BufferedWriter {
+public:
+    /**
+     * @brief Creates (or truncates) the file and starts the writer thread.
+     * @param fileName Path of the file to write.
+     * @param bufferSize Size of each of the two buffers.
+     */
+    explicit BufferedWriter(const std::string& fileName, std::size_t bufferSize = 1 << 20);
+
+    /**
+     * @brief Flushes and closes the file (see close()).
+     */
+    ~BufferedWriter();
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    /**
+     * @brief Tells whether the file could be created.
+     */
+    bool isOpen() const { return fd_ >= 0; }
+
+    /**
+     * @brief Appends bytes to the output.
+     */
+    void write(std::string_view bytes) {
+        if (bytes.size() > buffer_.size() - used_) {
+            writeSlow(bytes);
+            return;
+        }
+        std::memcpy(buffer_.data() + used_, bytes.data(), bytes.size());
+        used_ += bytes.size();
+    }
+
+    /**
+     * @brief Appends one byte.
+     */
+    void put(char c) {
+        if (used_ == buffer_.size()) {
+            handOff();
+        }
+        buffer_[used_++] = c;
+    }
+
+    /**
+     * @brief Appends an unsigned integer in decimal, formatted with std::to_chars.
+     */
+    void writeUnsigned(std::uint64_t value) {
+        if (buffer_.size() - used_ < 20) {
+            handOff();
+        }
+        char* end = std::to_chars(buffer_.data() + used_, buffer_.data() + buffer_.size(), value).ptr;
+        used_ = static_cast<std::size_t>(end - buffer_.data());
+    }
+
+    /**
+     * @brief Appends the raw bytes of a trivially copyable value (for binary formats).
+     */
+    template <typename T>
+    void writeRaw(const T& value) {
+        write(std::string_view(reinterpret_cast<const char*>(&value), sizeof(value)));
+    }
+
+    /**
+     * @brief Writes out everything still buffered, stops the thread and closes the file.
+     * @return false if any write failed.
+     */
+    bool close();
+
+private:
+    void writeSlow(std::string_view bytes);
+    void handOff();
+    void run();
+
+    int fd_ = -1;
+    std::string fileName_;
+    std::vector<char> buffer_;   // being filled by the caller
+    std::size_t used_ = 0;
+    std::vector<char> pending_;  // being written by the thread
+    std::size_t pendingSize_ = 0;
+    bool hasPending_ = false;
+    bool done_ = false;
+    bool failed_ = false;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::thread thread_;
+};
+
+/**
+ * @brief Layouts of a ranked frequency table.
+ */
+enum class OutputFormat {
+    Text,     ///< "rank freq word" lines, the tools' historical format.
+    Tsv,      ///< Tab-separated with a "rank count word" header line.
+    Csv,      ///< Comma-separated with a header line, words quoted when needed.
+    Columnar  ///< Binary columns, see ColumnarHeader.
+};
+
+/**
+ * @brief Header of the binary columnar format.
+ *
+ * Followed by rowCount uint64 counts, rowCount + 1 uint64 word offsets and
+ * the concatenated words, all in rank order (the rank is the row number
+ * plus one) and in the byte order of the writer (checked through byteOrder).
+ */
+struct ColumnarHeader {
+    char magic[8];             ///< "CORPCOL" followed by a zero byte.
+    std::uint32_t version;     ///< Format version, currently 1.
+    std::uint32_t byteOrder;   ///< 0x01020304 as written by the producer.
+    std::uint64_t rowCount;    ///< Number of ranked words.
+    std::uint64_t bytesSize;   ///< Size of the word section.
+};
+
+/**
+ * @brief Reads a format name ("text", "tsv", "csv" or "columnar").
+ * @return false if the name is unknown.
+ */
+bool parseOutputFormat(std::string_view name, OutputFormat& format);
+
+/**
+ * @brief Writes ranked words through a BufferedWriter.
+ * @param ranked Words in rank order.
+ * @param fileName Path of the output file.
+ * @param format Layout of the table.
+ * @return false (after printing an error) if the file cannot be written.
+ */
+bool writeFrequencies(const std::vector<WordCounter::Entry>& ranked, const std::string& fileName,
+                      OutputFormat format = OutputFormat::Text);
+
+/**
+ * @brief Writes a rank index through a BufferedWriter.
+ */
+bool writeFrequencies(const RankIndex& ranks, const std::string& fileName, OutputFormat format = OutputFormat::Text);
+
+} // namespace corpus
+
+#endif // FREQUENCY_WRITER_H
@@ -0,0 +1,65 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace corpus {
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * The file is mapped once and exposed as a contiguous buffer, so the
+ * tokenizers can walk the bytes directly instead of copying the book
+ * character by character into a vector first.
+ * If the file cannot be opened, an error is printed and the mapping is empty.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    /**
+     * @brief Maps the given file into memory.
+     * @param fileName Path of the file to map.
+     */
+    explicit MappedFile(const std::string& fileName);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    /**
+     * @brief Tells whether the file was opened (an empty file is still open).
+     */
+    bool isOpen() const { return open_; }
+
+    /**
+     * @brief Pointer to the first byte of the mapping.
+     */
+    const char* data() const { return data_; }
+
+    /**
+     * @brief Size of the mapped file in bytes.
+     */
+    std::size_t size() const { return size_; }
+
+    /**
+     * @brief The whole file as a string view over the mapping.
+     */
+    std::string_view view() const { return std::string_view(data_, size_); }
+
+private:
+    void release();
+
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool open_ = false;
+};
+
+} // namespace corpus
+
+#endif // MAPPED_FILE_H
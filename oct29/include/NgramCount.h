@@ -0,0 +1,244 @@
+#ifndef NGRAM_COUNT_H
+#define NGRAM_COUNT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Counting.h"
+#include "Options.h"
+#include "TokenStream.h"
+#include "WordCounter.h"
+#include "WordIds.h"
+
+namespace corpus {
+
+/**
+ * @brief An n-gram of word IDs packed into 96 bits.
+ *
+ * head holds the first two IDs (first in the high half), tail the third;
+ * bigrams leave tail at 0.
+ */
+struct NgramKey {
+    std::uint64_t head;
+    std::uint32_t tail;
+
+    bool operator==(const NgramKey& other) const { return head == other.head && tail == other.tail; }
+
+    /**
+     * @brief The i-th word ID of the n-gram (0, 1 or 2).
+     */
+    std::uint32_t id(unsigned i) const {
+        return i == 0 ? static_cast<std::uint32_t>(head >> 32) : i == 1 ? static_cast<std::uint32_t>(head) : tail;
+    }
+};
+
+/**
+ * @brief Packs the first order IDs of ids into a key.
+ * @param ids At least order word IDs.
+ * @param order 2 or 3.
+ */
+inline NgramKey packNgram(const std::uint32_t* ids, unsigned order) {
+    return NgramKey{(static_cast<std::uint64_t>(ids[0]) << 32) | ids[1], order > 2 ? ids[2] : 0};
+}
+
+/**
+ * @brief Hashes a packed n-gram, well mixed in the low bits (murmur3 fmix64).
+ */
+inline std::uint64_t hashNgram(NgramKey key) {
+    std::uint64_t h = (key.head ^ (static_cast<std::uint64_t>(key.tail) * 0x9E3779B97F4A7C15ULL)) * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * @brief Flat open-addressing hash table that counts packed n-grams.
+ *
+ * The same layout as WordCounter, but a key is two integers, so a probe
+ * compares 12 bytes in place and no string is ever built or stored.
+ */
+class NgramTable {
+public:
+    /**
+     * @brief Creates an empty table.
+     * @param expected Number of distinct n-grams to size the table for.
+     */
+    explicit NgramTable(std::size_t expected = 1024);
+
+    /**
+     * @brief Adds occurrences of an n-gram whose hash is already known.
+     * @param key The n-gram.
+     * @param hash hashNgram(key).
+     * @param n Number of occurrences to add.
+     */
+    void addHashed(NgramKey key, std::uint64_t hash, std::uint64_t n = 1);
+
+    /**
+     * @brief Adds occurrences of an n-gram.
+     */
+    void add(NgramKey key, std::uint64_t n = 1) { addHashed(key, hashNgram(key), n); }
+
+    /**
+     * @brief Returns how many times an n-gram was counted (0 if never).
+     */
+    std::uint64_t count(NgramKey key) const;
+
+    /**
+     * @brief Starts loading the home slot of a hash into the cache.
+     *
+     * A large table misses the cache on nearly every add; callers that
+     * prefetch a few adds ahead overlap those misses.
+     */
+    void prefetch(std::uint64_t hash) const { __builtin_prefetch(&slots_[hash & mask_]); }
+
+    /**
+     * @brief Number of distinct n-grams.
+     */
+    std::size_t size() const { return size_; }
+
+    /**
+     * @brief Number of n-grams counted, including repeats.
+     */
+    std::uint64_t totalCount() const { return total_; }
+
+    /**
+     * @brief Calls fn(NgramKey key, std::uint64_t count) for every distinct n-gram, in table order.
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const Slot& slot : slots_) {
+            if (slot.count != 0) {
+                fn(NgramKey{slot.head, slot.tail}, slot.count);
+            }
+        }
+    }
+
+    /**
+     * @brief Bytes used by the table.
+     */
+    std::size_t memoryUsage() const { return slots_.capacity() * sizeof(Slot); }
+
+private:
+    struct Slot {
+        std::uint64_t head;
+        std::uint64_t count;  // 0 marks an empty slot
+        std::uint32_t tail;
+        std::uint32_t hash;   // low bits of the hash, to skip most key compares and to rehash
+    };
+
+    void grow();
+
+    std::vector<Slot> slots_;
+    std::size_t mask_ = 0;
+    std::size_t size_ = 0;
+    std::uint64_t total_ = 0;
+};
+
+// Kept in the header so the probe loop inlines into the tokenizer callbacks.
+inline void NgramTable::addHashed(NgramKey key, std::uint64_t hash, std::uint64_t n) {
+    if (n == 0) {
+        return;
+    }
+    total_ += n;
+    std::size_t i = hash & mask_;
+    std::uint32_t tag = static_cast<std::uint32_t>(hash);
+    while (true) {
+        Slot& slot = slots_[i];
+        if (slot.count == 0) {
+            break;
+        }
+        if (slot.hash == tag && slot.head == key.head && slot.tail == key.tail) {
+            slot.count += n;
+            return;
+        }
+        i = (i + 1) & mask_;
+    }
+    slots_[i] = Slot{key.head, n, key.tail, tag};
+    ++size_;
+    if (size_ * 4 > slots_.size() * 3) {
+        grow();
+    }
+}
+
+/**
+ * @brief Counted n-grams together with the dictionary their IDs refer to.
+ */
+struct NgramCounts {
+    unsigned order = 2;  ///< Words per n-gram.
+    WordIds words;       ///< The word of every ID.
+    NgramTable table;    ///< Count of every n-gram seen.
+
+    /**
+     * @brief Spells n-grams out as "word word [word]" entries of a WordCounter.
+     *
+     * Only this step builds strings, once per distinct n-gram kept, so the
+     * result can be ranked, written and plotted like a word table.
+     * @param top When non-zero, only n-grams at least as frequent as the
+     *        top-th are spelled (ties at the cut are all kept, so
+     *        RankIndex::top picks the same ones as a full ranking).
+     */
+    WordCounter spell(std::size_t top = 0) const;
+};
+
+/**
+ * @brief Counts the n-grams of consecutive words of text, serially or on several threads.
+ *
+ * Workers count their chunk with their own dictionary; the n-grams that
+ * straddle chunk boundaries are added from the words at each chunk's
+ * edges, so the result is identical to a serial count. The partial tables
+ * are then translated to one dictionary and merged in hash shards.
+ * @param text The whole text, e.g. the view of a MappedFile.
+ * @param script Which characters make up a word.
+ * @param order Words per n-gram (2 or 3).
+ * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+ * @return The n-gram counts.
+ */
+NgramCounts countNgrams(std::string_view text, Script script, unsigned order, unsigned threads = 1);
+
+/**
+ * @brief Counts the n-grams of a file or stdin, reading it in fixed-size blocks.
+ * @param fileName Path of the file, or "-" for standard input.
+ * @param blockSize Number of bytes read at a time.
+ * @param script Which characters make up a word.
+ * @param order Words per n-gram (2 or 3).
+ * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+ * @param bytesRead If not null, receives the number of bytes read.
+ * @return The n-gram counts.
+ */
+NgramCounts countNgramsStreaming(const std::string& fileName, std::size_t blockSize, Script script, unsigned order,
+                                 unsigned threads = 1, std::uint64_t* bytesRead = nullptr);
+
+/**
+ * @brief Counts the n-grams of a dictionary-encoded token stream.
+ *
+ * Slides over the integer IDs directly, so nothing is tokenized or
+ * interned; the result shares the stream's IDs.
+ * @param tokens The stream.
+ * @param order Words per n-gram (2 or 3).
+ * @return The n-gram counts.
+ */
+NgramCounts countNgrams(const TokenStream& tokens, unsigned order);
+
+/**
+ * @brief Runs the --ngram mode of a tool.
+ *
+ * Prints the number of n-grams and distinct n-grams and writes the table
+ * (or its head with --top) to options.outputFile in options.format, one
+ * "rank freq ngram" row each by default; --plot exports the Zipf plot of
+ * the n-grams as SVG. With --tokens or --save-tokens the n-grams are
+ * counted from the token stream. parseOptions refuses --save-index, --heaps
+ * and --sections here, since there is no word table to save or grow.
+ * @param options Parsed command line.
+ * @param script Which characters make up a word.
+ * @return Exit status for main.
+ */
+int runNgrams(const Options& options, Script script);
+
+} // namespace corpus
+
+#endif // NGRAM_COUNT_H
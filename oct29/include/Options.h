@@ -0,0 +1,79 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "FrequencyWriter.h"
+
+namespace corpus {
+
+/**
+ * @brief How a single book is counted exactly.
+ */
+enum class CountingEngine {
+    Hash,  ///< The flat hash table, in one pass over the text (the default).
+    Sort   ///< Keep every token, radix sort them and count the runs (sortAndCountRuns).
+};
+
+/**
+ * @brief Command-line settings shared by the ZipF, ZipF2 and Arabic tools.
+ *
+ * Usage: tool [--threads N] [--stream] [--block-size BYTES] [--top K] [--normalize]
+ *             [--batch DIR|LIST] [--out-dir DIR] [--split-size BYTES]
+ *             [--approximate] [--distinct-error E] [--frequency-error E]
+ *             [--save-index FILE] [--append-index FILE] [--format FORMAT] [--profile FILE]
+ *             [--plot FILE] [--heaps] [--ngram N] [--save-tokens FILE] [--tokens FILE]
+ *             [--serve SOCKET] [--sections] [--section-marker TEXT] [--engine ENGINE] [input [output]]
+ *
+ * An input of "-" reads standard input and implies --stream. With --batch
+ * the books come from a directory or list file, the only positional
+ * argument is the merged output table, and of the other options only
+ * --threads, --top, --normalize, --out-dir, --split-size and --format apply. With --serve the input is a
+ * frequency index to answer queries about. --engine sort applies to a
+ * mapped book only, and is refused with the modes that need every token as
+ * it is read.
+ */
+struct Options {
+    std::string inputFile;   ///< Book to read (each tool sets its own default).
+    std::string outputFile;  ///< Frequency table to write (each tool sets its own default).
+    unsigned threads = 1;    ///< Counting threads; 1 is the serial path, 0 uses every hardware thread.
+    bool stream = false;     ///< Read fixed-size blocks, on a read-ahead thread, instead of mapping the whole book.
+    std::size_t blockSize = 1 << 20;  ///< Block size in bytes for --stream.
+    std::size_t top = 0;     ///< When non-zero, only the K most frequent words are ranked and written.
+    bool normalize = false;  ///< Arabic only: drop diacritics and tatweel and fold alef variants before counting.
+    std::string batch;       ///< Directory or list file of books to count together (empty for a single book).
+    std::string outputDir = ".";      ///< Where --batch writes the per-book tables.
+    std::size_t splitSize = 8 << 20;  ///< --batch counts books larger than this in several pieces.
+    bool approximate = false;         ///< Estimate with fixed-memory sketches instead of counting exactly.
+    double distinctError = 0.01;      ///< --approximate: relative standard error of the unique-word estimate.
+    double frequencyError = 1e-4;     ///< --approximate: overcount bound of a count, as a fraction of all words.
+    std::string saveIndex;            ///< Also write the counts as a binary frequency index to this file.
+    std::string appendIndex;          ///< Only fold the counts of the input into this index (created if missing).
+    OutputFormat format = OutputFormat::Text;  ///< Layout of the written frequency tables.
+    std::string profile;              ///< Write a JSON report of the run's milestones to this file.
+    std::string plotFile;             ///< Export the log-binned plot and fits here instead of showing a window.
+    bool heaps = false;               ///< Record the vocabulary growth curve, fit Heaps' law and write both next to the table.
+    unsigned ngram = 1;               ///< Count sequences of this many words (2 or 3) instead of single words.
+    std::string saveTokens;           ///< Also write the dictionary-encoded token stream of the input to this file.
+    std::string tokens;               ///< Read this saved token stream instead of tokenizing the input.
+    std::string serve;                ///< Answer rank/frequency queries about the input index on this Unix socket.
+    bool sections = false;            ///< Count every section of the input as well as the whole text.
+    std::vector<std::string> sectionMarkers;  ///< Words that open a section header (each tool sets its default).
+    CountingEngine engine = CountingEngine::Hash;  ///< How a single mapped book is counted.
+};
+
+/**
+ * @brief Parses the command line into options.
+ *
+ * Fields that are not given on the command line keep the values already in options.
+ * @param argc Argument count from main.
+ * @param argv Arguments from main.
+ * @param options Receives the parsed settings.
+ * @return false (after printing the usage) if the command line is invalid.
+ */
+bool parseOptions(int argc, char* argv[], Options& options);
+
+} // namespace corpus
+
+#endif // OPTIONS_H
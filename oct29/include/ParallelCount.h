@@ -0,0 +1,92 @@
+#ifndef PARALLEL_COUNT_H
+#define PARALLEL_COUNT_H
+
+#include <cstddef>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "WordCounter.h"
+
+namespace corpus {
+
+/**
+ * @brief Predicate telling whether a byte may belong to a word.
+ */
+using WordBytePredicate = bool (*)(char);
+
+/**
+ * @brief Resolves a requested thread count (0 means one per hardware thread).
+ */
+unsigned resolveThreads(unsigned requested);
+
+/**
+ * @brief Splits text into roughly equal chunks without cutting a word in two.
+ *
+ * Each cut is moved forward to the next byte that cannot be part of a word,
+ * so tokenizing the chunks separately finds exactly the words of the whole text.
+ * @param text The text to split.
+ * @param parts Number of chunks wanted (never more, fewer for short texts).
+ * @param isWordByte Tells which bytes may belong to a word.
+ * @return Views over consecutive pieces of the text.
+ */
+std::vector<std::string_view> splitAtWordBoundaries(std::string_view text, std::size_t parts, WordBytePredicate isWordByte);
+
+/**
+ * @brief Merges per-chunk counters into one, in parallel.
+ *
+ * Each partial is split into hash shards in one pass, the partials in
+ * parallel; each shard is then merged by its own thread from its part of
+ * every partial, and the disjoint shards are joined by
+ * WordCounter::concatenate, which moves slots without comparing words.
+ * @param partials Counters filled by the workers.
+ * @param threads Number of merge threads (and shards).
+ * @return Counter holding the sum of all partials.
+ */
+WordCounter mergeSharded(const std::vector<WordCounter>& partials, unsigned threads);
+
+/**
+ * @brief Runs fn(i, chunks[i]) for every chunk, each on its own thread, and waits for all of them.
+ */
+template <typename Fn>
+void runOnChunks(const std::vector<std::string_view>& chunks, Fn&& fn) {
+    std::vector<std::thread> workers;
+    workers.reserve(chunks.size());
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        workers.emplace_back([&, i] { fn(i, chunks[i]); });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Counts the words of text on several threads.
+ *
+ * The text is split at word boundaries, each chunk is counted by its own
+ * worker into a thread-local WordCounter, and the results are merged by
+ * mergeSharded. The counts are identical to counting the text serially.
+ * @param text The text to count.
+ * @param threads Number of workers (0 means one per hardware thread).
+ * @param isWordByte Tells which bytes may belong to a word.
+ * @param countChunk Callable (std::string_view chunk, WordCounter& counter) that counts one chunk.
+ * @return Counter holding every word of the text.
+ */
+template <typename CountChunk>
+WordCounter countInParallel(std::string_view text, unsigned threads, WordBytePredicate isWordByte, CountChunk countChunk) {
+    threads = resolveThreads(threads);
+    std::vector<std::string_view> chunks = splitAtWordBoundaries(text, threads, isWordByte);
+    if (chunks.size() <= 1) {
+        WordCounter counter;
+        countChunk(text, counter);
+        return counter;
+    }
+
+    std::vector<WordCounter> partials(chunks.size());
+    runOnChunks(chunks, [&](std::size_t i, std::string_view chunk) { countChunk(chunk, partials[i]); });
+
+    return mergeSharded(partials, threads);
+}
+
+} // namespace corpus
+
+#endif // PARALLEL_COUNT_H
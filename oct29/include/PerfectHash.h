@@ -0,0 +1,86 @@
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace corpus {
+
+/**
+ * @brief Minimal perfect hash over a fixed set of 64-bit key hashes.
+ *
+ * Maps the n keys it was built from to distinct slots 0..n-1 in about 3.7
+ * bits per key, with no keys stored (the BBHash scheme). Level 0 is a bit
+ * array twice the size of the key set: every key hashes to a bit, and keys
+ * that land alone keep it. The colliding keys go on to a smaller level,
+ * until none are left. A key's slot is the number of kept bits before its
+ * own, read from one rank sample per 512 bits plus a few popcounts, so a
+ * lookup touches a couple of cache lines.
+ *
+ * A key outside the set maps to some slot or to none; callers check the
+ * key stored at the slot. The whole structure is one array of 64-bit
+ * words, so it is saved as is and used in place from a mapping.
+ */
+class PerfectHash {
+public:
+    /// Returned by find for a hash that reaches no kept bit.
+    static constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+    PerfectHash() = default;
+
+    /**
+     * @brief Builds the hash of a set of keys.
+     * @param hashes One well-mixed 64-bit hash per key, all distinct.
+     * @param hash Receives the built function.
+     * @return false (after printing an error) if two keys share a hash.
+     */
+    static bool build(std::vector<std::uint64_t> hashes, PerfectHash& hash);
+
+    /**
+     * @brief Uses a serialized hash in place, e.g. from a mapped file.
+     * @param words The serialized form, as written by data().
+     * @param size Number of 64-bit words available at words.
+     * @return false if the words are not a consistent serialized hash.
+     */
+    bool attach(const std::uint64_t* words, std::size_t size);
+
+    /**
+     * @brief The serialized form: key count, level count, level starts, bits and rank samples.
+     */
+    const std::uint64_t* data() const { return words_; }
+
+    /**
+     * @brief Length of the serialized form in 64-bit words.
+     */
+    std::size_t serializedSize() const { return serializedSize_; }
+
+    /**
+     * @brief Number of keys.
+     */
+    std::size_t size() const { return keys_; }
+
+    /**
+     * @brief The slot of a key in [0, size()), or none.
+     */
+    std::size_t find(std::uint64_t hash) const;
+
+    /**
+     * @brief Bits per key of the serialized form.
+     */
+    double bitsPerKey() const { return keys_ == 0 ? 0.0 : 64.0 * static_cast<double>(serializedSize_) / keys_; }
+
+private:
+    std::vector<std::uint64_t> owned_;  // serialized form of a hash built here
+    const std::uint64_t* words_ = nullptr;
+    std::size_t serializedSize_ = 0;
+    std::size_t keys_ = 0;
+    std::size_t levels_ = 0;
+    const std::uint64_t* levelStarts_ = nullptr;  // levels_ + 1 offsets into bits_, in 64-bit words
+    const std::uint64_t* bits_ = nullptr;
+    const std::uint64_t* ranks_ = nullptr;  // kept bits before every 512-bit block
+};
+
+} // namespace corpus
+
+#endif // PERFECT_HASH_H
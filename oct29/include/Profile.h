@@ -0,0 +1,130 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "WordCounter.h"
+
+namespace corpus {
+
+/**
+ * @brief Starts counting calls to the global operator new.
+ *
+ * Only programs built with AllocationHook.cpp (the tools and the benchmark)
+ * replace operator new; they call this when the count is reported, e.g.
+ * with --profile. Until then an allocation costs one relaxed load more.
+ */
+void countAllocations();
+
+/**
+ * @brief Counts one allocation if countAllocations was called; used by the hook.
+ */
+void noteAllocation();
+
+/**
+ * @brief Number of operator new calls counted since countAllocations.
+ *
+ * Always 0 in a program without the allocation hook.
+ */
+std::uint64_t allocationCount();
+
+/**
+ * @brief Peak resident set size of the process so far, in kB.
+ */
+std::uint64_t peakMemoryKb();
+
+/**
+ * @brief Measurements of one milestone of a run.
+ */
+struct StageProfile {
+    std::string name;
+    double wallMs = 0;              ///< Elapsed time.
+    double cpuMs = 0;               ///< User and system time of every thread.
+    std::uint64_t bytes = 0;        ///< Input bytes handled by the stage, if any.
+    std::uint64_t tokens = 0;       ///< Tokens handled by the stage, if any.
+    std::uint64_t allocations = 0;  ///< operator new calls during the stage.
+    std::uint64_t peakMemoryKb = 0; ///< Peak resident set of the process at the end of the stage.
+};
+
+/**
+ * @brief Times the milestones of a run and writes them as a JSON report.
+ *
+ * A stage costs two clock reads and one getrusage call at each end, so a
+ * tool can keep the profile on all the time and only write it when asked
+ * (--profile). Hash-table probe lengths are measured once, after counting,
+ * by walking the table, not while the words are added.
+ */
+class RunProfile {
+public:
+    /**
+     * @brief Starts the clock of the whole run.
+     * @param tool Name of the tool, written to the report.
+     */
+    explicit RunProfile(std::string tool);
+
+    /**
+     * @brief Records the input and thread count written to the report.
+     */
+    void setInput(const std::string& input, unsigned threads);
+
+    /**
+     * @brief Starts a stage, ending the previous one if it is still open.
+     */
+    void begin(const std::string& stage);
+
+    /**
+     * @brief Ends the open stage, if any.
+     */
+    void end();
+
+    /**
+     * @brief Attributes work to the open (or else the last) stage.
+     */
+    void addWork(std::uint64_t bytes, std::uint64_t tokens);
+
+    /**
+     * @brief Records the size and probe lengths of the counting table.
+     */
+    void setTable(const WordCounter& counter);
+
+    /**
+     * @brief Stages recorded so far, in order.
+     */
+    const std::vector<StageProfile>& stages() const { return stages_; }
+
+    /**
+     * @brief Ends the open stage and writes the report.
+     *
+     * The report holds the totals of the run (wall and CPU time, bytes,
+     * tokens per second, allocations, peak memory), the hash table, and
+     * the same measurements for every stage.
+     * @param fileName Path of the JSON file.
+     * @return false (after printing an error) if the file cannot be written.
+     */
+    bool writeJson(const std::string& fileName);
+
+private:
+    struct Mark {
+        double wallMs;
+        double cpuMs;
+        std::uint64_t allocations;
+    };
+
+    Mark now() const;
+
+    std::string tool_;
+    std::string input_;
+    unsigned threads_ = 1;
+    Mark start_;
+    Mark stageStart_;
+    bool open_ = false;
+    std::vector<StageProfile> stages_;
+    std::size_t vocabulary_ = 0;
+    WordCounter::ProbeStats table_;
+};
+
+} // namespace corpus
+
+#endif // PROFILE_H
@@ -0,0 +1,184 @@
+#ifndef QUERY_SERVER_H
+#define QUERY_SERVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "FrequencyIndex.h"
+#include "MappedFile.h"
+#include "Options.h"
+#include "PerfectHash.h"
+#include "WordCounter.h"
+
+namespace corpus {
+
+/**
+ * @brief Fixed-size header at the start of a rank lookup file (INDEX.mph).
+ *
+ * Layout of the file, all integers in the byte order of the machine that
+ * wrote it (checked through byteOrder):
+ *   header (64 bytes)
+ *   hash:   hashWords uint64, the serialized PerfectHash of the words
+ *   slots:  wordCount pairs of uint32, the index position and rank of the word in each slot
+ *   byRank: wordCount uint32, the index position of each rank, padded to 8 bytes
+ * The counts and words themselves stay in the index, so the file adds
+ * about 12 bytes per word. It is used only with the index whose checksum
+ * it records; any other index, even one with the same number of words and
+ * tokens, gets a new lookup file.
+ */
+struct LookupHeader {
+    char magic[8];              ///< "CORPMPH" followed by a zero byte.
+    std::uint32_t version;        ///< Format version, currently 2.
+    std::uint32_t byteOrder;      ///< 0x01020304 as written by the producer.
+    std::uint64_t wordCount;      ///< Distinct words of the index it was built for.
+    std::uint64_t totalCount;     ///< Tokens of that index.
+    std::uint64_t hashWords;      ///< Size of the hash section in 64-bit words.
+    std::uint64_t indexChecksum;  ///< FrequencyIndex::checksum() of that index.
+    std::uint64_t padding[2];
+};
+
+static_assert(sizeof(LookupHeader) == 64, "the lookup header must stay 64 bytes");
+
+/**
+ * @brief Rank and frequency of any word of a frequency index in constant time.
+ *
+ * A minimal perfect hash sends a word to its slot, which holds the word's
+ * position in the index (to confirm it is the same word) and its rank;
+ * ranks follow RankIndex, by decreasing count and then byte order. The
+ * hash and slots live in a sidecar file next to the index, built the first
+ * time and mapped as is afterwards, so opening costs two mmaps.
+ */
+class RankLookup {
+public:
+    static constexpr std::uint32_t currentVersion = 2;
+
+    /**
+     * @brief The answer to a word query; rank 0 means the word is not in the index.
+     */
+    struct Answer {
+        std::uint64_t rank;
+        std::uint64_t count;
+    };
+
+    RankLookup() = default;
+
+    /**
+     * @brief Maps an index and its lookup file, building the lookup file if it is missing or stale.
+     * @param indexFile Path of a frequency index (--save-index).
+     * @param lookup Receives the lookup.
+     * @return false (after printing an error) if the index or its lookup cannot be used.
+     */
+    static bool open(const std::string& indexFile, RankLookup& lookup);
+
+    /**
+     * @brief Path of the lookup file kept next to an index.
+     */
+    static std::string lookupFileName(const std::string& indexFile) { return indexFile + ".mph"; }
+
+    /**
+     * @brief Number of distinct words.
+     */
+    std::size_t size() const { return index_.size(); }
+
+    /**
+     * @brief Number of tokens, including repeats.
+     */
+    std::uint64_t totalCount() const { return index_.totalCount(); }
+
+    /**
+     * @brief Rank and count of a word, as the tools write it (e.g. lowercase ASCII).
+     */
+    Answer find(std::string_view word) const {
+        std::size_t slot = hash_.find(hashWord(word));
+        if (slot < hash_.size()) {
+            const Slot& entry = slots_[slot];
+            if (entry.position < index_.size() && index_.word(entry.position) == word) {
+                return Answer{entry.rank, index_.countAt(entry.position)};
+            }
+        }
+        return Answer{0, 0};
+    }
+
+    /**
+     * @brief The word of a rank (1 is the most frequent).
+     */
+    std::string_view wordAt(std::size_t rank) const { return index_.word(byRank_[rank - 1]); }
+
+    /**
+     * @brief The count of the word of a rank.
+     */
+    std::uint64_t countAt(std::size_t rank) const { return index_.countAt(byRank_[rank - 1]); }
+
+    /**
+     * @brief The perfect hash, e.g. to report its size.
+     */
+    const PerfectHash& hash() const { return hash_; }
+
+private:
+    struct Slot {
+        std::uint32_t position;
+        std::uint32_t rank;
+    };
+
+    bool attach(const std::string& fileName, std::uint64_t checksum);
+
+    FrequencyIndex index_;
+    MappedFile file_;
+    PerfectHash hash_;
+    const Slot* slots_ = nullptr;
+    const std::uint32_t* byRank_ = nullptr;
+};
+
+/**
+ * @brief Writes the lookup file of an index (replacing any existing one).
+ * @param index The index.
+ * @param checksum index.checksum(), recorded so the file is only used with this index.
+ * @param fileName Path of the lookup file.
+ * @return false (after printing an error) if it cannot be built or written.
+ */
+bool writeRankLookup(const FrequencyIndex& index, std::uint64_t checksum, const std::string& fileName);
+
+/**
+ * @brief Most words a "t K" request is answered with; a larger K gets this many.
+ */
+constexpr std::size_t maxTopRequest = 100000;
+
+/**
+ * @brief Answers every complete request line of a batch.
+ *
+ * The protocol is line based, one request per line, and every reply has a
+ * known number of lines, so clients can pipeline many requests per write:
+ *   "w WORD" -> "RANK COUNT" (0 0 for a word not in the index)
+ *   "t K"    -> "N", then N lines "RANK COUNT WORD" of the K most frequent words
+ *               (N is at most maxTopRequest)
+ *   "s"      -> "WORDS TOKENS"
+ * A "t" whose K is not a whole number gets "error invalid count", and
+ * anything else gets the line "error unknown request".
+ * @param lookup The table to query.
+ * @param requests Received bytes; a trailing incomplete line is left alone.
+ * @param replies Receives the replies, appended.
+ * @param answered If not null, incremented per request answered.
+ * @param maxReplies Stop before the next request once replies holds this many bytes.
+ * @return Number of bytes of requests consumed.
+ */
+std::size_t answerRequests(const RankLookup& lookup, std::string_view requests, std::string& replies,
+                           std::uint64_t* answered = nullptr, std::size_t maxReplies = SIZE_MAX);
+
+/**
+ * @brief Runs the --serve mode of a tool.
+ *
+ * Maps the index named as input with its lookup file and answers requests
+ * on the Unix domain socket options.serve until SIGINT or SIGTERM. One
+ * thread serves every client with poll(); each read is answered as a batch
+ * with a single write. A client whose unsent replies pass a few megabytes
+ * is neither answered nor read from until it takes them, so pipelining
+ * cannot grow the server's memory without bound.
+ * @param options Parsed command line.
+ * @return Exit status for main.
+ */
+int runQueryServer(const Options& options);
+
+} // namespace corpus
+
+#endif // QUERY_SERVER_H
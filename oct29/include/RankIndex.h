@@ -0,0 +1,77 @@
+#ifndef RANK_INDEX_H
+#define RANK_INDEX_H
+
+#include <cstddef>
+#include <vector>
+#include "WordCounter.h"
+
+namespace corpus {
+
+/**
+ * @brief Ranks every word of a counter, from most to least frequent.
+ *
+ * Counts are small bounded integers, so words are placed with a counting
+ * sort over their frequency (the few very large counts are sorted
+ * directly). Words with the same count are then put in byte order inside
+ * their bucket, so the ranking does not depend on the table layout.
+ * @param counter The counter to rank.
+ * @return Entries by decreasing count, then increasing word; views point into the counter.
+ */
+std::vector<WordCounter::Entry> rankByFrequency(const WordCounter& counter);
+
+/**
+ * @brief The k most frequent words, without ranking the rest.
+ *
+ * One pass over the table keeps a bounded heap of the best k entries, so
+ * the long tail is only compared against the current k-th entry.
+ * @param counter The counter to query.
+ * @param k Number of words wanted.
+ * @return At most k entries, in the same order as rankByFrequency.
+ */
+std::vector<WordCounter::Entry> topK(const WordCounter& counter, std::size_t k);
+
+/**
+ * @brief Words of a counter in rank order (rank 1 is index 0).
+ *
+ * Holds one small entry per word pointing into the counter, instead of a
+ * second copy of every word; the counter must outlive the index.
+ */
+class RankIndex {
+public:
+    RankIndex() = default;
+
+    /**
+     * @brief Ranks every word of the counter.
+     */
+    explicit RankIndex(const WordCounter& counter) : ranked_(rankByFrequency(counter)) {}
+
+    /**
+     * @brief Ranks only the k most frequent words of the counter.
+     */
+    static RankIndex top(const WordCounter& counter, std::size_t k);
+
+    /**
+     * @brief Number of ranked words.
+     */
+    std::size_t size() const { return ranked_.size(); }
+
+    /**
+     * @brief The word at a zero-based position (its rank is index + 1).
+     */
+    const WordCounter::Entry& operator[](std::size_t index) const { return ranked_[index]; }
+
+    /**
+     * @brief The first k ranked words.
+     */
+    std::vector<WordCounter::Entry> topK(std::size_t k) const;
+
+    std::vector<WordCounter::Entry>::const_iterator begin() const { return ranked_.begin(); }
+    std::vector<WordCounter::Entry>::const_iterator end() const { return ranked_.end(); }
+
+private:
+    std::vector<WordCounter::Entry> ranked_;
+};
+
+} // namespace corpus
+
+#endif // RANK_INDEX_H
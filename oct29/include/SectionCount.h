@@ -0,0 +1,181 @@
+#ifndef SECTION_COUNT_H
+#define SECTION_COUNT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Counting.h"
+#include "Options.h"
+#include "WordCounter.h"
+
+namespace corpus {
+
+/**
+ * @brief One section of a text: its header and the bytes from the header to the next one.
+ */
+struct Section {
+    std::string title;       ///< The header line, from the marker to the end of the line (empty for the preamble).
+    std::string_view text;   ///< The section, header included, as a view into the whole text.
+};
+
+/**
+ * @brief How section headers are recognized.
+ */
+struct SectionSettings {
+    std::vector<std::string> markers;  ///< Words that open a header, e.g. "سورة" or "CHAPTER".
+    std::size_t maxTitleWords = 3;     ///< Words a header may have after its marker when it ends a line.
+};
+
+/**
+ * @brief Splits text into sections at header markers.
+ *
+ * A marker counts only as a whole word, and only as a header when it
+ * starts a line, or when the rest of its line is a short title (1 to
+ * maxTitleWords words) so that a header run onto the end of the previous
+ * line is still found; the marker in running text is left alone. Text
+ * before the first header becomes an untitled preamble section if it holds
+ * any word. Every cut falls before a word, so counting the sections
+ * separately finds exactly the words of the whole text.
+ * @param text The whole text.
+ * @param script Which characters make up a word.
+ * @param settings Markers and title length.
+ * @return Sections in text order; the whole text as one section if no header is found.
+ */
+std::vector<Section> splitSections(std::string_view text, Script script, const SectionSettings& settings);
+
+/**
+ * @brief Word counts of every section, as a compressed sparse row matrix.
+ *
+ * Rows are sections and columns are the words of the global table, by
+ * their id there (WordCounter::WordRef::id, found with
+ * WordCounter::find), so the matrix keeps no copy of the vocabulary. Only
+ * the non-zero counts are stored: row r holds its word IDs in increasing
+ * order in ids_[offsets_[r] .. offsets_[r + 1]), with the counts beside
+ * them. A cell is 32 bits, as one section of a book never holds 2^32
+ * tokens; the sections' token totals stay 64-bit. A count is a binary
+ * search within one row; the text is never read again.
+ */
+class SectionMatrix {
+public:
+    SectionMatrix() = default;
+
+    /**
+     * @brief Builds the matrix from per-section counters.
+     * @param sections One counter per section, each with fewer than 2^32 tokens.
+     * @param global The merged counts of all sections, whose ids name the columns.
+     * @param threads Worker threads for building the rows (0 uses every hardware thread).
+     */
+    SectionMatrix(const std::vector<WordCounter>& sections, const WordCounter& global, unsigned threads);
+
+    /**
+     * @brief Number of sections (rows).
+     */
+    std::size_t sections() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+
+    /**
+     * @brief Number of distinct words of the whole text (columns).
+     */
+    std::size_t words() const { return columns_; }
+
+    /**
+     * @brief Number of stored (section, word) counts.
+     */
+    std::size_t nonZeros() const { return ids_.size(); }
+
+    /**
+     * @brief How many times the word with a global id occurs in a section (0 if never).
+     */
+    std::uint32_t count(std::size_t section, std::uint32_t id) const;
+
+    /**
+     * @brief Number of tokens in a section.
+     */
+    std::uint64_t sectionTokens(std::size_t section) const { return tokens_[section]; }
+
+    /**
+     * @brief Number of distinct words in a section.
+     */
+    std::size_t sectionWords(std::size_t section) const { return offsets_[section + 1] - offsets_[section]; }
+
+    /**
+     * @brief Calls fn(std::uint32_t id, std::uint32_t count) for every word of a section, by increasing ID.
+     */
+    template <typename Fn>
+    void forEachInSection(std::size_t section, Fn&& fn) const {
+        for (std::size_t i = offsets_[section]; i < offsets_[section + 1]; ++i) {
+            fn(ids_[i], counts_[i]);
+        }
+    }
+
+    /**
+     * @brief A section holding a word, and how often.
+     */
+    struct Occurrence {
+        std::size_t section;
+        std::uint32_t count;
+    };
+
+    /**
+     * @brief Every section the word with a global id occurs in, in section order.
+     */
+    std::vector<Occurrence> sectionsOf(std::uint32_t id) const;
+
+    /**
+     * @brief Bytes used by the rows and the counts.
+     */
+    std::size_t memoryUsage() const;
+
+private:
+    std::size_t columns_ = 0;               // words of the global table
+    std::vector<std::size_t> offsets_;      // start of each row in ids_, plus the end
+    std::vector<std::uint32_t> ids_;        // global word ids, increasing within a row
+    std::vector<std::uint32_t> counts_;     // count beside each ID
+    std::vector<std::uint64_t> tokens_;     // tokens of each row
+};
+
+/**
+ * @brief The result of counting a text section by section.
+ */
+struct SectionCounts {
+    std::vector<Section> sections;  ///< The sections, in text order (their views point into the text).
+    WordCounter global;             ///< Counts of the whole text.
+    SectionMatrix matrix;           ///< Counts of every section.
+};
+
+/**
+ * @brief Splits text into sections and counts them all in one pass.
+ *
+ * Each section is counted by its own task of a WorkStealingPool, largest
+ * first; the per-section counters are merged into the global table by
+ * mergeSharded and then packed into the matrix, so both come from the one
+ * tokenizing pass.
+ * @param text The whole text, e.g. the view of a MappedFile.
+ * @param script Which characters make up a word.
+ * @param settings Markers and title length.
+ * @param threads Worker threads (0 uses every hardware thread).
+ * @return Sections, global table and section matrix.
+ */
+SectionCounts countSections(std::string_view text, Script script, const SectionSettings& settings, unsigned threads);
+
+/**
+ * @brief Runs the --sections mode of a tool.
+ *
+ * Counts options.inputFile section by section with options.sectionMarkers,
+ * writes the global table to options.outputFile in options.format and every
+ * section's table (its K most frequent words with --top) to the sibling
+ * .sections.tsv, one "section, title, rank, frequency, word" row per word,
+ * and prints one line per section; --save-index stores the global table
+ * and --plot exports its Zipf plot as SVG.
+ * The book is mapped, so --stream (or standard input), --tokens,
+ * --save-tokens and --heaps are refused with an error rather than ignored.
+ * @param options Parsed command line.
+ * @param script Which characters make up a word.
+ * @return Exit status for main.
+ */
+int runSections(const Options& options, Script script);
+
+} // namespace corpus
+
+#endif // SECTION_COUNT_H
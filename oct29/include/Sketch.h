@@ -0,0 +1,209 @@
+#ifndef SKETCH_H
+#define SKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace corpus {
+
+/**
+ * @brief HyperLogLog estimate of the number of distinct words.
+ *
+ * Keeps 2^precision one-byte registers, whatever the size of the
+ * vocabulary; the relative standard error is about 1.04 / sqrt(2^precision).
+ * Sketches with the same precision merge exactly, so chunks or threads can
+ * each keep their own and combine them at the end.
+ */
+class HyperLogLog {
+public:
+    /**
+     * @brief Creates an empty sketch.
+     * @param precision Number of index bits, clamped to 4..18.
+     */
+    explicit HyperLogLog(unsigned precision = 14);
+
+    /**
+     * @brief The smallest sketch whose standard error is at most relativeError.
+     */
+    static HyperLogLog forError(double relativeError);
+
+    /**
+     * @brief Adds an item by its 64-bit hash (e.g. hashWord).
+     */
+    void addHash(std::uint64_t hash) {
+        std::size_t index = hash >> (64 - precision_);
+        std::uint64_t rest = hash << precision_;
+        unsigned limit = 64 - precision_ + 1;
+        unsigned rank = rest == 0 ? limit : static_cast<unsigned>(__builtin_clzll(rest)) + 1;
+        if (rank > registers_[index]) {
+            registers_[index] = static_cast<std::uint8_t>(rank);
+        }
+    }
+
+    /**
+     * @brief Adds another sketch to this one.
+     * @return false (after printing an error) if the precisions differ.
+     */
+    bool merge(const HyperLogLog& other);
+
+    /**
+     * @brief Estimated number of distinct items added.
+     */
+    double estimate() const;
+
+    /**
+     * @brief Relative standard error of the estimate.
+     */
+    double standardError() const;
+
+    unsigned precision() const { return precision_; }
+
+    /**
+     * @brief Bytes used by the registers.
+     */
+    std::size_t memoryUsage() const { return registers_.size(); }
+
+private:
+    unsigned precision_;
+    std::vector<std::uint8_t> registers_;
+};
+
+/**
+ * @brief Count-Min sketch of word frequencies.
+ *
+ * depth rows of width counters; an item increments one counter per row and
+ * its estimate is the smallest of them. Estimates never undercount, and
+ * with probability 1 - delta they overcount by at most epsilon times the
+ * number of items added, for width = e / epsilon and depth = ln(1 / delta).
+ * Sketches of the same shape merge by adding their counters.
+ */
+class CountMinSketch {
+public:
+    /**
+     * @brief Creates an empty sketch.
+     * @param width Counters per row, rounded up to a power of two.
+     * @param depth Number of rows.
+     */
+    CountMinSketch(std::size_t width, std::size_t depth);
+
+    /**
+     * @brief The sketch that meets the given error bound.
+     * @param epsilon Overcount bound, as a fraction of the total count.
+     * @param delta Probability that an estimate exceeds the bound.
+     */
+    static CountMinSketch forError(double epsilon, double delta);
+
+    /**
+     * @brief Adds n occurrences of an item by its 64-bit hash.
+     * @return The item's estimate after the update.
+     */
+    std::uint64_t addHash(std::uint64_t hash, std::uint64_t n = 1) {
+        std::uint64_t step = (hash >> 32) | 1;  // double hashing, one probe per row
+        std::uint64_t best = UINT64_MAX;
+        for (std::size_t row = 0; row < depth_; ++row) {
+            std::uint64_t& cell = counters_[row * width_ + ((hash + row * step) & (width_ - 1))];
+            cell += n;
+            best = cell < best ? cell : best;
+        }
+        return best;
+    }
+
+    /**
+     * @brief Estimated count of an item by its 64-bit hash.
+     */
+    std::uint64_t estimateHash(std::uint64_t hash) const;
+
+    /**
+     * @brief Adds another sketch to this one.
+     * @return false (after printing an error) if the shapes differ.
+     */
+    bool merge(const CountMinSketch& other);
+
+    std::size_t width() const { return width_; }
+    std::size_t depth() const { return depth_; }
+
+    /**
+     * @brief Bytes used by the counters.
+     */
+    std::size_t memoryUsage() const { return counters_.size() * sizeof(std::uint64_t); }
+
+private:
+    std::size_t width_;
+    std::size_t depth_;
+    std::vector<std::uint64_t> counters_;
+};
+
+/**
+ * @brief The k most frequent words of a stream, in fixed memory.
+ *
+ * Frequencies come from a Count-Min sketch; a min-heap keeps the k words
+ * with the largest estimates seen so far, so a word only has to be looked
+ * up when its estimate beats the smallest one kept.
+ */
+class HeavyHitters {
+public:
+    /**
+     * @brief A word and its estimated count.
+     */
+    struct Entry {
+        std::string word;
+        std::uint64_t count;
+    };
+
+    /**
+     * @brief Creates an empty tracker.
+     * @param k Number of words to keep.
+     * @param sketch Empty sketch that estimates the frequencies.
+     */
+    HeavyHitters(std::size_t k, CountMinSketch sketch);
+
+    /**
+     * @brief Adds n occurrences of a word whose hash is already known.
+     */
+    void addHashed(std::string_view word, std::uint64_t hash, std::uint64_t n = 1);
+
+    /**
+     * @brief Adds another tracker to this one.
+     *
+     * The sketches are summed and the candidates of both are re-estimated
+     * against the sum, keeping the best k.
+     * @return false if the sketches have different shapes.
+     */
+    bool merge(const HeavyHitters& other);
+
+    /**
+     * @brief The kept words by decreasing estimate, then increasing word.
+     */
+    std::vector<Entry> top() const;
+
+    const CountMinSketch& sketch() const { return sketch_; }
+
+    /**
+     * @brief Bytes used by the sketch and the kept words.
+     */
+    std::size_t memoryUsage() const;
+
+private:
+    struct Candidate {
+        std::string word;
+        std::uint64_t hash;
+        std::uint64_t count;
+    };
+
+    void siftUp(std::size_t i);
+    void siftDown(std::size_t i);
+    void place(std::size_t i);
+
+    std::size_t k_;
+    CountMinSketch sketch_;
+    std::vector<Candidate> heap_;                          // min-heap on count
+    std::unordered_map<std::uint64_t, std::size_t> slot_;  // hash -> position in heap_
+};
+
+} // namespace corpus
+
+#endif // SKETCH_H
@@ -0,0 +1,112 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace corpus {
+
+/**
+ * @brief Bounded lock-free queue between exactly one producer and one consumer thread.
+ *
+ * A ring of slots indexed by two ever-increasing counters: only the
+ * producer writes tail_, only the consumer writes head_, and each reads
+ * the other's with acquire ordering, so a value is fully written before it
+ * can be popped. The counters sit on separate cache lines to keep the two
+ * threads from invalidating each other's line on every operation.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    /**
+     * @brief Creates an empty queue.
+     * @param capacity Maximum number of queued values (rounded up to a power of two).
+     */
+    explicit SpscQueue(std::size_t capacity) {
+        std::size_t size = 1;
+        while (size < capacity) {
+            size *= 2;
+        }
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * @brief Appends a value unless the queue is full. Producer thread only.
+     * @return false if the queue was full.
+     */
+    bool tryPush(const T& value) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest value unless the queue is empty. Consumer thread only.
+     * @return false if the queue was empty.
+     */
+    bool tryPop(T& value) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = slots_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Appends a value, waiting while the queue is full.
+     * @param stop Checked while waiting; once set, gives up.
+     * @return false if stop was set before there was room.
+     */
+    bool push(const T& value, const std::atomic<bool>& stop) {
+        return waitFor([&] { return tryPush(value); }, stop);
+    }
+
+    /**
+     * @brief Removes the oldest value, waiting while the queue is empty.
+     * @param stop Checked while waiting; once set, gives up.
+     * @return false if stop was set before a value arrived.
+     */
+    bool pop(T& value, const std::atomic<bool>& stop) {
+        return waitFor([&] { return tryPop(value); }, stop);
+    }
+
+private:
+    // Spins briefly (the other side is usually a block away), then yields and
+    // finally sleeps, so a thread stalled on the disk costs no CPU.
+    template <typename Try>
+    static bool waitFor(Try attempt, const std::atomic<bool>& stop) {
+        for (unsigned round = 0; !attempt(); ++round) {
+            if (stop.load(std::memory_order_acquire)) {
+                return false;
+            }
+            if (round < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(round < 256 ? 10 : 100));
+            }
+        }
+        return true;
+    }
+
+    std::vector<T> slots_;
+    std::size_t mask_ = 0;
+    alignas(64) std::atomic<std::size_t> head_{0};  // next slot to pop, written by the consumer
+    alignas(64) std::atomic<std::size_t> tail_{0};  // next slot to fill, written by the producer
+};
+
+} // namespace corpus
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,32 @@
+#ifndef STRING_SORT_H
+#define STRING_SORT_H
+
+#include <string_view>
+#include <vector>
+#include "WordCounter.h"
+
+namespace corpus {
+
+/**
+ * @brief Sorts words in byte order and counts the runs of equal words in the same pass.
+ *
+ * An in-place MSD radix sort (American flag sort) distributes the words by
+ * their byte at the current depth. The next 8 bytes of every word are kept
+ * in an array beside the views, so most levels never touch the words
+ * themselves. Buckets under a few thousand words
+ * go to multikey quicksort and the smallest to insertion sort. A group of
+ * words that all end at the current depth is one run and is counted at
+ * once without being sorted further, so the very frequent words of natural
+ * text drop out after a few levels.
+ * Buckets large enough to be worth it are sorted as separate tasks of a
+ * WorkStealingPool.
+ * @param words The words, reordered in place; equal words end up adjacent.
+ *        They must not contain zero bytes, which no tokenizer hands out.
+ * @param threads Worker threads (0 means all hardware threads, 1 sorts on the calling thread).
+ * @return One entry per distinct word, in byte order, viewing words' targets.
+ */
+std::vector<WordCounter::Entry> sortAndCountRuns(std::vector<std::string_view>& words, unsigned threads);
+
+} // namespace corpus
+
+#endif // STRING_SORT_H
@@ -0,0 +1,175 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Counting.h"
+#include "MappedFile.h"
+#include "Options.h"
+#include "VocabularyGrowth.h"
+#include "WordCounter.h"
+#include "WordIds.h"
+
+namespace corpus {
+
+/**
+ * @brief Fixed-size header at the start of a token stream file.
+ *
+ * Layout of the file, all integers in the byte order of the machine that
+ * wrote it (checked through byteOrder):
+ *   header (64 bytes)
+ *   ends:  wordCount uint64, end of each word in the byte section, by ID
+ *   ids:   tokenCount uint32, the ID of every token in text order
+ *   bytes: the words in ID order, concatenated
+ * The ids section is padded to 8 bytes, so the IDs are used in place from
+ * the mapping. Version 1 had 32-bit ends, which wrapped past 4 GiB of words.
+ */
+struct TokenHeader {
+    char magic[8];              ///< "CORPTOK" followed by a zero byte.
+    std::uint32_t version;      ///< Format version, currently 2.
+    std::uint32_t byteOrder;    ///< 0x01020304 as written by the producer.
+    std::uint32_t script;       ///< The Script the text was tokenized with.
+    std::uint32_t reserved;
+    std::uint64_t wordCount;    ///< Number of distinct words.
+    std::uint64_t tokenCount;   ///< Number of tokens.
+    std::uint64_t bytesSize;    ///< Size of the byte section.
+    std::uint64_t sourceBytes;  ///< Size of the tokenized text.
+    std::uint64_t padding;
+};
+
+static_assert(sizeof(TokenHeader) == 64, "the token stream header must stay 64 bytes");
+
+/**
+ * @brief A tokenized text, dictionary-encoded: the vocabulary plus one 32-bit ID per token.
+ *
+ * The text is tokenized once; frequencies, n-grams, the vocabulary growth
+ * curve and per-section counts then run over a dense integer array, with
+ * no re-tokenizing and no allocation per token. IDs are given in order of
+ * first appearance, whatever the number of threads, so the stream of a
+ * text is always the same. A saved stream is mapped back and its IDs used
+ * in place.
+ */
+class TokenStream {
+public:
+    static constexpr std::uint32_t currentVersion = 2;
+
+    TokenStream() = default;
+
+    TokenStream(const TokenStream&) = delete;
+    TokenStream& operator=(const TokenStream&) = delete;
+    TokenStream(TokenStream&&) = default;
+    TokenStream& operator=(TokenStream&&) = default;
+
+    /**
+     * @brief Tokenizes and encodes text, serially or on several threads.
+     *
+     * Each worker encodes its chunk with its own dictionary; the
+     * dictionaries are then joined in chunk order and the chunks
+     * translated in parallel, which gives the serial IDs.
+     * @param text The whole text, e.g. the view of a MappedFile.
+     * @param script Which characters make up a word.
+     * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+     */
+    static TokenStream fromText(std::string_view text, Script script, unsigned threads = 1);
+
+    /**
+     * @brief Tokenizes and encodes a file or stdin, reading it in fixed-size blocks.
+     * @param fileName Path of the file, or "-" for standard input.
+     * @param blockSize Number of bytes read at a time.
+     * @param script Which characters make up a word.
+     * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+     */
+    static TokenStream fromStream(const std::string& fileName, std::size_t blockSize, Script script,
+                                  unsigned threads = 1);
+
+    /**
+     * @brief Maps a saved stream; the token IDs are not copied.
+     * @param fileName Path of the stream file.
+     * @param stream Receives the stream.
+     * @return false (after printing an error) if the file is missing or not a valid stream.
+     */
+    static bool load(const std::string& fileName, TokenStream& stream);
+
+    /**
+     * @brief Writes the stream to a file (replacing any existing one).
+     * @return false (after printing an error) if the file cannot be written.
+     */
+    bool save(const std::string& fileName) const;
+
+    /**
+     * @brief The script the text was tokenized with.
+     */
+    Script script() const { return script_; }
+
+    /**
+     * @brief The dictionary: word(id) for every ID of the stream.
+     */
+    const WordIds& vocabulary() const { return words_; }
+
+    /**
+     * @brief Number of tokens.
+     */
+    std::size_t size() const { return size_; }
+
+    /**
+     * @brief The token IDs, in text order.
+     */
+    const std::uint32_t* data() const { return ids_; }
+    const std::uint32_t* begin() const { return ids_; }
+    const std::uint32_t* end() const { return ids_ + size_; }
+    std::uint32_t operator[](std::size_t i) const { return ids_[i]; }
+
+    /**
+     * @brief Number of bytes of text that were tokenized.
+     */
+    std::uint64_t bytesProcessed() const { return bytes_; }
+
+    /**
+     * @brief The count of every word, indexed by ID.
+     */
+    std::vector<std::uint64_t> frequencies() const;
+
+    /**
+     * @brief The counts as a WordCounter, for the ranking and statistics stages.
+     */
+    WordCounter toCounter() const;
+
+    /**
+     * @brief Records the exact vocabulary growth curve.
+     *
+     * IDs are handed out in order of first appearance, so a token is a new
+     * word exactly when its ID is the next unused one.
+     */
+    void recordGrowth(VocabularyGrowth& growth) const;
+
+private:
+    void adopt(std::vector<std::uint32_t> ids);
+
+    Script script_ = Script::Ascii;
+    WordIds words_;
+    std::vector<std::uint32_t> owned_;
+    MappedFile file_;
+    const std::uint32_t* ids_ = nullptr;
+    std::size_t size_ = 0;
+    std::uint64_t bytes_ = 0;
+};
+
+/**
+ * @brief The token stream of a tool's input.
+ *
+ * Loaded from options.tokens when given (its script must match); otherwise
+ * options.inputFile is tokenized, mapped or streamed as the options say,
+ * and saved to options.saveTokens when given.
+ * @param options Parsed command line.
+ * @param script Which characters make up a word.
+ * @param stream Receives the stream.
+ * @return false (after printing an error) if the stream cannot be loaded or saved.
+ */
+bool readTokens(const Options& options, Script script, TokenStream& stream);
+
+} // namespace corpus
+
+#endif // TOKEN_STREAM_H
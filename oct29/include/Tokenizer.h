@@ -0,0 +1,367 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace corpus {
+
+/**
+ * @brief Checks if a byte is an ASCII letter (A-Z or a-z).
+ *
+ * Unlike std::isalpha this does not consult the locale, so it inlines
+ * into the tokenizer loops.
+ */
+inline bool isAsciiLetter(char c) {
+    return static_cast<unsigned char>((c | 0x20) - 'a') < 26;
+}
+
+/**
+ * @brief Lowercases an ASCII letter, any other byte is returned unchanged.
+ */
+inline char toLowerAscii(char c) {
+    return static_cast<unsigned char>(c - 'A') < 26 ? static_cast<char>(c | 0x20) : c;
+}
+
+/**
+ * @brief Writes the lowercase form of a word into a reusable buffer.
+ * @param word Word made of ASCII letters.
+ * @param out Buffer that receives the folded word; its capacity is reused between calls.
+ */
+inline void foldAsciiWord(std::string_view word, std::string& out) {
+    out.resize(word.size());
+    for (std::size_t i = 0; i < word.size(); ++i) {
+        out[i] = toLowerAscii(word[i]);
+    }
+}
+
+/**
+ * @brief Calls onWord for every maximal run of ASCII letters in the text.
+ *
+ * The words are views into the text itself (not lowercased), so nothing is
+ * copied while scanning a mapped book.
+ * @param text The raw book content.
+ * @param onWord Callable taking a std::string_view.
+ */
+template <typename OnWord>
+void forEachAsciiWord(std::string_view text, OnWord&& onWord) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p != end) {
+        while (p != end && !isAsciiLetter(*p)) {
+            ++p;
+        }
+        const char* start = p;
+        while (p != end && isAsciiLetter(*p)) {
+            ++p;
+        }
+        if (p != start) {
+            onWord(std::string_view(start, static_cast<std::size_t>(p - start)));
+        }
+    }
+}
+
+/**
+ * @brief A block kernel that lowercases ASCII letters and marks where they are.
+ *
+ * fold(in, n, folded, letterMasks) copies n bytes to folded with A-Z turned
+ * into a-z, and sets bit (i % 64) of letterMasks[i / 64] when byte i is a
+ * letter. letterMasks must hold (n + 63) / 64 words.
+ */
+struct AsciiFoldKernel {
+    const char* name;
+    void (*fold)(const char* in, std::size_t n, char* folded, std::uint64_t* letterMasks);
+};
+
+/**
+ * @brief The fastest kernel this CPU supports (AVX2, SSE2 or scalar), picked once at runtime.
+ */
+const AsciiFoldKernel& bestAsciiFoldKernel();
+
+/**
+ * @brief Every kernel this CPU can run, scalar first; used to compare them.
+ */
+std::vector<AsciiFoldKernel> supportedAsciiFoldKernels();
+
+/**
+ * @brief Number of bytes the tokenizers classify at a time.
+ */
+constexpr std::size_t scanBlockSize = 4096;
+
+namespace detail {
+
+// Position of the first set bit (a word byte) at or after pos, or n if there is none.
+inline std::size_t nextSetBit(const std::uint64_t* masks, std::size_t pos, std::size_t n) {
+    std::size_t words = (n + 63) / 64;
+    std::size_t i = pos / 64;
+    if (i >= words) {
+        return n;
+    }
+    std::uint64_t m = masks[i] & (~0ULL << (pos % 64));
+    while (m == 0) {
+        if (++i == words) {
+            return n;
+        }
+        m = masks[i];
+    }
+    return std::min(n, i * 64 + static_cast<std::size_t>(__builtin_ctzll(m)));
+}
+
+// Position of the first clear bit (a separator) at or after pos, or n if there is none.
+inline std::size_t nextClearBit(const std::uint64_t* masks, std::size_t pos, std::size_t n) {
+    std::size_t words = (n + 63) / 64;
+    std::size_t i = pos / 64;
+    if (i >= words) {
+        return n;
+    }
+    std::uint64_t m = ~masks[i] & (~0ULL << (pos % 64));
+    while (m == 0) {
+        if (++i == words) {
+            return n;
+        }
+        m = ~masks[i];
+    }
+    return std::min(n, i * 64 + static_cast<std::size_t>(__builtin_ctzll(m)));
+}
+
+} // namespace detail
+
+/**
+ * @brief Calls onWord for every maximal run of ASCII letters, already lowercased.
+ *
+ * The text is folded block by block with a vectorized kernel, and word
+ * boundaries are read from the letter bitmasks, so the counter receives
+ * lowercase words without any per-byte branching. The views passed to
+ * onWord are only valid during the call.
+ * @param text The raw book content.
+ * @param onWord Callable taking a std::string_view of a lowercase word.
+ * @param kernel Folding kernel to use.
+ */
+template <typename OnWord>
+void forEachFoldedAsciiWord(std::string_view text, OnWord&& onWord,
+                            const AsciiFoldKernel& kernel = bestAsciiFoldKernel()) {
+    char folded[scanBlockSize];
+    std::uint64_t masks[scanBlockSize / 64];
+    std::string carry;  // start of a word that runs past the end of a block
+
+    for (std::size_t base = 0; base < text.size(); base += scanBlockSize) {
+        std::size_t n = std::min(scanBlockSize, text.size() - base);
+        bool lastBlock = base + n == text.size();
+        kernel.fold(text.data() + base, n, folded, masks);
+
+        std::size_t pos = 0;
+        if (!carry.empty()) {
+            std::size_t end = detail::nextClearBit(masks, 0, n);
+            carry.append(folded, end);
+            if (end == n) {
+                continue;
+            }
+            onWord(std::string_view(carry));
+            carry.clear();
+            pos = end;
+        }
+
+        while (true) {
+            std::size_t start = detail::nextSetBit(masks, pos, n);
+            if (start == n) {
+                break;
+            }
+            std::size_t end = detail::nextClearBit(masks, start, n);
+            if (end == n && !lastBlock) {
+                carry.assign(folded + start, end - start);
+                break;
+            }
+            onWord(std::string_view(folded + start, end - start));
+            pos = end;
+        }
+    }
+    if (!carry.empty()) {
+        onWord(std::string_view(carry));
+    }
+}
+
+namespace detail {
+
+// One entry per Latin-1 byte: its lowercase form when it is a letter, 0 when
+// it separates words. Built at compile time.
+constexpr std::array<unsigned char, 256> makeLatin1FoldTable() {
+    std::array<unsigned char, 256> table{};
+    for (unsigned c = 'a'; c <= 'z'; ++c) {
+        table[c] = static_cast<unsigned char>(c);
+        table[c - 0x20] = static_cast<unsigned char>(c);
+    }
+    // feminine and masculine ordinals and micro sign have no uppercase form
+    for (unsigned c : {0xAA, 0xB5, 0xBA, 0xDF, 0xFF}) {
+        table[c] = static_cast<unsigned char>(c);
+    }
+    // accented capitals U+00C0..U+00DE sit 0x20 below their small letters;
+    // the multiplication and division signs are not letters
+    for (unsigned c = 0xC0; c <= 0xDE; ++c) {
+        if (c != 0xD7) {
+            table[c] = static_cast<unsigned char>(c + 0x20);
+            table[c + 0x20] = static_cast<unsigned char>(c + 0x20);
+        }
+    }
+    return table;
+}
+
+inline constexpr std::array<unsigned char, 256> latin1FoldTable = makeLatin1FoldTable();
+
+} // namespace detail
+
+/**
+ * @brief Checks if a Latin-1 byte is a letter (ASCII or accented).
+ */
+inline bool isLatin1Letter(char c) {
+    return detail::latin1FoldTable[static_cast<unsigned char>(c)] != 0;
+}
+
+/**
+ * @brief Calls onWord for every maximal run of Latin-1 letters, already lowercased.
+ *
+ * One table lookup per byte both classifies and folds it, so accented
+ * capitals are lowercased without the locale. The views passed to onWord
+ * are Latin-1 bytes and only valid during the call.
+ * @param text Latin-1 encoded text.
+ * @param onWord Callable taking a std::string_view of a lowercase word.
+ */
+template <typename OnWord>
+void forEachFoldedLatin1Word(std::string_view text, OnWord&& onWord) {
+    std::string word;
+    for (char c : text) {
+        unsigned char folded = detail::latin1FoldTable[static_cast<unsigned char>(c)];
+        if (folded != 0) {
+            word.push_back(static_cast<char>(folded));
+        } else if (!word.empty()) {
+            onWord(std::string_view(word));
+            word.clear();
+        }
+    }
+    if (!word.empty()) {
+        onWord(std::string_view(word));
+    }
+}
+
+/**
+ * @brief Tells whether a byte starts a UTF-8 sequence in the Arabic block.
+ *
+ * Every code point in U+0600..U+06FF is encoded on two bytes whose lead
+ * byte is 0xD8..0xDB.
+ */
+inline bool isArabicLeadByte(unsigned char b) {
+    return b >= 0xD8 && b <= 0xDB;
+}
+
+/**
+ * @brief Tells whether a byte is a UTF-8 continuation byte (10xxxxxx).
+ */
+inline bool isContinuationByte(unsigned char b) {
+    return (b & 0xC0) == 0x80;
+}
+
+/**
+ * @brief Tells whether a byte can be part of an Arabic word (a lead or continuation byte).
+ *
+ * Text can be cut anywhere else without splitting an Arabic word.
+ */
+inline bool isArabicWordByte(char c) {
+    unsigned char b = static_cast<unsigned char>(c);
+    return isArabicLeadByte(b) || isContinuationByte(b);
+}
+
+/**
+ * @brief A block kernel that classifies the bytes of UTF-8 text for the Arabic tokenizer.
+ *
+ * classify(in, n, leadMasks, contMasks) sets bit (i % 64) of leadMasks[i / 64]
+ * when byte i is 0xD8..0xDB and of contMasks[i / 64] when it is a
+ * continuation byte. Both arrays must hold (n + 63) / 64 words.
+ */
+struct ArabicClassifyKernel {
+    const char* name;
+    void (*classify)(const char* in, std::size_t n, std::uint64_t* leadMasks, std::uint64_t* contMasks);
+};
+
+/**
+ * @brief The fastest Arabic kernel this CPU supports (AVX2, SSE2 or scalar), picked once at runtime.
+ */
+const ArabicClassifyKernel& bestArabicClassifyKernel();
+
+/**
+ * @brief Every Arabic kernel this CPU can run, scalar first; used to compare them.
+ */
+std::vector<ArabicClassifyKernel> supportedArabicClassifyKernels();
+
+namespace detail {
+
+// Marks the bytes of [in, in + n) that belong to an Arabic-block character
+// (a lead byte followed by a continuation byte). prevIsLead and next describe
+// the bytes just outside the block (next is -1 at the end of the text), so
+// a character cut by the block edge is still recognized. n <= scanBlockSize.
+void arabicWordMasks(const char* in, std::size_t n, bool prevIsLead, int next,
+                     const ArabicClassifyKernel& kernel, std::uint64_t* wordMasks);
+
+} // namespace detail
+
+/**
+ * @brief Calls onWord for every maximal run of Arabic-block characters in UTF-8 text.
+ *
+ * The bytes are classified block by block with a vectorized kernel, and a
+ * character is a lead byte 0xD8..0xDB followed by a continuation byte; every
+ * other byte acts as a separator, as it did for the wide-character reader.
+ * Runs of ASCII are skipped 64 bytes at a time. The words are views into
+ * the text itself, still in UTF-8.
+ * @param text UTF-8 encoded text.
+ * @param onWord Callable taking a std::string_view of UTF-8 bytes.
+ * @param kernel Classification kernel to use.
+ */
+template <typename OnWord>
+void forEachArabicWord(std::string_view text, OnWord&& onWord,
+                       const ArabicClassifyKernel& kernel = bestArabicClassifyKernel()) {
+    std::uint64_t masks[scanBlockSize / 64];
+    const std::size_t none = text.size() + 1;
+    std::size_t openStart = none;  // start of a word that runs past the end of a block
+
+    for (std::size_t base = 0; base < text.size(); base += scanBlockSize) {
+        std::size_t n = std::min(scanBlockSize, text.size() - base);
+        bool prevIsLead = base > 0 && isArabicLeadByte(static_cast<unsigned char>(text[base - 1]));
+        int next = base + n < text.size() ? static_cast<unsigned char>(text[base + n]) : -1;
+        detail::arabicWordMasks(text.data() + base, n, prevIsLead, next, kernel, masks);
+
+        std::size_t pos = 0;
+        if (openStart != none) {
+            std::size_t end = detail::nextClearBit(masks, 0, n);
+            if (end == n) {
+                continue;
+            }
+            onWord(text.substr(openStart, base + end - openStart));
+            openStart = none;
+            pos = end;
+        }
+
+        while (true) {
+            std::size_t start = detail::nextSetBit(masks, pos, n);
+            if (start == n) {
+                break;
+            }
+            std::size_t end = detail::nextClearBit(masks, start, n);
+            if (end == n) {
+                openStart = base + start;
+                break;
+            }
+            onWord(text.substr(base + start, end - start));
+            pos = end;
+        }
+    }
+    if (openStart != none) {
+        onWord(text.substr(openStart));
+    }
+}
+
+} // namespace corpus
+
+#endif // TOKENIZER_H
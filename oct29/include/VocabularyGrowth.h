@@ -0,0 +1,108 @@
+#ifndef VOCABULARY_GROWTH_H
+#define VOCABULARY_GROWTH_H
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace corpus {
+
+/**
+ * @brief Vocabulary size after the first tokens of the text.
+ */
+struct HeapsPoint {
+    std::uint64_t tokens;      ///< n, the number of tokens read.
+    std::uint64_t vocabulary;  ///< V(n), the distinct words among them.
+};
+
+/**
+ * @brief Parameters of a fitted Heaps' law V(n) = K n^beta.
+ */
+struct HeapsFit {
+    double k = 0;
+    double beta = 0;
+    double rSquared = 0;  ///< Of the fit in log-log space.
+
+    double predict(double tokens) const { return k * std::pow(tokens, beta); }
+};
+
+/**
+ * @brief Records Heaps' law, the vocabulary growth curve, during the counting pass.
+ *
+ * The counters report the token position of every word they see for the
+ * first time; the curve keeps V(n) only at checkpoints spaced evenly in
+ * log(n), so it stays a few hundred points long for any corpus. Recording
+ * costs one comparison per new word, not per token.
+ */
+class VocabularyGrowth {
+public:
+    /**
+     * @brief Creates an empty curve.
+     * @param pointsPerDecade Checkpoints per factor of ten in the token count.
+     */
+    explicit VocabularyGrowth(unsigned pointsPerDecade = 20);
+
+    /**
+     * @brief Records a distinct word first seen at a token position.
+     * @param position Zero-based token index; positions must not decrease.
+     */
+    void addWordAt(std::uint64_t position) {
+        while (next_ <= position) {
+            checkpoint();
+        }
+        ++vocabulary_;
+    }
+
+    /**
+     * @brief Closes the curve once the whole text is counted.
+     * @param tokens Number of tokens of the text; the last point is V(tokens).
+     */
+    void finish(std::uint64_t tokens);
+
+    /**
+     * @brief The curve, by increasing token count.
+     */
+    const std::vector<HeapsPoint>& points() const { return points_; }
+
+private:
+    void checkpoint();
+
+    double pointsPerDecade_;
+    unsigned step_ = 0;
+    std::uint64_t next_ = 1;
+    std::uint64_t vocabulary_ = 0;
+    std::vector<HeapsPoint> points_;
+};
+
+/**
+ * @brief Fits Heaps' law by least squares on log V = log K + beta log n.
+ *
+ * The first tokens are nearly all new words (V = n), which is not the
+ * regime the law describes, so only points from minTokens on are fitted
+ * (all of them if fewer than two are that far).
+ * @param points The curve; being log-spaced, each point weighs the same.
+ * @param minTokens Smallest token count fitted.
+ */
+HeapsFit fitHeaps(const std::vector<HeapsPoint>& points, std::uint64_t minTokens = 1000);
+
+/**
+ * @brief Writes the curve and the fitted law as CSV.
+ *
+ * A leading comment line holds K and beta; the columns are tokens,
+ * vocabulary and heaps (the fitted V).
+ * @return false (after printing an error) if the file cannot be written.
+ */
+bool writeHeapsCsv(const std::string& fileName, const std::vector<HeapsPoint>& points, const HeapsFit& fit);
+
+/**
+ * @brief Fits the curve, prints the fit and writes both next to the frequency table.
+ * @param growth The recorded curve.
+ * @param tableFile The frequency table; the curve goes to the same name with a .heaps.csv extension.
+ * @return false (after printing an error) if the file cannot be written.
+ */
+bool exportHeapsCurve(const VocabularyGrowth& growth, const std::string& tableFile);
+
+} // namespace corpus
+
+#endif // VOCABULARY_GROWTH_H
@@ -0,0 +1,304 @@
+#ifndef WORD_COUNTER_H
+#define WORD_COUNTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace corpus {
+
+/**
+ * @brief Hashes a word, reading it eight bytes at a time.
+ *
+ * The result is well mixed in its low bits, so it can index a power-of-two
+ * table directly.
+ * @param word The word to hash.
+ * @return 64-bit hash of the word.
+ */
+inline std::uint64_t hashWord(std::string_view word) {
+    const std::uint64_t k = 0x9E3779B97F4A7C15ULL;
+    std::uint64_t h = word.size() * k;
+    const char* p = word.data();
+    std::size_t n = word.size();
+    while (n >= 8) {
+        std::uint64_t chunk;
+        std::memcpy(&chunk, p, 8);
+        h = (h ^ chunk) * k;
+        h ^= h >> 29;
+        p += 8;
+        n -= 8;
+    }
+    if (n > 0) {
+        std::uint64_t chunk = 0;
+        std::memcpy(&chunk, p, n);
+        h = (h ^ chunk) * k;
+    }
+    // final avalanche (murmur3 fmix64)
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * @brief Flat open-addressing hash table that counts words.
+ *
+ * Each slot stores the full hash, the count and the position of the word in
+ * a contiguous arena, so a lookup touches one slot and only reads the word
+ * bytes when the hashes already match. Words are copied into the arena the
+ * first time they are seen and never again.
+ */
+class WordCounter {
+public:
+    /**
+     * @brief A counted word; the view points into the counter's arena.
+     */
+    struct Entry {
+        std::string_view word;
+        std::uint64_t count;
+    };
+
+    /**
+     * @brief Stable reference to a counted word: where its bytes sit in the arena, and its number.
+     *
+     * Unlike a view, it stays valid while the counter grows. Words are
+     * numbered 0, 1, 2, ... in order of first appearance, so callers can
+     * keep per-word data in a flat array indexed by id.
+     */
+    struct WordRef {
+        std::uint64_t offset;
+        std::uint32_t length;
+        std::uint32_t id;
+    };
+
+    /**
+     * @brief What addCounted did: the word's count right after the add, and the word.
+     */
+    struct Added {
+        std::uint64_t count;
+        WordRef word;
+    };
+
+    /**
+     * @brief Creates an empty counter.
+     * @param expectedWords Number of distinct words to size the table for.
+     */
+    explicit WordCounter(std::size_t expectedWords = 1024);
+
+    /**
+     * @brief Adds occurrences of a word whose hash is already known.
+     * @param word The word to count.
+     * @param hash hashWord(word).
+     * @param n Number of occurrences to add.
+     */
+    void addHashed(std::string_view word, std::uint64_t hash, std::uint64_t n = 1) { addCounted(word, hash, n); }
+
+    /**
+     * @brief Adds occurrences of a word and reports its new count, for callers that track counts as they change.
+     * @param word The word to count.
+     * @param hash hashWord(word).
+     * @param n Number of occurrences to add (0 adds nothing and reports count 0).
+     * @return The word's count after the add (n for a new word) and its reference.
+     */
+    Added addCounted(std::string_view word, std::uint64_t hash, std::uint64_t n = 1);
+
+    /**
+     * @brief Adds occurrences of a word.
+     */
+    void add(std::string_view word, std::uint64_t n = 1) { addHashed(word, hashWord(word), n); }
+
+    /**
+     * @brief Adds every word of another counter to this one.
+     */
+    void merge(const WordCounter& other);
+
+    /**
+     * @brief Joins counters that have no word in common into one.
+     *
+     * Since no two parts share a word, the slots are only moved into a
+     * table sized for all of them and the arenas are appended: no word is
+     * compared or hashed again, and the table never grows. Ids are
+     * renumbered part after part.
+     * @param parts Counters with disjoint words, e.g. the hash shards of mergeSharded.
+     * @return Counter holding every word of every part.
+     */
+    static WordCounter concatenate(const std::vector<WordCounter>& parts);
+
+    /**
+     * @brief Returns how many times a word was counted (0 if never).
+     */
+    std::uint64_t count(std::string_view word) const;
+
+    /**
+     * @brief Looks up a word whose hash is already known.
+     * @param word The word.
+     * @param hash hashWord(word).
+     * @param ref Receives the word's reference, e.g. its id, if it was counted.
+     * @return false if the word was never counted.
+     */
+    bool findHashed(std::string_view word, std::uint64_t hash, WordRef& ref) const;
+
+    /**
+     * @brief Looks up a word; see findHashed.
+     */
+    bool find(std::string_view word, WordRef& ref) const { return findHashed(word, hashWord(word), ref); }
+
+    /**
+     * @brief Number of distinct words.
+     */
+    std::size_t size() const { return size_; }
+
+    /**
+     * @brief Number of words counted, including repeats.
+     */
+    std::uint64_t totalCount() const { return total_; }
+
+    /**
+     * @brief Calls fn(std::string_view word, std::uint64_t count) for every distinct word.
+     *
+     * The order is the table order, which is not meaningful.
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const Slot& slot : slots_) {
+            if (slot.count != 0) {
+                fn(wordAt(slot), slot.count);
+            }
+        }
+    }
+
+    /**
+     * @brief Calls fn(WordRef word, std::uint64_t count) for every distinct word, in table order.
+     */
+    template <typename Fn>
+    void forEachRef(Fn&& fn) const {
+        for (const Slot& slot : slots_) {
+            if (slot.count != 0) {
+                fn(WordRef{slot.offset, slot.length, slot.id}, slot.count);
+            }
+        }
+    }
+
+    /**
+     * @brief The word a reference stands for; the view is valid until the next add.
+     */
+    std::string_view word(WordRef ref) const { return std::string_view(arena_.data() + ref.offset, ref.length); }
+
+    /**
+     * @brief Calls fn(std::string_view word, std::uint64_t hash, std::uint64_t count) for every distinct word.
+     *
+     * Hands out the stored hash so callers can partition words without rehashing them.
+     */
+    template <typename Fn>
+    void forEachHashed(Fn&& fn) const {
+        for (const Slot& slot : slots_) {
+            if (slot.count != 0) {
+                fn(wordAt(slot), slot.hash, slot.count);
+            }
+        }
+    }
+
+    /**
+     * @brief All distinct words with their counts, in table order.
+     */
+    std::vector<Entry> entries() const;
+
+    /**
+     * @brief Bytes used by the table and the word arena.
+     */
+    std::size_t memoryUsage() const;
+
+    /**
+     * @brief Shape of the hash table, for profiling.
+     *
+     * A word's probe length is the number of slots a lookup reads to find
+     * it: one more than its distance from its home slot.
+     */
+    struct ProbeStats {
+        std::size_t capacity = 0;         ///< Number of slots.
+        double loadFactor = 0;            ///< Occupied slots over capacity.
+        double meanProbeLength = 0;       ///< Average over distinct words.
+        double weightedProbeLength = 0;   ///< Average over tokens, i.e. weighted by count.
+        std::size_t maxProbeLength = 0;   ///< Longest probe of any word.
+    };
+
+    /**
+     * @brief Measures probe lengths by walking the table once.
+     *
+     * Nothing is recorded while counting, so the hot path pays nothing for it.
+     */
+    ProbeStats probeStats() const;
+
+private:
+    // 64-bit offset: the arena of a large crawl passes 4 GiB, where a 32-bit
+    // offset would wrap. A single word stays far below 4 GiB, so its length
+    // shares 8 bytes with its number and a slot is 32 bytes, two per cache line.
+    struct Slot {
+        std::uint64_t hash;
+        std::uint64_t count;   // 0 marks an empty slot
+        std::uint64_t offset;  // position of the word in arena_
+        std::uint32_t length;
+        std::uint32_t id;      // order of first appearance
+    };
+
+    std::string_view wordAt(const Slot& slot) const {
+        return std::string_view(arena_.data() + slot.offset, slot.length);
+    }
+
+    void grow();
+
+    // The slot holding a word, or nullptr.
+    const Slot* lookup(std::string_view word, std::uint64_t hash) const;
+
+    std::vector<Slot> slots_;
+    std::vector<char> arena_;
+    std::size_t mask_ = 0;
+    std::size_t size_ = 0;
+    std::uint64_t total_ = 0;
+};
+
+// Kept in the header so the probe loop inlines into the tokenizer callbacks.
+inline WordCounter::Added WordCounter::addCounted(std::string_view word, std::uint64_t hash, std::uint64_t n) {
+    if (n == 0) {
+        return Added{0, WordRef{0, 0, 0}};
+    }
+    total_ += n;
+    std::size_t i = hash & mask_;
+    while (true) {
+        Slot& slot = slots_[i];
+        if (slot.count == 0) {
+            break;
+        }
+        if (slot.hash == hash && slot.length == word.size() &&
+            std::memcmp(arena_.data() + slot.offset, word.data(), word.size()) == 0) {
+            slot.count += n;
+            return Added{slot.count, WordRef{slot.offset, slot.length, slot.id}};
+        }
+        i = (i + 1) & mask_;
+    }
+
+    // new word: intern its bytes and claim the empty slot
+    Slot& slot = slots_[i];
+    slot.hash = hash;
+    slot.count = n;
+    slot.offset = arena_.size();
+    slot.length = static_cast<std::uint32_t>(word.size());
+    slot.id = static_cast<std::uint32_t>(size_);
+    arena_.insert(arena_.end(), word.begin(), word.end());
+    ++size_;
+    Added added{n, WordRef{slot.offset, slot.length, slot.id}};
+    // keep the load factor under 3/4 so probe sequences stay short
+    if (size_ * 4 > slots_.size() * 3) {
+        grow();
+    }
+    return added;
+}
+
+} // namespace corpus
+
+#endif // WORD_COUNTER_H
@@ -0,0 +1,293 @@
+#ifndef WORD_ENGINE_H
+#define WORD_ENGINE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "ArabicNormalization.h"
+#include "MappedFile.h"
+#include "StringSort.h"
+#include "Tokenizer.h"
+#include "WordCounter.h"
+
+namespace corpus {
+
+// Encoding policies: which bytes make up a word and how it is folded. Each
+// provides isWordByte(char), true for every byte a word may contain (text
+// can be cut anywhere else), and forEachWord(text, onWord), handing out the
+// words as the counters see them. Everything is static and inline, so the
+// classification and folding compile into the caller's loop.
+
+/**
+ * @brief Runs of ASCII letters, lowercased (ZipF, ZipF2).
+ */
+struct AsciiText {
+    static bool isWordByte(char c) { return isAsciiLetter(c); }
+
+    template <typename OnWord>
+    static void forEachWord(std::string_view text, OnWord&& onWord) {
+        // the kernel hands out words already lowercased
+        forEachFoldedAsciiWord(text, onWord);
+    }
+};
+
+/**
+ * @brief Runs of Latin-1 letters, accented ones included, lowercased.
+ */
+struct Latin1Text {
+    static bool isWordByte(char c) { return isLatin1Letter(c); }
+
+    template <typename OnWord>
+    static void forEachWord(std::string_view text, OnWord&& onWord) {
+        forEachFoldedLatin1Word(text, onWord);
+    }
+};
+
+/**
+ * @brief Runs of U+0600..U+06FF characters, kept as UTF-8 bytes (Arabic).
+ */
+struct ArabicText {
+    static bool isWordByte(char c) { return isArabicWordByte(c); }
+
+    template <typename OnWord>
+    static void forEachWord(std::string_view text, OnWord&& onWord) {
+        forEachArabicWord(text, onWord);
+    }
+};
+
+/**
+ * @brief As ArabicText, with diacritics and tatweel dropped and alef variants folded.
+ */
+struct NormalizedArabicText {
+    static bool isWordByte(char c) { return isArabicWordByte(c); }
+
+    template <typename OnWord>
+    static void forEachWord(std::string_view text, OnWord&& onWord) {
+        // normalized in the tokenizing pass, the variants never reach the table
+        std::string folded;
+        forEachArabicWord(text, [&](std::string_view word) {
+            foldArabicWord(word, folded);
+            if (!folded.empty()) {
+                onWord(std::string_view(folded));
+            }
+        });
+    }
+};
+
+// Counting policies: add(word) for every token, finish() once after the
+// last, then size(), totalCount() and forEach(fn(std::string_view word,
+// std::uint64_t count)) over the distinct words.
+
+/**
+ * @brief Counts in the flat hash table; the fastest, and what the tools use.
+ */
+class HashCounting {
+public:
+    void add(std::string_view word) { counter_.add(word); }
+    void finish() {}
+    std::size_t size() const { return counter_.size(); }
+    std::uint64_t totalCount() const { return counter_.totalCount(); }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        counter_.forEach(fn);
+    }
+
+    /**
+     * @brief The table itself, for the ranking and statistics stages.
+     */
+    const WordCounter& table() const { return counter_; }
+
+private:
+    WordCounter counter_;
+};
+
+/**
+ * @brief Counts in an ordered map, one node per word; words come out in byte order.
+ */
+class MapCounting {
+public:
+    void add(std::string_view word) {
+        ++total_;
+        auto it = counts_.lower_bound(word);
+        if (it != counts_.end() && it->first == word) {
+            ++it->second;
+        } else {
+            counts_.emplace_hint(it, std::string(word), 1);
+        }
+    }
+    void finish() {}
+    std::size_t size() const { return counts_.size(); }
+    std::uint64_t totalCount() const { return total_; }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& [word, count] : counts_) {
+            fn(std::string_view(word), count);
+        }
+    }
+
+private:
+    std::map<std::string, std::uint64_t, std::less<>> counts_;
+    std::uint64_t total_ = 0;
+};
+
+/**
+ * @brief Keeps every token, then sorts them and counts the runs; words come out in byte order.
+ *
+ * The tokens are packed into large blocks rather than one string each, and
+ * sortAndCountRuns sorts views of them with a radix sort that counts the
+ * runs as it goes.
+ */
+class SortCounting {
+public:
+    /**
+     * @param threads Threads for the sort (0 means all hardware threads).
+     * @param textBytes Size of the text to be counted, if known; the token
+     *        storage is then reserved once instead of grown (only the pages
+     *        actually used are ever touched).
+     */
+    explicit SortCounting(unsigned threads = 1, std::size_t textBytes = 0) : threads_(threads) {
+        if (textBytes > 0) {
+            // a token and its separator take at least 2 bytes, and real text averages over 4
+            tokens_.reserve(textBytes / 4);
+            blocks_.emplace_back(new char[textBytes]);  // left uninitialized, unlike make_unique
+            blockEnd_ = blocks_.back().get();
+            blockLeft_ = textBytes;
+        }
+    }
+
+    void add(std::string_view word) {
+        if (word.size() > blockLeft_) {
+            std::size_t size = std::max(blockSize, word.size());
+            blocks_.emplace_back(new char[size]);
+            blockEnd_ = blocks_.back().get();
+            blockLeft_ = size;
+        }
+        std::copy(word.begin(), word.end(), blockEnd_);
+        tokens_.emplace_back(blockEnd_, word.size());
+        blockEnd_ += word.size();
+        blockLeft_ -= word.size();
+    }
+
+    void finish() {
+        total_ = tokens_.size();
+        runs_ = sortAndCountRuns(tokens_, threads_);
+        std::vector<std::string_view>().swap(tokens_);
+    }
+
+    std::size_t size() const { return runs_.size(); }
+    std::uint64_t totalCount() const { return total_; }
+
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const WordCounter::Entry& run : runs_) {
+            fn(run.word, run.count);
+        }
+    }
+
+private:
+    static constexpr std::size_t blockSize = 1 << 20;
+
+    unsigned threads_;
+    std::vector<std::unique_ptr<char[]>> blocks_;  // the token bytes; moving the counter keeps them in place
+    char* blockEnd_ = nullptr;
+    std::size_t blockLeft_ = 0;
+    std::vector<std::string_view> tokens_;
+    std::vector<WordCounter::Entry> runs_;
+    std::uint64_t total_ = 0;
+};
+
+/**
+ * @brief Word counting specialized at compile time for an encoding and a counter.
+ *
+ * Replaces the readBook / computeWordFrequency / countUniqueWords trio that
+ * every tool used to carry: each tool names its engine, e.g.
+ * WordEngine<AsciiText> or WordEngine<ArabicText, SortCounting>, and the
+ * tokenizer, folding and counter inline into one loop with no virtual or
+ * locale calls. The runtime Script dispatch of forEachWord uses the same
+ * encoding policies, so the tools' parallel and streaming paths share them.
+ * @tparam Encoding AsciiText, Latin1Text, ArabicText or NormalizedArabicText.
+ * @tparam Counting HashCounting, MapCounting or SortCounting.
+ */
+template <typename Encoding, typename Counting = HashCounting>
+class WordEngine {
+public:
+    /**
+     * @brief A word and its frequency.
+     */
+    using WordFrequency = std::pair<std::string, std::uint64_t>;
+
+    /**
+     * @brief Calls onWord for every word of text, folded as the counters see it.
+     */
+    template <typename OnWord>
+    static void forEachWord(std::string_view text, OnWord&& onWord) {
+        Encoding::forEachWord(text, onWord);
+    }
+
+    /**
+     * @brief Counts every word of text.
+     * @param text Raw text, e.g. the view of a MappedFile.
+     * @param counts An empty counter to fill, e.g. a SortCounting with its thread count.
+     * @return The finished counter.
+     */
+    static Counting count(std::string_view text, Counting counts = Counting()) {
+        Encoding::forEachWord(text, [&](std::string_view word) { counts.add(word); });
+        counts.finish();
+        return counts;
+    }
+
+    /**
+     * @brief Number of distinct words of text.
+     */
+    static std::size_t uniqueWords(std::string_view text) { return count(text).size(); }
+
+    /**
+     * @brief Ranks counted words, most frequent first and ties in byte order.
+     */
+    static std::vector<WordFrequency> rank(const Counting& counts) {
+        std::vector<WordFrequency> ranked;
+        ranked.reserve(counts.size());
+        counts.forEach([&](std::string_view word, std::uint64_t count) { ranked.emplace_back(word, count); });
+        std::sort(ranked.begin(), ranked.end(), [](const WordFrequency& a, const WordFrequency& b) {
+            return a.second != b.second ? a.second > b.second : a.first < b.first;
+        });
+        return ranked;
+    }
+
+    /**
+     * @brief Counts and ranks every word of text.
+     */
+    static std::vector<WordFrequency> frequencies(std::string_view text) { return rank(count(text)); }
+
+    /**
+     * @brief Reads a file and keeps only its words, folded, each followed by one space.
+     *
+     * For callers that want the cleaned text itself; counting goes straight
+     * from the mapping and never needs this copy.
+     * @param fileName Path of the file.
+     * @return The words of the file (empty if it cannot be read).
+     */
+    static std::vector<char> readBook(const std::string& fileName) {
+        MappedFile file(fileName);
+        std::vector<char> book;
+        book.reserve(file.size());
+        Encoding::forEachWord(file.view(), [&](std::string_view word) {
+            book.insert(book.end(), word.begin(), word.end());
+            book.push_back(' ');
+        });
+        return book;
+    }
+};
+
+} // namespace corpus
+
+#endif // WORD_ENGINE_H
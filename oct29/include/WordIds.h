@@ -0,0 +1,110 @@
+#ifndef WORD_IDS_H
+#define WORD_IDS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include "WordCounter.h"
+
+namespace corpus {
+
+/**
+ * @brief Interns words as dense 32-bit IDs (0, 1, 2, ... in order of first appearance).
+ *
+ * A flat open-addressing table maps each word to its ID; the words
+ * themselves sit back to back in one arena, so word(id) is two array reads.
+ * Later stages can then work on integers instead of strings.
+ */
+class WordIds {
+public:
+    /**
+     * @brief Creates an empty dictionary.
+     * @param expectedWords Number of distinct words to size the table for.
+     */
+    explicit WordIds(std::size_t expectedWords = 1024);
+
+    /**
+     * @brief Returns the ID of a word whose hash is already known, assigning the next one if it is new.
+     * @param word The word.
+     * @param hash hashWord(word).
+     */
+    std::uint32_t idHashed(std::string_view word, std::uint64_t hash);
+
+    /**
+     * @brief Returns the ID of a word, assigning the next one if it is new.
+     */
+    std::uint32_t id(std::string_view word) { return idHashed(word, hashWord(word)); }
+
+    /**
+     * @brief Looks a word up without adding it.
+     * @return true and the ID in id if the word is known.
+     */
+    bool find(std::string_view word, std::uint32_t& id) const;
+
+    /**
+     * @brief The word with the given ID; the view points into the arena.
+     */
+    std::string_view word(std::uint32_t id) const {
+        std::uint64_t begin = id == 0 ? 0 : ends_[id - 1];
+        return std::string_view(arena_.data() + begin, ends_[id] - begin);
+    }
+
+    /**
+     * @brief Number of distinct words, which is also the next ID.
+     */
+    std::size_t size() const { return ends_.size(); }
+
+    /**
+     * @brief Bytes used by the table, the arena and the word offsets.
+     */
+    std::size_t memoryUsage() const;
+
+private:
+    struct Slot {
+        std::uint64_t hash;
+        std::uint32_t id;  // ID + 1, 0 marks an empty slot
+    };
+
+    void grow();
+
+    std::vector<Slot> slots_;
+    // end of each word in arena_, by ID; 64-bit, as a large vocabulary's arena passes 4 GiB
+    std::vector<std::uint64_t> ends_;
+    std::vector<char> arena_;
+    std::size_t mask_ = 0;
+};
+
+// Kept in the header so the probe loop inlines into the tokenizer callbacks.
+inline std::uint32_t WordIds::idHashed(std::string_view word, std::uint64_t hash) {
+    std::size_t i = hash & mask_;
+    while (true) {
+        const Slot& slot = slots_[i];
+        if (slot.id == 0) {
+            break;
+        }
+        if (slot.hash == hash) {
+            std::string_view known = this->word(slot.id - 1);
+            if (known.size() == word.size() && std::memcmp(known.data(), word.data(), word.size()) == 0) {
+                return slot.id - 1;
+            }
+        }
+        i = (i + 1) & mask_;
+    }
+
+    // new word: append it to the arena and claim the empty slot
+    std::uint32_t id = static_cast<std::uint32_t>(ends_.size());
+    arena_.insert(arena_.end(), word.begin(), word.end());
+    ends_.push_back(arena_.size());
+    slots_[i] = Slot{hash, id + 1};
+    // keep the load factor under 3/4 so probe sequences stay short
+    if (ends_.size() * 4 > slots_.size() * 3) {
+        grow();
+    }
+    return id;
+}
+
+} // namespace corpus
+
+#endif // WORD_IDS_H
@@ -0,0 +1,86 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace corpus {
+
+/**
+ * @brief Fixed set of worker threads that balance tasks by stealing.
+ *
+ * Every worker owns a deque. A task submitted from inside a worker goes to
+ * the back of that worker's deque and is popped from the back (the most
+ * recent, still cache-hot work first); an idle worker steals from the front
+ * of another deque, taking the oldest and usually largest pending work.
+ * Tasks submitted from outside the pool are spread round-robin.
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Starts the workers.
+     * @param threads Number of workers (0 means one per hardware thread).
+     */
+    explicit WorkStealingPool(unsigned threads);
+
+    /**
+     * @brief Waits for every pending task, then stops the workers.
+     */
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * @brief Queues a task; tasks may submit further tasks.
+     */
+    void submit(Task task);
+
+    /**
+     * @brief Blocks until every submitted task, including the ones they submitted, has run.
+     */
+    void wait();
+
+    /**
+     * @brief Number of workers.
+     */
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+    /**
+     * @brief Index of the calling worker in [0, size()), or -1 outside the pool.
+     *
+     * Lets tasks keep per-worker state without locking it.
+     */
+    int currentWorker() const;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(unsigned index);
+    bool takeTask(unsigned index, Task& task);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;  // a task was queued, or the pool is stopping
+    std::condition_variable idle_;  // the last pending task finished
+    std::size_t queued_ = 0;        // tasks sitting in a deque, guarded by mutex_
+    std::size_t pending_ = 0;       // tasks queued or running, guarded by mutex_
+    std::size_t nextQueue_ = 0;     // round-robin target for outside submissions, guarded by mutex_
+    bool stop_ = false;
+};
+
+} // namespace corpus
+
+#endif // WORK_STEALING_POOL_H
@@ -3,20 +3,78 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <map>
 #include <set>
 #include <map>
+#include "WordCounter.h"
+#include "CorpusStats.h"
+#include "RankIndex.h"
+#include "FrequencyWriter.h"
+#include "WordEngine.h"
 
 namespace zipF {
 
 /**
- * @brief Reads a text file and extracts only alphabetic characters.
- * Non-alphabetic characters are replaced with spaces.
+ * @brief The counting engine of this tool: runs of ASCII letters, lowercased, in the hash table.
+ */
+using Engine = corpus::WordEngine<corpus::AsciiText>;
+
+/**
+ * @brief Reads a text file and keeps only its words, lowercased, one space after each.
+ * Kept as a wrapper over Engine::readBook; prefer corpus::MappedFile
+ * with the std::string_view overloads below, which skip this copy entirely.
  * @param fileName Name of the text file to read.
  * @return Vector of alphabetic characters from the file with only letters kept.
  */
 std::vector<char> readBook(const std::string& fileName);
 
+/**
+ * @brief Counts every word of raw text in a flat hash table.
+ * - Words are maximal runs of ASCII letters, lowercased before counting.
+ * - This is the counting engine behind computeWordFrequency and countUniqueWords.
+ * @param text Raw book content, e.g. the view of a corpus::MappedFile.
+ * @return Counter holding each distinct word and its frequency.
+ */
+corpus::WordCounter countWords(std::string_view text);
+
+/**
+ * @brief Counts every word of raw text, splitting the work across threads.
+ * Gives exactly the same counts as the serial countWords.
+ * @param text Raw book content.
+ * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+ * @return Counter holding each distinct word and its frequency.
+ */
+corpus::WordCounter countWords(std::string_view text, unsigned threads);
+
+/**
+ * @brief Counts every word of a file or stdin, reading it in fixed-size blocks.
+ * Memory use stays proportional to the vocabulary, not to the size of the input.
+ * @param fileName Path of the text file, or "-" for standard input.
+ * @param blockSize Number of bytes read at a time.
+ * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+ * @param bytesRead If not null, receives the number of bytes read.
+ * @return Counter holding each distinct word and its frequency.
+ */
+corpus::WordCounter countWordsStreaming(const std::string& fileName, std::size_t blockSize, unsigned threads = 1,
+                                        std::uint64_t* bytesRead = nullptr);
+
+/**
+ * @brief Adds every word of raw text to an existing counter.
+ * @param text Raw text; it must not start or end in the middle of a word.
+ * @param counter Counter receiving the lowercased words.
+ */
+void countWordsInto(std::string_view text, corpus::WordCounter& counter);
+
+/**
+ * @brief Counts how often each word appears in raw text.
+ * - Words are maximal runs of ASCII letters, read straight from the text.
+ * - Each word is lowercased before it is counted.
+ * @param text Raw book content, e.g. the view of a corpus::MappedFile.
+ * @return Map with words as keys and their frequencies as values.
+ */
+std::map<std::string, int> computeWordFrequency(std::string_view text);
+
 /**
  * @brief Counts how often each word appears in the text.
  * - It splits the content into words based on spaces.
@@ -26,6 +84,13 @@ std::vector<char> readBook(const std::string& fileName);
  */
 std::map<std::string, int> computeWordFrequency(const std::vector<char>& book);
 
+/**
+ * @brief Counts the number of unique words in raw text.
+ * @param text Raw book content, e.g. the view of a corpus::MappedFile.
+ * @return  The total count of unique words in the text.
+ */
+int countUniqueWords(std::string_view text);
+
 /**
  * @brief Counts the number of unique words in text.
  * @param book Vector of characters representing the book content.
@@ -44,6 +109,14 @@ int countUniqueWords(const std::vector<char>& book);
  */
 std::multimap<int, std::string, std::greater<>> sortFrequencies(const std::map<std::string, int>& frequencies);
 
+/**
+ * @brief Sorts the words of a counter by their frequency, from most to least frequent.
+ * Words with the same frequency are grouped together in alphabetical order.
+ * @param counter Counter filled by countWords.
+ * @return Multimap with frequencies as keys and words as values.
+ */
+std::multimap<int, std::string, std::greater<>> sortFrequencies(const corpus::WordCounter& counter);
+
 /**
  * @brief Writes the sorted frequencies to a file in "rank freq word" format.
  * @param sortedFrequencies A sorted multimap with words and their frequencies, from most to least frequent.
@@ -51,6 +124,37 @@ std::multimap<int, std::string, std::greater<>> sortFrequencies(const std::map<s
  */
 void outputFrequencies(const std::multimap<int, std::string, std::greater<>>& sortedFreq, const std::string& outputFileName) ;
 
+/**
+ * @brief Writes ranked words to a file, by default in "rank freq word" format.
+ *
+ * The table goes through corpus::BufferedWriter, so lines are formatted
+ * into large buffers and written on a background thread.
+ * @param ranks Words in rank order, built from the counter without a multimap.
+ * @param outputFileName Name of the output file to save.
+ * @param format Text, TSV, CSV or binary columnar layout.
+ */
+void outputFrequencies(const corpus::RankIndex& ranks, const std::string& outputFileName,
+                       corpus::OutputFormat format = corpus::OutputFormat::Text);
+
+/**
+ * @brief Plots frequency against rank on a log-log scale, with fitted Zipf and Zipf-Mandelbrot curves.
+ *
+ * The ranks are log-binned to a few hundred points first, so the plot stays
+ * fast for millions of words. Without plotFile the chart is shown in a
+ * window; with a .svg file it is drawn without Matplot++, with a .png file
+ * Matplot++ renders it quietly. Either way the fitted curve is also written
+ * next to the image as CSV.
+ * @param ranks Words in rank order.
+ * @param plotFile Image to write instead of showing a window (empty to show it).
+ */
+void plotFrequencies(const corpus::RankIndex& ranks, const std::string& plotFile = "");
+
+/**
+ * @brief Prints the first words that occur only once (hapax legomena) and how many there are.
+ * @param stats Statistics of the book; its hapax list is already collected, so nothing is scanned.
+ */
+void printHapaxLegomena(const corpus::CorpusStats& stats);
+
 /**
  * @brief Prints words that occur only once (hapax legomena) in the sorted frequency list.
  * @param sortedFrequencies A sorted multimap with words and their frequencies.
@@ -1,8 +1,9 @@
-#ifndef ZIPF_H
-#define ZIPF_H
+#ifndef ZIPF_2_H
+#define ZIPF_2_H
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <map>
 #include <set>
 #include <algorithm>
@@ -11,22 +12,114 @@
 #include <cctype>
 #include <iostream>
 #include <matplot/matplot.h>
+#include "WordCounter.h"
+#include "CorpusStats.h"
+#include "RankIndex.h"
+#include "FrequencyWriter.h"
+#include "TokenStream.h"
+#include "WordEngine.h"
 
 namespace zipF2 {
 
 // Type alias for word-frequency pairs
 using WordFrequency = std::pair<std::string, int>;
 
+/**
+ * @brief The counting engine of this tool: runs of ASCII letters, lowercased, in the hash table.
+ */
+using Engine = corpus::WordEngine<corpus::AsciiText>;
+
+/**
+ * @brief The same words counted by sorting every token, for computeWordFrequencyBySorting.
+ */
+using SortingEngine = corpus::WordEngine<corpus::AsciiText, corpus::SortCounting>;
+
 /**
  * @brief Reads a book from a file and returns a vector of processed characters.
- *        Only alphabetic characters are retained (converted to lowercase).
- *        Non-alphabetic characters are replaced with spaces.
+ *        Only the words are retained (converted to lowercase), each followed by one space.
  *
  * @param fileName Path to the input text file.
  * @return std::vector<char> Processed characters from the book.
  */
 std::vector<char> readBook(const std::string& fileName);
 
+/**
+ * @brief Computes word frequencies straight from raw text.
+ *        Words are maximal runs of ASCII letters, lowercased before counting.
+ *        Counting is done in a corpus::WordCounter hash table.
+ *
+ * @param text Raw book content, e.g. the view of a corpus::MappedFile.
+ * @return std::vector<WordFrequency> Word-frequency pairs, most frequent first.
+ */
+std::vector<WordFrequency> computeWordFrequency(std::string_view text);
+
+/**
+ * @brief Computes word frequencies from raw text on several threads.
+ *        Gives exactly the same result as the serial computeWordFrequency.
+ *
+ * @param text Raw book content.
+ * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+ * @return std::vector<WordFrequency> Word-frequency pairs, most frequent first.
+ */
+std::vector<WordFrequency> computeWordFrequency(std::string_view text, unsigned threads);
+
+/**
+ * @brief Counts every word of a file or stdin, reading it in fixed-size blocks.
+ *        Memory use stays proportional to the vocabulary, not to the size of the input.
+ *
+ * @param fileName Path of the text file, or "-" for standard input.
+ * @param blockSize Number of bytes read at a time.
+ * @param threads Number of worker threads (1 runs serially, 0 uses all hardware threads).
+ * @param bytesRead If not null, receives the number of bytes read.
+ * @return corpus::WordCounter Counter holding each distinct word and its frequency.
+ */
+corpus::WordCounter countWordsStreaming(const std::string& fileName, std::size_t blockSize, unsigned threads = 1,
+                                        std::uint64_t* bytesRead = nullptr);
+
+/**
+ * @brief Adds every word of raw text to an existing counter.
+ *
+ * @param text Raw text; it must not start or end in the middle of a word.
+ * @param counter Counter receiving the lowercased words.
+ */
+void countWordsInto(std::string_view text, corpus::WordCounter& counter);
+
+/**
+ * @brief Turns a counter into word-frequency pairs, most frequent first.
+ *
+ * @param counter Counter filled by countWordsInto.
+ * @return std::vector<WordFrequency> Word-frequency pairs, ties in alphabetical order.
+ */
+std::vector<WordFrequency> computeWordFrequency(const corpus::WordCounter& counter);
+
+/**
+ * @brief Turns ranked words into word-frequency pairs, keeping the rank order.
+ *
+ * @param ranks Ranked words, e.g. corpus::RankIndex::top for only the head.
+ * @return std::vector<WordFrequency> Word-frequency pairs, most frequent first.
+ */
+std::vector<WordFrequency> computeWordFrequency(const corpus::RankIndex& ranks);
+
+/**
+ * @brief Computes word frequencies from a dictionary-encoded token stream.
+ *        Counts the integer IDs in a dense array; nothing is tokenized again.
+ *
+ * @param tokens Token stream of the book, e.g. loaded from a saved file.
+ * @return std::vector<WordFrequency> Word-frequency pairs, most frequent first.
+ */
+std::vector<WordFrequency> computeWordFrequency(const corpus::TokenStream& tokens);
+
+/**
+ * @brief Computes word frequencies by sorting every word and counting the runs.
+ *        Runs SortingEngine (a radix sort that counts the runs as it sorts);
+ *        gives the same result as computeWordFrequency.
+ *
+ * @param text Raw book content, e.g. the view of a corpus::MappedFile.
+ * @param threads Threads for the sort (0 means all hardware threads).
+ * @return std::vector<WordFrequency> Word-frequency pairs, most frequent first.
+ */
+std::vector<WordFrequency> computeWordFrequencyBySorting(std::string_view text, unsigned threads = 1);
+
 /**
  * @brief Computes word frequencies from the processed book content.
  *
@@ -59,6 +152,16 @@ std::vector<WordFrequency> sortFrequencies(std::vector<WordFrequency>& frequenci
  */
 void outputFrequencies(const std::vector<WordFrequency>& sortedFreq, const std::string& outputFileName);
 
+/**
+ * @brief Writes ranked words to a file through the buffered background writer.
+ *
+ * @param ranks Words in rank order.
+ * @param outputFile Path to the output file.
+ * @param format Text ("rank freq word"), TSV, CSV or binary columnar layout.
+ */
+void writeFrequenciesToFile(const corpus::RankIndex& ranks, const std::string& outputFile,
+                            corpus::OutputFormat format = corpus::OutputFormat::Text);
+
 /**
  * @brief Plots the word frequency distribution on a log-log scale.
  *
@@ -66,6 +169,18 @@ void outputFrequencies(const std::vector<WordFrequency>& sortedFreq, const std::
  */
 void plotFrequencies(const std::vector<WordFrequency>& sortedFreq);
 
+/**
+ * @brief Plots ranked words with fitted Zipf and Zipf-Mandelbrot curves, on screen or to a file.
+ *
+ * The ranks are log-binned to a few hundred points first. A .svg file is
+ * drawn without Matplot++; a .png file is rendered by a quiet Matplot++
+ * figure. The fitted curve is also written next to the image as CSV.
+ *
+ * @param ranks Words in rank order.
+ * @param plotFile Image to write instead of showing a window (empty to show it).
+ */
+void plotFrequencies(const corpus::RankIndex& ranks, const std::string& plotFile = "");
+
 /**
  * @brief Prints the hapax legomena (words that appear only once).
  *
@@ -73,6 +188,13 @@ void plotFrequencies(const std::vector<WordFrequency>& sortedFreq);
  */
 void printHapaxLegomena(const std::vector<WordFrequency>& sortedFreq);
 
-} // namespace zipF
+/**
+ * @brief Prints the hapax legomena collected by the statistics pass.
+ *
+ * @param stats Statistics of the book; nothing is scanned to find the hapaxes.
+ */
+void printHapaxLegomena(const corpus::CorpusStats& stats);
+
+} // namespace zipF2
 
-#endif // ZIPF_H
+#endif // ZIPF_2_H
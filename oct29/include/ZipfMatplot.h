@@ -0,0 +1,42 @@
+#ifndef ZIPF_MATPLOT_H
+#define ZIPF_MATPLOT_H
+
+#include <string>
+#include <matplot/matplot.h>
+#include "ZipfPlot.h"
+
+namespace corpus {
+
+/**
+ * @brief Draws a Zipf chart with Matplot++, for plotZipf.
+ *
+ * Kept inline in its own header so that only the tools built with
+ * Matplot++ (ZipF and ZipF2) include it; the corpus library does not.
+ * With an image file a quiet figure renders straight to it, without
+ * opening a window; otherwise the chart is shown.
+ * @param chart Binned points and fitted curves.
+ * @param title Title of the chart.
+ * @param imageFile Image to write (empty to show a window).
+ */
+inline void drawWithMatplot(const ZipfChart& chart, const std::string& title, const std::string& imageFile) {
+    matplot::figure(!imageFile.empty());
+    matplot::loglog(chart.ranks, chart.frequencies, "r*");
+    matplot::hold(matplot::on);
+    matplot::loglog(chart.ranks, chart.zipfCurve, "b-");
+    matplot::loglog(chart.ranks, chart.mandelbrotCurve, "g--");
+    matplot::legend({"words (log-binned)", "Zipf", "Zipf-Mandelbrot"});
+    matplot::xlabel("Rank");
+    matplot::ylabel("Frequency");
+    matplot::title(title);
+    matplot::grid(matplot::on);
+
+    if (imageFile.empty()) {
+        matplot::show();
+    } else {
+        matplot::save(imageFile);
+    }
+}
+
+} // namespace corpus
+
+#endif // ZIPF_MATPLOT_H
@@ -0,0 +1,158 @@
+#ifndef ZIPF_PLOT_H
+#define ZIPF_PLOT_H
+
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "RankIndex.h"
+
+namespace corpus {
+
+/**
+ * @brief One point of a log-binned rank/frequency curve.
+ */
+struct RankPoint {
+    double rank;        ///< Geometric mean of the first and last rank of the bin.
+    double frequency;   ///< Mean count of the words in the bin.
+    std::size_t words;  ///< Number of ranks merged into the point.
+};
+
+/**
+ * @brief Straight line fitted by ordinary least squares.
+ */
+struct LineFit {
+    double slope = 0;
+    double intercept = 0;
+    double residual = 0;  ///< Sum of squared errors.
+    double rSquared = 0;
+};
+
+/**
+ * @brief Fits y = intercept + slope * x by ordinary least squares.
+ *
+ * Both power-law fits use it in log-log space: Zipf's law on log-binned
+ * ranks and Heaps' law on the vocabulary growth curve.
+ * @param x Abscissas.
+ * @param y Ordinates, as many as x.
+ * @return The line; all zero with fewer than two points or constant x.
+ */
+LineFit leastSquares(const std::vector<double>& x, const std::vector<double>& y);
+
+/**
+ * @brief Parameters of a fitted law f(r) = constant / (r + shift)^exponent.
+ *
+ * Plain Zipf is the case shift = 0; Zipf-Mandelbrot fits the shift too.
+ */
+struct ZipfFit {
+    double exponent = 0;
+    double constant = 0;
+    double shift = 0;
+    double rSquared = 0;  ///< Of the fit in log-log space.
+
+    double predict(double rank) const { return constant / std::pow(rank + shift, exponent); }
+};
+
+/**
+ * @brief Reduces a ranking to a few hundred points evenly spaced in log(rank).
+ *
+ * The first ranks keep a point each; further out, bins grow geometrically,
+ * so millions of ranks plot and fit as fast as a few hundred.
+ * @param ranks Words in rank order.
+ * @param maxPoints Approximate number of bins over the whole rank range.
+ * @return Points in rank order (empty for an empty ranking).
+ */
+std::vector<RankPoint> logBinRanks(const RankIndex& ranks, std::size_t maxPoints = 256);
+
+/**
+ * @brief Fits Zipf's law by least squares on log f = log C - s log r.
+ * @param points Log-binned points, each bin weighing the same.
+ */
+ZipfFit fitZipf(const std::vector<RankPoint>& points);
+
+/**
+ * @brief Fits the Zipf-Mandelbrot law f = C / (r + q)^s.
+ *
+ * For a fixed q the law is linear in log space, so each candidate q is one
+ * least-squares pass over the points; q is then found by golden-section
+ * search on the residual.
+ * @param points Log-binned points, each bin weighing the same.
+ */
+ZipfFit fitZipfMandelbrot(const std::vector<RankPoint>& points);
+
+/**
+ * @brief Writes the binned points with both fitted curves as CSV.
+ *
+ * Columns: rank, frequency, words, zipf, zipf_mandelbrot.
+ * @return false (after printing an error) if the file cannot be written.
+ */
+bool writeFitCsv(const std::string& fileName, const std::vector<RankPoint>& points, const ZipfFit& zipf,
+                 const ZipfFit& mandelbrot);
+
+/**
+ * @brief Draws the binned points and both fitted curves as a log-log SVG chart.
+ *
+ * Needs no plotting library or display.
+ * @return false (after printing an error) if the file cannot be written.
+ */
+bool writePlotSvg(const std::string& fileName, const std::vector<RankPoint>& points, const ZipfFit& zipf,
+                  const ZipfFit& mandelbrot, const std::string& title);
+
+/**
+ * @brief Prints both fits, one line each.
+ */
+void printZipfFits(const ZipfFit& zipf, const ZipfFit& mandelbrot);
+
+/**
+ * @brief Replaces the extension of a plot file, e.g. to put the CSV next to the image.
+ */
+std::string plotSibling(const std::string& plotFile, const std::string& extension);
+
+/**
+ * @brief Bins, fits and exports a ranking without a display.
+ *
+ * Prints both fits, writes the chart to plotFile (which must end in .svg)
+ * and the fitted curve next to it with a .csv extension.
+ * @param ranks Words in rank order.
+ * @param plotFile Path of the SVG chart.
+ * @param title Title of the chart.
+ * @return false (after printing an error) if a file cannot be written.
+ */
+bool exportZipfPlot(const RankIndex& ranks, const std::string& plotFile, const std::string& title);
+
+/**
+ * @brief A log-binned ranking and both fitted laws, as the series a plotting library draws.
+ */
+struct ZipfChart {
+    std::vector<RankPoint> points;        ///< The binned ranking.
+    ZipfFit zipf;
+    ZipfFit mandelbrot;
+    std::vector<double> ranks;            ///< Rank of every point.
+    std::vector<double> frequencies;      ///< Frequency of every point.
+    std::vector<double> zipfCurve;        ///< Zipf's law at every rank.
+    std::vector<double> mandelbrotCurve;  ///< Zipf-Mandelbrot at every rank.
+};
+
+/**
+ * @brief Renders a chart with a plotting library: to imageFile, or in a window when it is empty.
+ */
+using DrawZipfChart = void (*)(const ZipfChart& chart, const std::string& title, const std::string& imageFile);
+
+/**
+ * @brief Plots a ranking for a tool that can also draw through a plotting library.
+ *
+ * A .svg file is exported by exportZipfPlot, without the library. Otherwise
+ * (a .png file, or no file to show a window) the ranks are binned and
+ * fitted, the fits are printed and draw renders the chart; an image file
+ * also gets the fitted curve next to it as CSV.
+ * @param ranks Words in rank order.
+ * @param plotFile Image to write (empty to show a window).
+ * @param title Title of the chart.
+ * @param draw Renders the chart, e.g. drawWithMatplot (ZipfMatplot.h).
+ * @return false (after printing an error) if a file cannot be written.
+ */
+bool plotZipf(const RankIndex& ranks, const std::string& plotFile, const std::string& title, DrawZipfChart draw);
+
+} // namespace corpus
+
+#endif // ZIPF_PLOT_H
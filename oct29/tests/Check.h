@@ -0,0 +1,63 @@
+#ifndef CORPUS_TESTS_CHECK_H
+#define CORPUS_TESTS_CHECK_H
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+namespace corpus::test {
+
+/**
+ * @brief Number of failed checks so far; main returns non-zero if any failed.
+ */
+inline int failures = 0;
+
+/**
+ * @brief Reports a failed check with its place in the source.
+ */
+inline void fail(const char* expression, const char* file, int line) {
+    std::cerr << file << ':' << line << ": check failed: " << expression << std::endl;
+    ++failures;
+}
+
+/**
+ * @brief A scratch directory for the files a test writes, created on first use.
+ *
+ * The first command-line argument names it (ctest passes the build
+ * directory); otherwise it is made under the system temporary directory.
+ */
+inline std::filesystem::path scratchDirectory(int argc = 0, char** argv = nullptr) {
+    static std::filesystem::path directory;
+    if (directory.empty()) {
+        directory = argc > 1 ? std::filesystem::path(argv[1])
+                             : std::filesystem::temp_directory_path() / ("corpus-tests-" + std::to_string(::getpid()));
+        std::filesystem::create_directories(directory);
+    }
+    return directory;
+}
+
+/**
+ * @brief Path of a scratch file.
+ */
+inline std::string scratchFile(const std::string& name) {
+    return (scratchDirectory() / name).string();
+}
+
+/**
+ * @brief Runs one test function and prints its name.
+ */
+template <typename Test>
+void run(const char* name, Test test) {
+    int before = failures;
+    test();
+    std::cout << (failures == before ? "ok   " : "FAIL ") << name << std::endl;
+}
+
+} // namespace corpus::test
+
+#define CHECK(condition) \
+    ((condition) ? static_cast<void>(0) : corpus::test::fail(#condition, __FILE__, __LINE__))
+
+#endif // CORPUS_TESTS_CHECK_H
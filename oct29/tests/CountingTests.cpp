@@ -0,0 +1,174 @@
+// Counting on several threads must find what a serial pass finds, and the
+// frequency spectrum must describe the table whichever path filled it.
+#include "Check.h"
+#include "Counting.h"
+#include "FrequencySpectrum.h"
+#include "ParallelCount.h"
+#include "VocabularyGrowth.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace corpus;
+
+namespace {
+
+// Text whose words come back often enough to make a curve, ending in one long word.
+std::string sampleText() {
+    std::string text;
+    std::uint64_t state = 12345;
+    for (int i = 0; i < 20000; ++i) {
+        state = state * 6364136223846793005u + 1442695040888963407u;
+        text += "w" + std::to_string((state >> 33) % (1 + i / 4));
+        text += i % 17 == 0 ? "\n" : " ";
+    }
+    text += std::string(20000, 'z');
+    return text;
+}
+
+bool sameCurve(const std::vector<HeapsPoint>& a, const std::vector<HeapsPoint>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (a[i].tokens != b[i].tokens || a[i].vocabulary != b[i].vocabulary) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void shardedMerge() {
+    std::string text = sampleText();
+    WordCounter serial = countWords(text, Script::Ascii);
+    std::vector<std::string_view> chunks = splitAtWordBoundaries(text, 5, wordBytePredicate(Script::Ascii));
+    std::vector<WordCounter> partials(chunks.size() + 1);  // the last one stays empty
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        countWordsInto(Script::Ascii, chunks[i], partials[i]);
+    }
+    for (unsigned threads : {1u, 3u, 8u}) {
+        WordCounter merged = mergeSharded(partials, threads);
+        CHECK(merged.size() == serial.size());
+        CHECK(merged.totalCount() == serial.totalCount());
+        bool same = true;
+        std::vector<bool> seen(merged.size(), false);
+        merged.forEachRef([&](WordCounter::WordRef ref, std::uint64_t count) {
+            same = same && serial.count(merged.word(ref)) == count && ref.id < seen.size() && !seen[ref.id];
+            if (ref.id < seen.size()) {
+                seen[ref.id] = true;
+            }
+        });
+        CHECK(same);  // every count matches and the ids are 0..size-1
+        CHECK(merged.count("w0") == serial.count("w0"));  // lookups find the moved slots
+    }
+}
+
+void heapsCurveInMemory() {
+    std::string text = sampleText();
+    VocabularyGrowth serial;
+    WordCounter counter = countWords(text, Script::Ascii, 1, &serial);
+    for (unsigned threads : {2u, 4u, 7u}) {
+        VocabularyGrowth parallel;
+        countWords(text, Script::Ascii, threads, &parallel);
+        CHECK(sameCurve(serial.points(), parallel.points()));
+    }
+    CHECK(!serial.points().empty() && serial.points().back().tokens == counter.totalCount());
+    CHECK(!serial.points().empty() && serial.points().back().vocabulary == counter.size());
+}
+
+void heapsCurveStreaming() {
+    std::string text = sampleText();
+    std::string file = test::scratchFile("heaps.txt");
+    std::ofstream(file, std::ios::binary) << text;
+
+    VocabularyGrowth expected;
+    WordCounter counter = countWords(text, Script::Ascii, 1, &expected);
+    // small blocks, so the long word is a block of its own that splits into one chunk
+    for (unsigned threads : {1u, 4u}) {
+        VocabularyGrowth growth;
+        std::uint64_t bytes = 0;
+        WordCounter streamed = countWordsStreaming(file, 4096, Script::Ascii, threads, &bytes, &growth);
+        CHECK(bytes == text.size());
+        CHECK(streamed.totalCount() == counter.totalCount());
+        CHECK(sameCurve(growth.points(), expected.points()));
+    }
+}
+
+// The listed words of a class, as sorted strings.
+std::vector<std::string> listedWords(const FrequencySpectrum& spectrum, std::uint64_t m, const WordCounter& counter) {
+    std::vector<std::string> words;
+    for (WordCounter::WordRef word : spectrum.wordsOf(m)) {
+        words.emplace_back(counter.word(word));
+    }
+    std::sort(words.begin(), words.end());
+    return words;
+}
+
+void spectrumOnEveryPath() {
+    std::string text = sampleText();
+    std::string file = test::scratchFile("spectrum.txt");
+    std::ofstream(file, std::ios::binary) << text;
+
+    FrequencySpectrum serial;
+    WordCounter counter = countWords(text, Script::Ascii, 1, nullptr, &serial);
+    // the serial spectrum, fed token by token, matches one recorded from the finished table
+    FrequencySpectrum fromTable;
+    fromTable.recordTable(counter);
+    auto sameAs = [&](const FrequencySpectrum& other, const WordCounter& otherCounter) {
+        bool same = other.vocabularySize() == serial.vocabularySize() && other.tokens() == serial.tokens() &&
+                    other.yulesK() == serial.yulesK();
+        for (std::uint64_t m = 1; m <= FrequencySpectrum::exactLimit; ++m) {
+            same = same && other.wordsWithFrequency(m) == serial.wordsWithFrequency(m);
+        }
+        for (std::uint64_t m = 1; m <= serial.listedClasses(); ++m) {
+            same = same && listedWords(other, m, otherCounter) == listedWords(serial, m, counter);
+        }
+        return same;
+    };
+    CHECK(serial.vocabularySize() == counter.size());
+    CHECK(sameAs(fromTable, counter));
+
+    for (unsigned threads : {1u, 3u}) {
+        FrequencySpectrum parallel;
+        WordCounter parallelCounter = countWords(text, Script::Ascii, threads, nullptr, &parallel);
+        CHECK(sameAs(parallel, parallelCounter));
+        FrequencySpectrum streamed;
+        WordCounter streamedCounter =
+            countWordsStreaming(file, 4096, Script::Ascii, threads, nullptr, nullptr, &streamed);
+        CHECK(sameAs(streamed, streamedCounter));
+    }
+}
+
+void spectrumWideSums() {
+    // counts whose squares pass 2^64, where the sum of squares needs its high half
+    WordCounter counter;
+    std::uint64_t big = std::uint64_t{3} << 40;
+    counter.add("whale", big);
+    counter.add("sea", big + 12345);
+    counter.add("ship", 7);
+    FrequencySpectrum spectrum;
+    spectrum.recordTable(counter);
+    long double n = static_cast<long double>(counter.totalCount());
+    long double squares = static_cast<long double>(big) * big +
+                          static_cast<long double>(big + 12345) * (big + 12345) + 49;
+    double expected = static_cast<double>(1e4L * (squares - n) / (n * n));
+    CHECK(std::fabs(spectrum.yulesK() - expected) <= 1e-9 * expected);
+    CHECK(spectrum.tokens() == counter.totalCount());
+    CHECK(spectrum.wordsWithFrequency(7) == 1);
+    CHECK(spectrum.wordsWithFrequency(big, counter) == 1);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    test::scratchDirectory(argc, argv);
+    test::run("sharded merge", shardedMerge);
+    test::run("heaps curve in memory", heapsCurveInMemory);
+    test::run("heaps curve streaming", heapsCurveStreaming);
+    test::run("spectrum on every path", spectrumOnEveryPath);
+    test::run("spectrum wide sums", spectrumWideSums);
+    return test::failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+// Round trips, appends and damaged headers for the binary formats: the
+// frequency index, the token stream and the columnar table.
+#include "Check.h"
+#include "Counting.h"
+#include "FrequencyIndex.h"
+#include "FrequencyWriter.h"
+#include "RankIndex.h"
+#include "TokenStream.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace corpus;
+
+namespace {
+
+const char* sampleText =
+    "Call me Ishmael. Some years ago - never mind how long precisely - having little or no money in my purse, "
+    "and nothing particular to interest me on shore, I thought I would sail about a little and see the watery "
+    "part of the world. It is a way I have of driving off the spleen and regulating the circulation.";
+
+std::string readFile(const std::string& fileName) {
+    std::ifstream in(fileName, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void writeFile(const std::string& fileName, const std::string& bytes) {
+    std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+// The file with sizeof(T) bytes at offset replaced by value.
+template <typename T>
+std::string patched(std::string bytes, std::size_t offset, T value) {
+    std::memcpy(&bytes[offset], &value, sizeof(value));
+    return bytes;
+}
+
+bool sameCounts(const WordCounter& a, const WordCounter& b) {
+    if (a.size() != b.size() || a.totalCount() != b.totalCount()) {
+        return false;
+    }
+    bool same = true;
+    a.forEach([&](std::string_view word, std::uint64_t count) { same = same && b.count(word) == count; });
+    return same;
+}
+
+void indexRoundTrip() {
+    WordCounter counter = countWords(sampleText, Script::Ascii);
+    std::string file = test::scratchFile("round.idx");
+    CHECK(writeFrequencyIndex(file, counter, Script::Ascii));
+
+    FrequencyIndex index(file);
+    CHECK(index.isOpen());
+    CHECK(index.size() == counter.size());
+    CHECK(index.totalCount() == counter.totalCount());
+    CHECK(index.script() == Script::Ascii);
+    CHECK(index.count("the") == counter.count("the"));
+    CHECK(index.count("ishmael") == 1);
+    CHECK(index.count("whale") == 0);
+    CHECK(sameCounts(index.toCounter(), counter));
+    bool sorted = true;
+    for (std::size_t i = 1; i < index.size(); ++i) {
+        sorted = sorted && index.word(i - 1) < index.word(i);
+    }
+    CHECK(sorted);
+
+    // an empty counter still makes a valid index
+    CHECK(writeFrequencyIndex(test::scratchFile("empty.idx"), WordCounter(), Script::Arabic));
+    FrequencyIndex empty(test::scratchFile("empty.idx"));
+    CHECK(empty.isOpen());
+    CHECK(empty.size() == 0);
+    CHECK(empty.script() == Script::Arabic);
+}
+
+void indexAppend() {
+    std::string file = test::scratchFile("append.idx");
+    std::remove(file.c_str());
+    WordCounter first = countWords("the whale the sea a ship", Script::Ascii);
+    WordCounter second = countWords("the ship sank zebra", Script::Ascii);
+    CHECK(appendToFrequencyIndex(file, first, Script::Ascii));  // creates the index
+    CHECK(appendToFrequencyIndex(file, second, Script::Ascii));
+
+    WordCounter both = countWords("the whale the sea a ship the ship sank zebra", Script::Ascii);
+    FrequencyIndex index(file);
+    CHECK(index.isOpen());
+    CHECK(sameCounts(index.toCounter(), both));
+    CHECK(index.totalCount() == both.totalCount());
+
+    // a text of another script is refused and the index is left as it was
+    std::string before = readFile(file);
+    CHECK(!appendToFrequencyIndex(file, second, Script::Arabic));
+    CHECK(readFile(file) == before);
+    CHECK(!std::filesystem::exists(file + ".tmp"));
+}
+
+void indexCorruptHeader() {
+    std::string good = test::scratchFile("good.idx");
+    CHECK(writeFrequencyIndex(good, countWords(sampleText, Script::Ascii), Script::Ascii));
+    std::string bytes = readFile(good);
+    std::string bad = test::scratchFile("bad.idx");
+    auto opens = [&](const std::string& content) {
+        writeFile(bad, content);
+        return FrequencyIndex(bad).isOpen();
+    };
+
+    CHECK(opens(bytes));
+    CHECK(!opens(patched(bytes, offsetof(IndexHeader, magic), 'X')));
+    CHECK(!opens(patched(bytes, offsetof(IndexHeader, version), std::uint32_t{2})));
+    CHECK(!opens(patched(bytes, offsetof(IndexHeader, byteOrder), std::uint32_t{0x04030201})));
+    CHECK(!opens(patched(bytes, offsetof(IndexHeader, wordCount), std::uint64_t{1} + FrequencyIndex(good).size())));
+    CHECK(!opens(patched(bytes, offsetof(IndexHeader, bytesSize), std::uint64_t{1})));
+    CHECK(!opens(bytes.substr(0, bytes.size() - 1)));
+    CHECK(!opens(bytes.substr(0, sizeof(IndexHeader) - 1)));
+    CHECK(!opens(""));
+
+    // a word count whose sections wrap around 64 bits must not pass the size check
+    std::uint64_t wrapping = std::uint64_t{1} << 63;
+    std::string wrapped = patched(bytes, offsetof(IndexHeader, wordCount), wrapping);
+    wrapped = patched(wrapped, offsetof(IndexHeader, bytesSize),
+                      std::uint64_t{bytes.size() - sizeof(IndexHeader) - sizeof(std::uint64_t)});
+    CHECK(!opens(wrapped));
+}
+
+void tokenStreamRoundTrip() {
+    std::string text;
+    for (int i = 0; i < 50; ++i) {
+        text += sampleText;
+        text += ' ';
+    }
+    TokenStream serial = TokenStream::fromText(text, Script::Ascii, 1);
+    TokenStream threaded = TokenStream::fromText(text, Script::Ascii, 3);
+    CHECK(serial.size() == threaded.size());
+    CHECK(std::equal(serial.begin(), serial.end(), threaded.begin()));
+    CHECK(sameCounts(serial.toCounter(), countWords(text, Script::Ascii)));
+
+    std::string file = test::scratchFile("round.tok");
+    CHECK(serial.save(file));
+    TokenStream loaded;
+    CHECK(TokenStream::load(file, loaded));
+    CHECK(loaded.script() == Script::Ascii);
+    CHECK(loaded.size() == serial.size());
+    CHECK(loaded.bytesProcessed() == text.size());
+    CHECK(std::equal(loaded.begin(), loaded.end(), serial.begin()));
+    CHECK(loaded.vocabulary().size() == serial.vocabulary().size());
+    bool sameWords = true;
+    for (std::uint32_t id = 0; id < serial.vocabulary().size(); ++id) {
+        sameWords = sameWords && loaded.vocabulary().word(id) == serial.vocabulary().word(id);
+    }
+    CHECK(sameWords);
+}
+
+void tokenStreamCorruptHeader() {
+    std::string good = test::scratchFile("good.tok");
+    TokenStream stream = TokenStream::fromText(sampleText, Script::Ascii);
+    CHECK(stream.save(good));
+    std::string bytes = readFile(good);
+    std::string bad = test::scratchFile("bad.tok");
+    auto loads = [&](const std::string& content) {
+        writeFile(bad, content);
+        TokenStream loaded;
+        return TokenStream::load(bad, loaded);
+    };
+
+    CHECK(loads(bytes));
+    CHECK(!loads(patched(bytes, offsetof(TokenHeader, magic), 'X')));
+    CHECK(!loads(patched(bytes, offsetof(TokenHeader, version), std::uint32_t{7})));
+    CHECK(!loads(patched(bytes, offsetof(TokenHeader, byteOrder), std::uint32_t{0x04030201})));
+    CHECK(!loads(patched(bytes, offsetof(TokenHeader, tokenCount), std::uint64_t{stream.size() + 2})));
+    CHECK(!loads(bytes.substr(0, bytes.size() - 1)));
+    CHECK(!loads(""));
+    // a token ID past the dictionary
+    std::size_t firstId = sizeof(TokenHeader) + stream.vocabulary().size() * sizeof(std::uint64_t);
+    CHECK(!loads(patched(bytes, firstId, static_cast<std::uint32_t>(stream.vocabulary().size()))));
+
+    // a token count whose padded size wraps around 64 bits must not pass the size check
+    std::uint64_t idBytes = (stream.size() + stream.size() % 2) * sizeof(std::uint32_t);
+    std::string wrapped = patched(bytes, offsetof(TokenHeader, tokenCount), std::uint64_t{1} << 62);
+    std::uint64_t bytesSize = 0;
+    std::memcpy(&bytesSize, bytes.data() + offsetof(TokenHeader, bytesSize), sizeof(bytesSize));
+    wrapped = patched(wrapped, offsetof(TokenHeader, bytesSize), bytesSize + idBytes);
+    CHECK(!loads(wrapped));
+}
+
+void columnarRoundTrip() {
+    WordCounter counter = countWords(sampleText, Script::Ascii);
+    std::vector<WordCounter::Entry> ranked = rankByFrequency(counter);
+    std::string file = test::scratchFile("ranks.col");
+    CHECK(writeFrequencies(ranked, file, OutputFormat::Columnar));
+
+    std::string bytes = readFile(file);
+    CHECK(bytes.size() >= sizeof(ColumnarHeader));
+    if (bytes.size() < sizeof(ColumnarHeader)) {
+        return;
+    }
+    ColumnarHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    CHECK(std::memcmp(header.magic, "CORPCOL", 8) == 0);
+    CHECK(header.version == 1);
+    CHECK(header.byteOrder == 0x01020304);
+    CHECK(header.rowCount == ranked.size());
+    std::uint64_t rows = header.rowCount;
+    CHECK(bytes.size() == sizeof(header) + (2 * rows + 1) * sizeof(std::uint64_t) + header.bytesSize);
+    if (bytes.size() != sizeof(header) + (2 * rows + 1) * sizeof(std::uint64_t) + header.bytesSize) {
+        return;
+    }
+
+    const char* counts = bytes.data() + sizeof(header);
+    const char* offsets = counts + rows * sizeof(std::uint64_t);
+    const char* words = offsets + (rows + 1) * sizeof(std::uint64_t);
+    bool same = true;
+    for (std::uint64_t row = 0; row < rows; ++row) {
+        std::uint64_t count = 0;
+        std::uint64_t begin = 0;
+        std::uint64_t end = 0;
+        std::memcpy(&count, counts + row * 8, 8);
+        std::memcpy(&begin, offsets + row * 8, 8);
+        std::memcpy(&end, offsets + (row + 1) * 8, 8);
+        same = same && count == ranked[row].count && std::string_view(words + begin, end - begin) == ranked[row].word;
+    }
+    CHECK(same);
+
+    // the text formats carry the same rows
+    CHECK(writeFrequencies(ranked, test::scratchFile("ranks.tsv"), OutputFormat::Tsv));
+    std::string tsv = readFile(test::scratchFile("ranks.tsv"));
+    CHECK(tsv.rfind("rank\tcount\tword\n1\t" + std::to_string(ranked[0].count) + "\t" + std::string(ranked[0].word), 0) == 0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    test::scratchDirectory(argc, argv);
+    test::run("index round trip", indexRoundTrip);
+    test::run("index append", indexAppend);
+    test::run("index corrupt header", indexCorruptHeader);
+    test::run("token stream round trip", tokenStreamRoundTrip);
+    test::run("token stream corrupt header", tokenStreamCorruptHeader);
+    test::run("columnar round trip", columnarRoundTrip);
+    return test::failures == 0 ? 0 : 1;
+}
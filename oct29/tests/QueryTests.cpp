@@ -0,0 +1,178 @@
+// The minimal perfect hash, the rank lookup file and the query protocol.
+#include "Check.h"
+#include "Counting.h"
+#include "FrequencyIndex.h"
+#include "PerfectHash.h"
+#include "QueryServer.h"
+#include "RankIndex.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace corpus;
+
+namespace {
+
+std::vector<std::uint64_t> randomHashes(std::size_t n, std::uint64_t seed) {
+    std::vector<std::uint64_t> hashes;
+    hashes.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        hashes.push_back(hashWord(std::to_string(seed) + ":" + std::to_string(i)));
+    }
+    return hashes;
+}
+
+// Whether every hash has its own slot in [0, n).
+bool isMinimalPerfect(const PerfectHash& hash, const std::vector<std::uint64_t>& hashes) {
+    std::vector<bool> taken(hashes.size(), false);
+    for (std::uint64_t h : hashes) {
+        std::size_t slot = hash.find(h);
+        if (slot >= hashes.size() || taken[slot]) {
+            return false;
+        }
+        taken[slot] = true;
+    }
+    return true;
+}
+
+void perfectHash() {
+    for (std::size_t n : {std::size_t{0}, std::size_t{1}, std::size_t{2}, std::size_t{1000}, std::size_t{200000}}) {
+        std::vector<std::uint64_t> hashes = randomHashes(n, n);
+        PerfectHash hash;
+        CHECK(PerfectHash::build(hashes, hash));
+        CHECK(hash.size() == n);
+        CHECK(isMinimalPerfect(hash, hashes));
+
+        // the serialized words are used in place and give the same slots
+        std::vector<std::uint64_t> words(hash.data(), hash.data() + hash.serializedSize());
+        PerfectHash attached;
+        CHECK(attached.attach(words.data(), words.size()));
+        bool same = true;
+        for (std::uint64_t h : hashes) {
+            same = same && attached.find(h) == hash.find(h);
+        }
+        CHECK(same);
+        if (!words.empty()) {
+            CHECK(!attached.attach(words.data(), words.size() - 1));
+        }
+        // every rank sample is checked, not only the last: a damaged one would give slots past n
+        std::size_t levels = words.size() > 1 ? static_cast<std::size_t>(words[1]) : 0;
+        std::size_t firstSample = 2 + (levels + 1) + (levels > 0 ? static_cast<std::size_t>(words[2 + levels]) : 0);
+        if (firstSample + 2 < words.size()) {
+            std::vector<std::uint64_t> damaged = words;
+            damaged[firstSample + 1] += n;
+            CHECK(!attached.attach(damaged.data(), damaged.size()));
+        }
+    }
+
+    PerfectHash duplicate;
+    CHECK(!PerfectHash::build({1, 2, 3, 2}, duplicate));
+}
+
+std::string answers(const RankLookup& lookup, std::string_view requests, std::size_t* consumed = nullptr) {
+    std::string replies;
+    std::size_t used = answerRequests(lookup, requests, replies);
+    if (consumed != nullptr) {
+        *consumed = used;
+    }
+    return replies;
+}
+
+void rankLookup() {
+    const char* text = "the whale the sea the ship a whale a sea zebra";
+    WordCounter counter = countWords(text, Script::Ascii);
+    std::string index = test::scratchFile("lookup.idx");
+    std::remove(RankLookup::lookupFileName(index).c_str());
+    CHECK(writeFrequencyIndex(index, counter, Script::Ascii));
+
+    RankLookup lookup;
+    CHECK(RankLookup::open(index, lookup));  // builds the lookup file
+    CHECK(std::filesystem::exists(RankLookup::lookupFileName(index)));
+    CHECK(lookup.size() == counter.size());
+    std::vector<WordCounter::Entry> ranked = rankByFrequency(counter);
+    bool same = true;
+    for (std::size_t rank = 1; rank <= ranked.size(); ++rank) {
+        RankLookup::Answer answer = lookup.find(ranked[rank - 1].word);
+        same = same && answer.rank == rank && answer.count == ranked[rank - 1].count &&
+               lookup.wordAt(rank) == ranked[rank - 1].word && lookup.countAt(rank) == ranked[rank - 1].count;
+    }
+    CHECK(same);
+    CHECK(lookup.find("whales").rank == 0);
+    CHECK(lookup.find("").rank == 0);
+
+    // reopened from the file it built
+    RankLookup again;
+    CHECK(RankLookup::open(index, again));
+    CHECK(again.find("the").rank == 1);
+
+    // another index with as many words and tokens must not reuse the lookup file
+    WordCounter swapped = countWords("the whale the sea a ship a whale a sea zebra", Script::Ascii);
+    CHECK(swapped.size() == counter.size() && swapped.totalCount() == counter.totalCount());
+    CHECK(writeFrequencyIndex(index, swapped, Script::Ascii));
+    RankLookup fresh;
+    CHECK(RankLookup::open(index, fresh));
+    CHECK(fresh.find("a").rank == 1);
+    CHECK(fresh.find("a").count == 3);
+    CHECK(fresh.find("the").count == 2);
+}
+
+void protocol() {
+    WordCounter counter = countWords("b a b c b a", Script::Ascii);
+    std::string index = test::scratchFile("protocol.idx");
+    std::remove(RankLookup::lookupFileName(index).c_str());
+    CHECK(writeFrequencyIndex(index, counter, Script::Ascii));
+    RankLookup lookup;
+    CHECK(RankLookup::open(index, lookup));
+
+    CHECK(answers(lookup, "w b\nw a\r\nw zebra\n") == "1 3\n2 2\n0 0\n");
+    CHECK(answers(lookup, "t 2\n") == "2\n1 3 b\n2 2 a\n");
+    CHECK(answers(lookup, "t 99\n") == "3\n1 3 b\n2 2 a\n3 1 c\n");
+    CHECK(answers(lookup, "t 0\n") == "0\n");
+    CHECK(answers(lookup, "s\n") == "3 6\n");
+    CHECK(answers(lookup, "x\n\n") == "error unknown request\nerror unknown request\n");
+    CHECK(answers(lookup, "t abc\nt -5\nt 2x\nt \n") ==
+          "error invalid count\nerror invalid count\nerror invalid count\nerror invalid count\n");
+    CHECK(answers(lookup, "t 99999999999999999999999\n") == "3\n1 3 b\n2 2 a\n3 1 c\n");
+
+    // a trailing partial line is left for the next read
+    std::size_t consumed = 0;
+    CHECK(answers(lookup, "w c\nw b", &consumed) == "3 1\n");
+    CHECK(consumed == 4);
+
+    // answering stops at the reply budget and resumes where it stopped
+    std::string requests = "w a\nw b\nw c\n";
+    std::string replies;
+    std::uint64_t answered = 0;
+    consumed = answerRequests(lookup, requests, replies, &answered, 1);
+    CHECK(consumed == 4 && replies == "2 2\n" && answered == 1);
+    consumed += answerRequests(lookup, std::string_view(requests).substr(consumed), replies, &answered);
+    CHECK(consumed == requests.size() && replies == "2 2\n1 3\n3 1\n" && answered == 3);
+}
+
+void topRequestIsCapped() {
+    WordCounter counter;
+    for (std::size_t i = 0; i < maxTopRequest + 10; ++i) {
+        counter.add("w" + std::to_string(i), i + 1);
+    }
+    std::string index = test::scratchFile("large.idx");
+    std::remove(RankLookup::lookupFileName(index).c_str());
+    CHECK(writeFrequencyIndex(index, counter, Script::Ascii));
+    RankLookup lookup;
+    CHECK(RankLookup::open(index, lookup));
+    std::string replies = answers(lookup, "t 18446744073709551615\n");
+    CHECK(replies.rfind(std::to_string(maxTopRequest) + "\n1 ", 0) == 0);
+    CHECK(static_cast<std::size_t>(std::count(replies.begin(), replies.end(), '\n')) == maxTopRequest + 1);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    test::scratchDirectory(argc, argv);
+    test::run("perfect hash", perfectHash);
+    test::run("rank lookup", rankLookup);
+    test::run("protocol", protocol);
+    test::run("top request is capped", topRequestIsCapped);
+    return test::failures == 0 ? 0 : 1;
+}
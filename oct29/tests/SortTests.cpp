@@ -0,0 +1,122 @@
+// sortAndCountRuns against std::sort on random words, and the sort engine
+// against the hash table.
+#include "Check.h"
+#include "CorpusStats.h"
+#include "StringSort.h"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace corpus;
+
+namespace {
+
+// Random words over a small alphabet, so that words share long prefixes and
+// repeat; with high set, bytes above 0x7F too, as UTF-8 Arabic has.
+std::vector<std::string> randomWords(std::mt19937_64& random, std::size_t count, std::size_t maxLength, bool high) {
+    std::vector<std::string> words(count);
+    std::uniform_int_distribution<std::size_t> length(1, maxLength);
+    std::uniform_int_distribution<int> letter(0, 5);
+    for (std::string& word : words) {
+        word.resize(length(random));
+        for (char& c : word) {
+            int l = letter(random);
+            c = static_cast<char>(high && l >= 4 ? 0xD8 + l : 'a' + l);
+        }
+    }
+    return words;
+}
+
+// The runs std::sort finds.
+std::vector<WordCounter::Entry> expectedRuns(std::vector<std::string_view> words) {
+    std::sort(words.begin(), words.end());
+    std::vector<WordCounter::Entry> runs;
+    for (std::string_view word : words) {
+        if (!runs.empty() && runs.back().word == word) {
+            ++runs.back().count;
+        } else {
+            runs.push_back(WordCounter::Entry{word, 1});
+        }
+    }
+    return runs;
+}
+
+bool sameRuns(const std::vector<WordCounter::Entry>& a, const std::vector<WordCounter::Entry>& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const auto& x, const auto& y) {
+        return x.word == y.word && x.count == y.count;
+    });
+}
+
+void sortMatchesStdSort() {
+    std::mt19937_64 random(2701);
+    // sizes around the insertion sort and multikey quicksort cutoffs, then a few large ones
+    std::vector<std::size_t> sizes{0, 1, 2, 3, 15, 16, 17, 100, 1000, 5000, 20000, 300000};
+    for (std::size_t size : sizes) {
+        for (std::size_t maxLength : {std::size_t{3}, std::size_t{12}, std::size_t{40}}) {
+            for (bool high : {false, true}) {
+                std::vector<std::string> words = randomWords(random, size, maxLength, high);
+                std::vector<std::string_view> views(words.begin(), words.end());
+                std::vector<WordCounter::Entry> expected = expectedRuns(views);
+                for (unsigned threads : {1u, 4u}) {
+                    std::vector<std::string_view> sorted = views;
+                    std::vector<WordCounter::Entry> runs = sortAndCountRuns(sorted, threads);
+                    CHECK(sameRuns(runs, expected));
+                    CHECK(std::is_sorted(sorted.begin(), sorted.end()));
+                }
+            }
+        }
+    }
+
+    // one word repeated, and one very long shared prefix
+    std::vector<std::string> same(50000, "whale");
+    std::vector<std::string_view> views(same.begin(), same.end());
+    std::vector<WordCounter::Entry> runs = sortAndCountRuns(views, 2);
+    CHECK(runs.size() == 1 && runs[0].count == same.size());
+    std::vector<std::string> prefixed;
+    for (int i = 0; i < 3000; ++i) {
+        prefixed.push_back(std::string(300, 'p') + std::to_string(i % 977));
+    }
+    views.assign(prefixed.begin(), prefixed.end());
+    CHECK(sameRuns(sortAndCountRuns(views, 1), expectedRuns(views)));
+}
+
+void sortEngineMatchesHash() {
+    std::mt19937_64 random(1851);
+    const std::vector<std::string> asciiLetters{"a", "b", "c", "D", "E", "f"};
+    const std::vector<std::string> arabicLetters{"\u0627", "\u0628", "\u062A", "\u062B", "\u062C", "\u062D"};
+    for (Script script : {Script::Ascii, Script::Arabic}) {
+        const std::vector<std::string>& letters = script == Script::Ascii ? asciiLetters : arabicLetters;
+        std::string text;
+        for (int i = 0; i < 50000; ++i) {
+            for (std::size_t length = 1 + random() % 8; length > 0; --length) {
+                text += letters[random() % letters.size()];
+            }
+            text += random() % 7 == 0 ? ".\n" : " ";
+        }
+        CorpusStats hashed = CorpusStats::fromText(text, script);
+        for (unsigned threads : {1u, 3u}) {
+            CorpusStats sorted = CorpusStats::fromTextBySorting(text, script, threads);
+            CHECK(sorted.totalTokens() == hashed.totalTokens());
+            CHECK(sorted.vocabularySize() == hashed.vocabularySize());
+            CHECK(sorted.bytesProcessed() == text.size());
+            bool same = true;
+            hashed.frequencies().forEach([&](std::string_view word, std::uint64_t count) {
+                same = same && sorted.frequencies().count(word) == count;
+            });
+            CHECK(same);
+            CHECK(sorted.frequencySpectrum().hapaxLegomena() == hashed.frequencySpectrum().hapaxLegomena());
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    test::scratchDirectory(argc, argv);
+    test::run("sort matches std::sort", sortMatchesStdSort);
+    test::run("sort engine matches hash", sortEngineMatchesHash);
+    return test::failures == 0 ? 0 : 1;
+}